@@ -0,0 +1,50 @@
+#include "costmap_registry.h"
+
+#include <mutex>
+#include <unordered_map>
+
+namespace costmap_registry
+{
+namespace
+{
+std::mutex registry_mutex;
+std::unordered_map<std::string, costmap_2d::LayeredCostmap*> registry;
+}  // namespace
+
+void registerCostmap(const std::string& name, costmap_2d::LayeredCostmap* layered_costmap)
+{
+  std::lock_guard<std::mutex> lock(registry_mutex);
+  registry[name] = layered_costmap;
+}
+
+void unregisterCostmap(const std::string& name, const costmap_2d::LayeredCostmap* layered_costmap)
+{
+  std::lock_guard<std::mutex> lock(registry_mutex);
+  auto it = registry.find(name);
+  if (it != registry.end() && it->second == layered_costmap)
+  {
+    registry.erase(it);
+  }
+}
+
+costmap_2d::LayeredCostmap* getCostmap(const std::string& name)
+{
+  std::lock_guard<std::mutex> lock(registry_mutex);
+  auto it = registry.find(name);
+  if (it == registry.end())
+  {
+    return nullptr;
+  }
+  return it->second;
+}
+
+std::string costmapNameFromLayerName(const std::string& layer_name)
+{
+  const size_t last_slash = layer_name.rfind('/');
+  if (last_slash == std::string::npos)
+  {
+    return layer_name;
+  }
+  return layer_name.substr(0, last_slash);
+}
+}  // namespace costmap_registry
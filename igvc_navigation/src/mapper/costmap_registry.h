@@ -0,0 +1,43 @@
+#ifndef SRC_COSTMAP_REGISTRY_H
+#define SRC_COSTMAP_REGISTRY_H
+
+#include <string>
+
+#include <costmap_2d/layered_costmap.h>
+
+namespace costmap_registry
+{
+/**
+ * Process-wide registry of LayeredCostmaps, keyed by costmap name (eg. "global_costmap"). Lets layers of one costmap
+ * read the master grid of another costmap loaded in the same process without going through a topic.
+ */
+
+/**
+ * Registers layered_costmap under name. Registering the same costmap twice is a no-op.
+ * @param name name of the costmap, ie. the namespace the costmap's layers are loaded under
+ * @param layered_costmap costmap to register
+ */
+void registerCostmap(const std::string& name, costmap_2d::LayeredCostmap* layered_costmap);
+
+/**
+ * Removes the costmap registered under name, if it is layered_costmap
+ * @param name name of the costmap
+ * @param layered_costmap costmap to unregister
+ */
+void unregisterCostmap(const std::string& name, const costmap_2d::LayeredCostmap* layered_costmap);
+
+/**
+ * @param name name of the costmap
+ * @return the costmap registered under name, or nullptr if there is none
+ */
+costmap_2d::LayeredCostmap* getCostmap(const std::string& name);
+
+/**
+ * Returns the costmap name from a layer name, ie. "global_costmap/lidar_layer" -> "global_costmap"
+ * @param layer_name fully qualified name of the layer
+ * @return name of the costmap that the layer belongs to
+ */
+std::string costmapNameFromLayerName(const std::string& layer_name);
+}  // namespace costmap_registry
+
+#endif  // SRC_COSTMAP_REGISTRY_H
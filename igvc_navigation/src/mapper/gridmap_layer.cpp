@@ -1,8 +1,9 @@
 #include "gridmap_layer.h"
+#include "costmap_registry.h"
 
 namespace gridmap_layer
 {
-GridmapLayer::GridmapLayer(const std::vector<std::string>& layers) : map_{ layers }
+GridmapLayer::GridmapLayer(const std::vector<std::string>& layers) : layers_{ layers }
 {
   resetDirty();
 }
@@ -12,20 +13,99 @@ GridmapLayer::GridmapLayer()
   resetDirty();
 }
 
+GridmapLayer::~GridmapLayer()
+{
+  if (layered_costmap_ != nullptr)
+  {
+    costmap_registry::unregisterCostmap(costmap_registry::costmapNameFromLayerName(name_), layered_costmap_);
+  }
+}
+
 void GridmapLayer::onInitialize()
 {
   rolling_window_ = layered_costmap_->isRolling();
   enabled_ = true;
+
+  if (rolling_window_ && grid_->recenteringEnabled())
+  {
+    ROS_WARN_STREAM("Recentering is only supported for static window costmaps. Disabling recentering for "
+                    << name_);
+    grid_->disableRecentering();
+  }
+
+  // Expose the master grid so that other costmaps in this process (ie. RollingLayer) can read from it directly
+  costmap_registry::registerCostmap(costmap_registry::costmapNameFromLayerName(name_), layered_costmap_);
+}
+
+void GridmapLayer::initMap(const map::MapConfig& config, const std::string& channel,
+                           const std::string& logodds_layer)
+{
+  if (!config.shared_grid.empty())
+  {
+    grid_ = shared_grid::SharedGrid::acquire(config.shared_grid, config);
+  }
+  shared_ = grid_ != nullptr;
+  if (!shared_)
+  {
+    grid_ = std::make_shared<shared_grid::SharedGrid>(config);
+  }
+  else
+  {
+    channel_prefix_ = channel + "/";
+  }
+
+  map_ = &grid_->map();
+  for (const auto& layer : layers_)
+  {
+    map_->add(layerName(layer), 0.0);
+  }
+  grid_->addChannel(layerName(logodds_layer), config.occupied_threshold, &enabled_);
+  dirty_map_position_ = map_->getPosition();
+}
+
+std::string GridmapLayer::layerName(const std::string& layer) const
+{
+  return channel_prefix_ + layer;
+}
+
+bool GridmapLayer::isShared() const
+{
+  return shared_;
+}
+
+void GridmapLayer::compositeShared(costmap_2d::Costmap2D& master_grid, int min_i, int min_j, int max_i, int max_j)
+{
+  grid_->composite(master_grid, min_i, min_j, max_i, max_j);
+}
+
+std::unique_lock<std::mutex> GridmapLayer::lockMap() const
+{
+  return std::unique_lock<std::mutex>{ grid_->mutex() };
 }
 
 void GridmapLayer::updateBounds(double robot_x, double robot_y, double robot_yaw, double* min_x, double* min_y,
                                 double* max_x, double* max_y)
 {
+  grid_->recenterIfNeeded(robot_x, robot_y);
+
+  std::unique_lock<std::mutex> lock = lockMap();
+  syncDirtyRegion();
+
+  if (shared_)
+  {
+    grid_->requestComposite();
+  }
+
+  if (dirty_min_idx_[0] == std::numeric_limits<int>::max())
+  {
+    return;
+  }
+
   grid_map::Position min_pos;
   grid_map::Position max_pos;
   // min_idx is max_pos since indexes increases going down and right
-  map_.getPosition(dirty_min_idx_, max_pos);
-  map_.getPosition(dirty_max_idx_, min_pos);
+  map_->getPosition(toBufferIndex(dirty_min_idx_), max_pos);
+  map_->getPosition(toBufferIndex(dirty_max_idx_), min_pos);
 
   *min_x = std::min(*min_x, min_pos[0]);
   *max_x = std::max(*max_x, max_pos[0]);
@@ -36,11 +116,16 @@ void GridmapLayer::updateBounds(double robot_x, double robot_y, double robot_yaw
 
 void GridmapLayer::touch(const grid_map::Index& index)
 {
-  dirty_min_idx_[0] = std::min(dirty_min_idx_[0], index[0]);
-  dirty_max_idx_[0] = std::max(dirty_max_idx_[0], index[0]);
+  syncDirtyRegion();
+
+  // The dirty region is tracked in unwrapped indices, so that it stays contiguous after the map has been moved
+  const grid_map::Index unwrapped = toUnwrappedIndex(index);
+
+  dirty_min_idx_[0] = std::min(dirty_min_idx_[0], unwrapped[0]);
+  dirty_max_idx_[0] = std::max(dirty_max_idx_[0], unwrapped[0]);
 
-  dirty_min_idx_[1] = std::min(dirty_min_idx_[1], index[1]);
-  dirty_max_idx_[1] = std::max(dirty_max_idx_[1], index[1]);
+  dirty_min_idx_[1] = std::min(dirty_min_idx_[1], unwrapped[1]);
+  dirty_max_idx_[1] = std::max(dirty_max_idx_[1], unwrapped[1]);
 }
 
 void GridmapLayer::resetDirty()
@@ -54,11 +139,59 @@ std::optional<grid_map::SubmapIterator> GridmapLayer::getDirtyIterator() const
   if (dirty_min_idx_[0] == std::numeric_limits<int>::max())
     return std::nullopt;
 
-  const grid_map::Index& start_index = dirty_min_idx_;
+  const grid_map::Index start_index = toBufferIndex(dirty_min_idx_);
   const int size_x = dirty_max_idx_[0] - dirty_min_idx_[0] + 1;
   const int size_y = dirty_max_idx_[1] - dirty_min_idx_[1] + 1;
   const grid_map::Index buffer_size{ size_x, size_y };
 
-  return grid_map::SubmapIterator{ map_, start_index, buffer_size };
+  return grid_map::SubmapIterator{ *map_, start_index, buffer_size };
+}
+
+bool GridmapLayer::getCostmapIndex(const grid_map::Index& index, const costmap_2d::Costmap2D& costmap,
+                                   size_t& costmap_index) const
+{
+  if (!grid_->recenteringEnabled())
+  {
+    // map_ has the same geometry as costmap and never moves, so the reversed linear index is the costmap index
+    const size_t num_cells = map_->getSize().prod();
+    costmap_index = num_cells - grid_map::getLinearIndexFromIndex(index, map_->getSize(), false) - 1;
+    return true;
+  }
+
+  grid_map::Position position;
+  map_->getPosition(index, position);
+
+  unsigned int mx;
+  unsigned int my;
+  if (!costmap.worldToMap(position.x(), position.y(), mx, my))
+  {
+    return false;
+  }
+  costmap_index = costmap.getIndex(mx, my);
+  return true;
+}
+
+grid_map::Index GridmapLayer::toUnwrappedIndex(const grid_map::Index& buffer_index) const
+{
+  return grid_map::getIndexFromBufferIndex(buffer_index, map_->getSize(), map_->getStartIndex());
+}
+
+grid_map::Index GridmapLayer::toBufferIndex(const grid_map::Index& unwrapped_index) const
+{
+  return grid_map::getBufferIndexFromIndex(unwrapped_index, map_->getSize(), map_->getStartIndex());
+}
+
+void GridmapLayer::syncDirtyRegion()
+{
+  const grid_map::Position& position = map_->getPosition();
+  if (position == dirty_map_position_)
+  {
+    return;
+  }
+  dirty_map_position_ = position;
+
+  const grid_map::Size& size = map_->getSize();
+  dirty_min_idx_ = { 0, 0 };
+  dirty_max_idx_ = { size[0] - 1, size[1] - 1 };
 }
 }  // namespace gridmap_layer
@@ -1,9 +1,16 @@
 #ifndef SRC_GRIDMAP_LAYER_H
 #define SRC_GRIDMAP_LAYER_H
 
+#include <memory>
+#include <mutex>
+
+#include <costmap_2d/costmap_2d.h>
 #include <costmap_2d/layer.h>
 #include <grid_map_ros/grid_map_ros.hpp>
 
+#include "map_config.h"
+#include "shared_grid.h"
+
 namespace gridmap_layer
 {
 class GridmapLayer : public costmap_2d::Layer
@@ -11,6 +18,7 @@ class GridmapLayer : public costmap_2d::Layer
 public:
   GridmapLayer(const std::vector<std::string>& layers);
   GridmapLayer();
+  ~GridmapLayer() override;
 
   void onInitialize() override;
   void updateBounds(double robot_x, double robot_y, double robot_yaw, double* min_x, double* min_y, double* max_x,
@@ -18,15 +26,80 @@ public:
   void updateCosts(costmap_2d::Costmap2D& master_grid, int min_i, int min_j, int max_i, int max_j) override = 0;
 
 protected:
+  /**
+   * Locks map_ against recentering and against the other layers sharing it. Must be held while accessing map_ or the
+   * dirty region, apart from the calls that lock it themselves (GridmapLayer::updateBounds and compositeShared).
+   */
+  [[nodiscard]] std::unique_lock<std::mutex> lockMap() const;
+
   void touch(const grid_map::Index& index);
   void resetDirty();
   std::optional<grid_map::SubmapIterator> getDirtyIterator() const;
 
+  /**
+   * Sets up map_, either as a channel of the shared grid named by config.shared_grid or as a private grid. Must be
+   * called from the constructor of the derived layer once its config has been read.
+   * @param config map config of the layer
+   * @param channel name of the channel, used to prefix the layer names if the grid is shared
+   * @param logodds_layer layer holding the logodds that are composited into the costmap
+   */
+  void initMap(const map::MapConfig& config, const std::string& channel, const std::string& logodds_layer);
+
+  /**
+   * Returns the name of the layer in map_, which is prefixed with the channel name if the grid is shared
+   */
+  [[nodiscard]] std::string layerName(const std::string& layer) const;
+
+  /**
+   * Returns true if map_ is shared with other layers. All channels of a shared grid are composited into the master
+   * grid together by compositeShared, so the layer doesn't need its own costmap_2d.
+   */
+  [[nodiscard]] bool isShared() const;
+
+  /**
+   * Composites all channels of the shared grid into master_grid
+   */
+  void compositeShared(costmap_2d::Costmap2D& master_grid, int min_i, int min_j, int max_i, int max_j);
+
+  /**
+   * Calculates the linear index of the cell in costmap (same resolution as map_) that contains the gridmap cell
+   * @param index buffer index into map_
+   * @param costmap costmap to calculate the index for
+   * @param costmap_index output parameter for the linear costmap index
+   * @return false if the cell is not inside of costmap
+   */
+  bool getCostmapIndex(const grid_map::Index& index, const costmap_2d::Costmap2D& costmap,
+                       size_t& costmap_index) const;
+
+  /**
+   * Converts a buffer index of map_ into an unwrapped index, where (0, 0) is always the top left corner of the map.
+   * Offsets between cells must be calculated in unwrapped indices, since map_ is a circular buffer.
+   */
+  [[nodiscard]] grid_map::Index toUnwrappedIndex(const grid_map::Index& buffer_index) const;
+
+  /**
+   * Converts an unwrapped index of map_ back into a buffer index
+   */
+  [[nodiscard]] grid_map::Index toBufferIndex(const grid_map::Index& unwrapped_index) const;
+
   grid_map::Index dirty_min_idx_;
   grid_map::Index dirty_max_idx_;
-  grid_map::GridMap map_{};
+  grid_map::GridMap* map_ = nullptr;
 
   bool rolling_window_;
+
+private:
+  /**
+   * Marks the whole map as dirty if it has been moved since the dirty region was last updated, since the unwrapped
+   * indices are then stale and the uncovered cells have to be transferred to the costmap
+   */
+  void syncDirtyRegion();
+
+  std::vector<std::string> layers_;
+  std::string channel_prefix_;
+  bool shared_ = false;
+  std::shared_ptr<shared_grid::SharedGrid> grid_;
+  grid_map::Position dirty_map_position_;
 };
 }  // namespace gridmap_layer
 
@@ -1,7 +1,9 @@
 #include "lidar_layer.h"
 #include <mapper/probability_utils.h>
-#include <pcl_ros/transforms.h>
+#include <pcl/common/transforms.h>
+#include <pcl_conversions/pcl_conversions.h>
 #include <pluginlib/class_list_macros.h>
+#include <tf2_eigen/tf2_eigen.h>
 #include "map_config.h"
 
 PLUGINLIB_EXPORT_CLASS(lidar_layer::LidarLayer, costmap_2d::Layer)
@@ -17,15 +19,11 @@ LidarLayer::LidarLayer()
 
 void LidarLayer::initGridmap()
 {
-  // TODO: Configurable start positions
-  map_.setFrameId(config_.map.frame_id);
-  grid_map::Length dimensions{ config_.map.length_x, config_.map.length_y };
-  map_.setGeometry(dimensions, config_.map.resolution);
-  layer_ = &map_.get(logodds_layer);
-  (*layer_).setZero();
+  initMap(config_.map, "lidar", logodds_layer);
+  layer_ = &map_->get(layerName(logodds_layer));
 
   grid_map::Position top_left;
-  map_.getPosition(map_.getStartIndex(), top_left);
+  map_->getPosition(map_->getStartIndex(), top_left);
 }
 
 void LidarLayer::initPubSub()
@@ -43,11 +41,35 @@ void LidarLayer::initPubSub()
 void LidarLayer::onInitialize()
 {
   GridmapLayer::onInitialize();
-  matchCostmapDims(*layered_costmap_->getCostmap());
+  transform_cache_ = std::make_unique<igvc::TransformCache>(tf_, private_nh_);
+  if (!isShared())
+  {
+    matchCostmapDims(*layered_costmap_->getCostmap());
+  }
 }
 
 void LidarLayer::updateCosts(costmap_2d::Costmap2D &master_grid, int min_i, int min_j, int max_i, int max_j)
 {
+  if (isShared())
+  {
+    // The shared grid composites every channel into master_grid at once, so the layer's own costmap is only kept up
+    // to date for its debug topic
+    std::unique_lock<std::mutex> lock = lockMap();
+    if (config_.map.debug.enabled)
+    {
+      matchCostmapDims(master_grid);
+      transferToCostmap();
+      updateProbabilityLayer();
+      debugPublishMap();
+      publishCostmap();
+    }
+    resetDirty();
+    lock.unlock();
+    compositeShared(master_grid, min_i, min_j, max_i, max_j);
+    return;
+  }
+
+  std::unique_lock<std::mutex> lock = lockMap();
   matchCostmapDims(master_grid);
   transferToCostmap();
   if (config_.map.debug.enabled)
@@ -57,6 +79,7 @@ void LidarLayer::updateCosts(costmap_2d::Costmap2D &master_grid, int min_i, int
     publishCostmap();
   }
   resetDirty();
+  lock.unlock();
 
   uchar *master_array = master_grid.getCharMap();
   uchar *line_array = costmap_2d_.getCharMap();
@@ -103,7 +126,7 @@ void LidarLayer::updateProbabilityLayer()
 
   for (auto it = *optional_it; !it.isPastEnd(); ++it)
   {
-    map_.at(probability_layer, *it) = probability_utils::fromLogOdds((*layer_)((*it)[0], (*it)[1]));
+    map_->at(layerName(probability_layer), *it) = probability_utils::fromLogOdds((*layer_)((*it)[0], (*it)[1]));
   }
 }
 
@@ -143,7 +166,7 @@ void LidarLayer::updateRollingWindow()
   grid_map::Position costmap_tl_corner =
       costmap_br_corner + grid_map::Position{ costmap_2d_.getSizeInMetersX(), costmap_2d_.getSizeInMetersY() };
   grid_map::Index start_index;
-  map_.getIndex(costmap_tl_corner, start_index);
+  map_->getIndex(costmap_tl_corner, start_index);
 
   grid_map::Index submap_buffer_size{ costmap_2d_.getSizeInCellsX(), costmap_2d_.getSizeInCellsY() };
 
@@ -154,7 +177,7 @@ void LidarLayer::updateRollingWindow()
 
   // This goes top -> down, left -> right
   // but costmap_2d_ indicies go down -> up, left -> right
-  for (grid_map::SubmapIterator it{ map_, start_index, submap_buffer_size }; !it.isPastEnd(); ++it)
+  for (grid_map::SubmapIterator it{ *map_, start_index, submap_buffer_size }; !it.isPastEnd(); ++it)
   {
     const auto &log_odds = (*layer_)((*it)[0], (*it)[1]);
     float probability = probability_utils::fromLogOdds(log_odds);
@@ -185,8 +208,6 @@ void LidarLayer::updateRollingWindow()
 void LidarLayer::updateStaticWindow()
 {
   // Static window, so we can only update dirty cells
-  size_t num_cells = map_.getSize().prod();
-
   uchar *char_map = costmap_2d_.getCharMap();
 
   auto optional_it = getDirtyIterator();
@@ -200,70 +221,80 @@ void LidarLayer::updateStaticWindow()
   {
     const auto &log_odds = (*layer_)((*it)[0], (*it)[1]);
     float probability = probability_utils::fromLogOdds(log_odds);
-    size_t linear_index = grid_map::getLinearIndexFromIndex(*it, map_.getSize(), false);
+    size_t costmap_index;
+    if (!getCostmapIndex(*it, costmap_2d_, costmap_index))
+    {
+      continue;
+    }
 
     if (probability > config_.map.occupied_threshold)
     {
-      char_map[num_cells - linear_index - 1] = costmap_2d::LETHAL_OBSTACLE;
+      char_map[costmap_index] = costmap_2d::LETHAL_OBSTACLE;
     }
     else
     {
-      char_map[num_cells - linear_index - 1] = costmap_2d::FREE_SPACE;
+      char_map[costmap_index] = costmap_2d::FREE_SPACE;
     }
   }
 }
 
-void LidarLayer::occupiedCallback(const sensor_msgs::PointCloud2ConstPtr &occupied_pc)
+void LidarLayer::occupiedCallback(const PointCloud::ConstPtr &occupied_pc)
 {
   current_ = true;
-  const auto [cloud, transform] = getCloudAndTransform(occupied_pc);
+  const auto cloud_and_transform = getCloudAndTransform(occupied_pc);
+  if (!cloud_and_transform)
+  {
+    return;
+  }
+  const auto &[cloud, transform] = *cloud_and_transform;
+  std::unique_lock<std::mutex> lock = lockMap();
   insertScan(cloud, transform);
-  updateMapTimestamp(occupied_pc->header.stamp);
+  updateMapTimestamp(pcl_conversions::fromPCL(occupied_pc->header.stamp));
 }
 
-void LidarLayer::freeCallback(const sensor_msgs::PointCloud2ConstPtr &free_pc)
+void LidarLayer::freeCallback(const igvc_msgs::polar_scanConstPtr &free_scan)
 {
   current_ = true;
-  const auto [cloud, transform] = getCloudAndTransform(free_pc);
-  insertFreeSpace(cloud, transform);
-  updateMapTimestamp(free_pc->header.stamp);
+  std::optional<geometry_msgs::TransformStamped> transform = transform_cache_->lookupTransform(
+      config_.map.frame_id, free_scan->header.frame_id, free_scan->header.stamp, ros::Duration(1.0));
+  if (!transform)
+  {
+    return;
+  }
+  std::unique_lock<std::mutex> lock = lockMap();
+  insertFreeSpace(*free_scan, *transform);
+  updateMapTimestamp(free_scan->header.stamp);
 }
 
 void LidarLayer::debugPublishMap()
 {
-  map_.setTimestamp(ros::Time::now().toNSec());
+  map_->setTimestamp(ros::Time::now().toNSec());
   grid_map_msgs::GridMap message;
-  grid_map::GridMapRosConverter::toMessage(map_, message);
+  std::vector<std::string> layers{ layerName(logodds_layer), layerName(probability_layer) };
+  grid_map::GridMapRosConverter::toMessage(*map_, layers, message);
   gridmap_pub_.publish(message);
 }
 
-std::pair<pcl::PointCloud<pcl::PointXYZ>, geometry_msgs::TransformStamped>
-LidarLayer::getCloudAndTransform(const sensor_msgs::PointCloud2ConstPtr &pc)
+std::optional<std::pair<pcl::PointCloud<pcl::PointXYZ>, geometry_msgs::TransformStamped>>
+LidarLayer::getCloudAndTransform(const PointCloud::ConstPtr &pc)
 {
   auto map_frame = config_.map.frame_id;
   auto pc_frame = pc->header.frame_id;
-  ros::Time cloud_stamp = pc->header.stamp;
 
   // TODO: Make the timeout a parameter
-  if (!tf_->canTransform(map_frame, pc_frame, cloud_stamp, ros::Duration(1.0)))
+  std::optional<geometry_msgs::TransformStamped> transform = transform_cache_->lookupTransform(
+      map_frame, pc_frame, pcl_conversions::fromPCL(pc->header.stamp), ros::Duration(1.0));
+  if (!transform)
   {
-    ROS_WARN_STREAM_THROTTLE_NAMED(1.0, "pc_transform_timeout",
-                                   "Failed to find transform for pointcloud from frame '"
-                                       << pc_frame << "' to frame '" << map_frame
-                                       << "' within timeout. Using latest transform...");
-    cloud_stamp = ros::Time(0);
+    return std::nullopt;
   }
 
-  sensor_msgs::PointCloud2 transformed_cloud;
-  constexpr double timeout = 0.1;
-  geometry_msgs::TransformStamped transform =
-      tf_->lookupTransform(map_frame, pc_frame, cloud_stamp, ros::Duration(timeout));
-  tf2::doTransform(*pc, transformed_cloud, transform);
-
+  // pc may be shared with the publisher when running in the same process, so it is transformed into a copy
+  const Eigen::Isometry3d map_from_lidar = tf2::transformToEigen(*transform);
   pcl::PointCloud<pcl::PointXYZ> pcl_cloud;
-  pcl::fromROSMsg(transformed_cloud, pcl_cloud);
+  pcl::transformPointCloud(*pc, pcl_cloud, map_from_lidar.matrix().cast<float>());
 
-  return std::make_pair(pcl_cloud, transform);
+  return std::make_pair(pcl_cloud, *transform);
 }
 
 void LidarLayer::insertScan(const LidarLayer::PointCloud &pointcloud,
@@ -273,19 +304,36 @@ void LidarLayer::insertScan(const LidarLayer::PointCloud &pointcloud,
   double lidar_y = lidar_transform.transform.translation.y;
   grid_map::Position lidar_pos{ lidar_x, lidar_y };
 
+  // Bucket the endpoints by cell first, since close obstacles put many points into the same cell and those rays
+  // would all be the same
+  std::unordered_map<grid_map::Index, Endpoint> endpoints{};
+  endpoints.reserve(pointcloud.size());
+  for (const auto &point : pointcloud)
+  {
+    grid_map::Position end_point{ point.x, point.y };
+    grid_map::Index end_index;
+    if (!map_->getIndex(end_point, end_index))
+    {
+      continue;
+    }
+
+    Endpoint &endpoint = endpoints[end_index];
+    endpoint.position_sum += end_point;
+    endpoint.hits++;
+  }
+
   std::unordered_set<grid_map::Index> free_cells{};
   constexpr double free_cells_coeff_estimate = 50;
-  free_cells.reserve(free_cells_coeff_estimate * pointcloud.size());
+  free_cells.reserve(free_cells_coeff_estimate * endpoints.size());
   last_occupied_cells_.clear();
-  last_occupied_cells_.reserve(pointcloud.size());
+  last_occupied_cells_.reserve(endpoints.size());
 
-  for (const auto &point : pointcloud)
+  for (const auto &[end_index, endpoint] : endpoints)
   {
-    grid_map::Position end_point{ point.x, point.y };
-    grid_map::Index end_index;
-    map_.getIndex(end_point, end_index);
+    // The mean of the points in a cell is still inside of that cell
+    const grid_map::Position end_point = endpoint.position_sum / endpoint.hits;
 
-    for (grid_map::LineIterator it{ map_, lidar_pos, end_point }; !it.isPastEnd(); ++it)
+    for (grid_map::LineIterator it{ *map_, lidar_pos, end_point }; !it.isPastEnd(); ++it)
     {
       touch(*it);
       free_cells.emplace(*it);
@@ -296,7 +344,7 @@ void LidarLayer::insertScan(const LidarLayer::PointCloud &pointcloud,
       }
     }
     touch(end_index);
-    markScanHit(end_index, end_point, lidar_pos);
+    markScanHit(end_index, end_point, lidar_pos, endpoint.hits);
     last_occupied_cells_.emplace(end_index);
   }
 
@@ -306,28 +354,35 @@ void LidarLayer::insertScan(const LidarLayer::PointCloud &pointcloud,
   }
 }
 
-void LidarLayer::insertFreeSpace(const PointCloud &pointcloud, const geometry_msgs::TransformStamped &lidar_transform)
+void LidarLayer::insertFreeSpace(const igvc_msgs::polar_scan &free_scan,
+                                 const geometry_msgs::TransformStamped &scan_transform)
 {
-  assert(pointcloud.size() % 2 == 0);
-
-  double lidar_x = lidar_transform.transform.translation.x;
-  double lidar_y = lidar_transform.transform.translation.y;
-  grid_map::Position lidar_pos{ lidar_x, lidar_y };
+  Eigen::Isometry3d sensor_pose;
+  tf2::fromMsg(free_scan.sensor_pose, sensor_pose);
+  const Eigen::Isometry3d sensor_to_map = tf2::transformToEigen(scan_transform) * sensor_pose;
+  const Eigen::Vector3d sensor_pos = sensor_to_map.translation();
 
   std::unordered_set<grid_map::Index> free_cells{};
   constexpr double free_cells_coeff_estimate = 50;
-  free_cells.reserve(free_cells_coeff_estimate * pointcloud.size());
+  free_cells.reserve(free_cells_coeff_estimate * free_scan.free_ranges.size());
 
-  for (size_t i = 0; i < pointcloud.size(); i += 2)
+  for (size_t i = 0; i < free_scan.free_ranges.size(); i++)
   {
-    // points for free space are pairs of (min_range, endpoint)
-    const auto &startpoint = pointcloud.points[i];
-    const auto &endpoint = pointcloud.points[i + 1];
+    const float free_range = free_scan.free_ranges[i];
+    if (std::isnan(free_range))
+    {
+      continue;
+    }
+
+    const double angle = free_scan.start_angle + i * free_scan.angular_resolution;
+    const Eigen::Vector3d direction = sensor_to_map.linear() * Eigen::Vector3d{ std::cos(angle), std::sin(angle), 0.0 };
+    const Eigen::Vector3d startpoint = sensor_pos + free_scan.min_range * direction;
+    const Eigen::Vector3d endpoint = sensor_pos + free_range * direction;
 
-    grid_map::Position startpoint_pos{ startpoint.x, startpoint.y };
-    grid_map::Position endpoint_pos{ endpoint.x, endpoint.y };
+    grid_map::Position startpoint_pos{ startpoint.x(), startpoint.y() };
+    grid_map::Position endpoint_pos{ endpoint.x(), endpoint.y() };
 
-    for (grid_map::LineIterator it{ map_, startpoint_pos, endpoint_pos }; !it.isPastEnd(); ++it)
+    for (grid_map::LineIterator it{ *map_, startpoint_pos, endpoint_pos }; !it.isPastEnd(); ++it)
     {
       // If not occupied, then free
       if (last_occupied_cells_.find(*it) == last_occupied_cells_.end())
@@ -345,18 +400,18 @@ void LidarLayer::insertFreeSpace(const PointCloud &pointcloud, const geometry_ms
 }
 
 void LidarLayer::markScanHit(const grid_map::Index &index, const grid_map::Position &point,
-                             const grid_map::Position &lidar_pos)
+                             const grid_map::Position &lidar_pos, int hits)
 {
   const double distance = (lidar_pos - point).norm();
   const auto coeff = config_.lidar.hit_exponential_coeff;
-  const double probability = std::exp(-coeff * distance) * config_.lidar.scan_hit;
+  const double probability = hits * std::exp(-coeff * distance) * config_.lidar.scan_hit;
 
   (*layer_)(index[0], index[1]) = std::min((*layer_)(index[0], index[1]) + probability, config_.map.max_occupancy);
 }
 
 void LidarLayer::updateMapTimestamp(const ros::Time &stamp)
 {
-  map_.setTimestamp(stamp.toNSec());
+  map_->setTimestamp(stamp.toNSec());
 }
 
 void LidarLayer::initCostTranslationTable()
@@ -1,12 +1,15 @@
 #ifndef SRC_LIDAR_LAYER_H
 #define SRC_LIDAR_LAYER_H
 
+#include <unordered_map>
 #include <unordered_set>
 
 #include <costmap_2d/GenericPluginConfig.h>
 #include <costmap_2d/layer.h>
 #include <costmap_2d/layered_costmap.h>
 
+#include <igvc_msgs/polar_scan.h>
+#include <igvc_utils/transform_cache.h>
 #include <pcl_ros/point_cloud.h>
 #include <grid_map_ros/grid_map_ros.hpp>
 
@@ -43,25 +46,42 @@ private:
 
   std::unordered_set<grid_map::Index> last_occupied_cells_{};
 
+  /**
+   * All points of a scan that end in the same cell
+   */
+  struct Endpoint
+  {
+    grid_map::Position position_sum = grid_map::Position::Zero();
+    int hits = 0;
+  };
+
   costmap_2d::Costmap2D costmap_2d_{};
 
+  std::unique_ptr<igvc::TransformCache> transform_cache_;
+
   void initGridmap();
   void initPubSub();
 
-  void occupiedCallback(const sensor_msgs::PointCloud2ConstPtr& occupied_pc);
-  void freeCallback(const sensor_msgs::PointCloud2ConstPtr& free_pc);
+  void occupiedCallback(const PointCloud::ConstPtr& occupied_pc);
+  void freeCallback(const igvc_msgs::polar_scanConstPtr& free_scan);
 
   void insertScan(const PointCloud& pointcloud, const geometry_msgs::TransformStamped& lidar_transform);
 
-  void insertFreeSpace(const PointCloud& pointcloud, const geometry_msgs::TransformStamped& lidar_transform);
+  /**
+   * Raycasts each free bin of free_scan from min_range to its free range
+   * @param free_scan free space from the pointcloud filter
+   * @param scan_transform transform from the frame of free_scan to the map frame
+   */
+  void insertFreeSpace(const igvc_msgs::polar_scan& free_scan, const geometry_msgs::TransformStamped& scan_transform);
 
   /**
    * Returns a transformed pointcloud, as well as a transform to base_footprint
    * @param pc pointcloud to be transformed
-   * @return a std::pair of the transformed pointcloud and the transform to base_footprint
+   * @return a std::pair of the transformed pointcloud and the transform to base_footprint, or std::nullopt if the
+   * transform isn't available
    */
-  [[nodiscard]] std::pair<PointCloud, geometry_msgs::TransformStamped>
-  getCloudAndTransform(const sensor_msgs::PointCloud2ConstPtr& pc);
+  [[nodiscard]] std::optional<std::pair<PointCloud, geometry_msgs::TransformStamped>>
+  getCloudAndTransform(const PointCloud::ConstPtr& pc);
 
   void updateMapTimestamp(const ros::Time& stamp);
 
@@ -82,7 +102,12 @@ private:
         std::max((*layer_)(index[0], index[1]) + config_.lidar.scan_miss, config_.map.min_occupancy);
   }
 
-  void markScanHit(const grid_map::Index& index, const grid_map::Position& point, const grid_map::Position& lidar_pos);
+  /**
+   * Marks index as hit by hits points around point. This is the same as marking each point on its own, since the sum
+   * is clamped at max_occupancy either way.
+   */
+  void markScanHit(const grid_map::Index& index, const grid_map::Position& point, const grid_map::Position& lidar_pos,
+                   int hits = 1);
 
   inline void markFreeMiss(const grid_map::Index& index)
   {
@@ -29,15 +29,11 @@ LineLayer::LineLayer() : GridmapLayer({ logodds_layer, probability_layer }), pri
 
 void LineLayer::initGridmap()
 {
-  // TODO: Configurable start positions
-  map_.setFrameId(config_.map.frame_id);
-  grid_map::Length dimensions{ config_.map.length_x, config_.map.length_y };
-  map_.setGeometry(dimensions, config_.map.resolution);
-  layer_ = &map_.get(logodds_layer);
-  (*layer_).setZero();
+  initMap(config_.map, "line", logodds_layer);
+  layer_ = &map_->get(layerName(logodds_layer));
 
   grid_map::Position top_left;
-  map_.getPosition(map_.getStartIndex(), top_left);
+  map_->getPosition(map_->getStartIndex(), top_left);
 }
 
 void LineLayer::initPubSub()
@@ -52,8 +48,7 @@ void LineLayer::initPubSub()
   {
     const auto &camera = config_.cameras[i];
     debug_publishers_.emplace_back(
-        DebugPublishers{ nh_.advertise<pcl::PointCloud<pcl::PointXYZ>>(camera.debug.line_topic, 1),
-                         nh_.advertise<pcl::PointCloud<pcl::PointXYZ>>(camera.debug.nonline_topic, 1) });
+        DebugPublishers{ { nh_, camera.debug.line_topic, 1 }, { nh_, camera.debug.nonline_topic, 1 } });
 
     const auto &base_topic = camera.base_topic;
     std::string raw_image_topic = base_topic + camera.topics.raw_image_ns + camera.topics.raw_image;
@@ -78,10 +73,31 @@ void LineLayer::initPubSub()
 void LineLayer::onInitialize()
 {
   GridmapLayer::onInitialize();
+  transform_cache_ = std::make_unique<igvc::TransformCache>(tf_, private_nh_);
 }
 
 void LineLayer::updateCosts(costmap_2d::Costmap2D &master_grid, int min_i, int min_j, int max_i, int max_j)
 {
+  if (isShared())
+  {
+    // The shared grid composites every channel into master_grid at once, so the layer's own costmap is only kept up
+    // to date for its debug topic
+    std::unique_lock<std::mutex> lock = lockMap();
+    if (config_.map.debug.enabled)
+    {
+      matchCostmapDims(master_grid);
+      transferToCostmap();
+      updateProbabilityLayer();
+      debugPublishMap();
+      publishCostmap();
+    }
+    resetDirty();
+    lock.unlock();
+    compositeShared(master_grid, min_i, min_j, max_i, max_j);
+    return;
+  }
+
+  std::unique_lock<std::mutex> lock = lockMap();
   matchCostmapDims(master_grid);
   transferToCostmap();
   if (config_.map.debug.enabled)
@@ -91,6 +107,7 @@ void LineLayer::updateCosts(costmap_2d::Costmap2D &master_grid, int min_i, int m
     publishCostmap();
   }
   resetDirty();
+  lock.unlock();
 
   uchar *master_array = master_grid.getCharMap();
   uchar *line_array = costmap_2d_.getCharMap();
@@ -121,17 +138,26 @@ void LineLayer::imageSyncedCallback(const sensor_msgs::ImageConstPtr &raw_image,
     calculateCachedRays(*segmented_info, camera_index);
   }
 
-  geometry_msgs::TransformStamped camera_to_odom =
+  std::optional<geometry_msgs::TransformStamped> optional_camera_to_odom =
       getTransformToCamera(raw_image->header.frame_id, raw_image->header.stamp);
+  if (!optional_camera_to_odom)
+  {
+    return;
+  }
+  geometry_msgs::TransformStamped &camera_to_odom = *optional_camera_to_odom;
 
   cv::Mat segmented_mat = convertToMat(segmented_image);
 
   projectImage(segmented_mat, camera_to_odom, camera_index);
   cleanupProjections();
-  insertProjectionsIntoMap(camera_to_odom, config_.cameras[camera_index]);
+  {
+    std::unique_lock<std::mutex> lock = lockMap();
+    insertProjectionsIntoMap(camera_to_odom, config_.cameras[camera_index]);
+  }
 
-  debugPublishPC(debug_publishers_[camera_index].debug_line_pub_, line_buffer_, camera_to_odom);
-  debugPublishPC(debug_publishers_[camera_index].debug_nonline_pub_, freespace_buffer_, camera_to_odom);
+  const DebugPublishers &debug_publishers = debug_publishers_[camera_index];
+  debug_publishers.debug_line_pub_.publish([&] { return debugPointcloud(line_buffer_, camera_to_odom); });
+  debug_publishers.debug_nonline_pub_.publish([&] { return debugPointcloud(freespace_buffer_, camera_to_odom); });
 }
 
 void LineLayer::ensurePinholeModelInitialized(const sensor_msgs::CameraInfo &segmented_info, size_t camera_index)
@@ -162,16 +188,10 @@ void LineLayer::calculateCachedRays(const sensor_msgs::CameraInfo &info, size_t
   }
 }
 
-geometry_msgs::TransformStamped LineLayer::getTransformToCamera(const std::string &frame, const ros::Time &stamp) const
+std::optional<geometry_msgs::TransformStamped> LineLayer::getTransformToCamera(const std::string &frame,
+                                                                               const ros::Time &stamp) const
 {
-  if (!tf_->canTransform("odom", frame, stamp, ros::Duration{ 1 }))
-  {
-    ROS_WARN_STREAM_THROTTLE(1.0, "Failed to find transform from frame 'odom' to frame 'base_footprint' within "
-                                  "timeout. Using latest transform...");
-    return tf_->lookupTransform("odom", frame, ros::Time{ 0 }, ros::Duration{ 1 });
-  }
-
-  return tf_->lookupTransform("odom", frame, stamp, ros::Duration{ 1 });
+  return transform_cache_->lookupTransform("odom", frame, stamp, ros::Duration{ 1 });
 }
 
 cv::Mat LineLayer::convertToMat(const sensor_msgs::ImageConstPtr &image) const
@@ -196,7 +216,8 @@ void LineLayer::projectImage(const cv::Mat &segmented_mat, const geometry_msgs::
   tf2::fromMsg(camera_to_odom.transform.rotation, rotation);
 
   grid_map::Index camera_index;  // Center of line_buffer_ and freespace_buffer_
-  map_.getIndex({ translate_vector.x, translate_vector.y }, camera_index);
+  map_->getIndex({ translate_vector.x, translate_vector.y }, camera_index);
+  camera_index = toUnwrappedIndex(camera_index);
 
   constexpr uchar true_val = 255U;
 
@@ -236,7 +257,8 @@ void LineLayer::projectImage(const cv::Mat &segmented_mat, const geometry_msgs::
 grid_map::Index LineLayer::calculateBufferIndex(const Eigen::Vector3f &point, const grid_map::Index &camera_index) const
 {
   grid_map::Index point_index;
-  map_.getIndex({ point[0], point[1] }, point_index);
+  map_->getIndex({ point[0], point[1] }, point_index);
+  point_index = toUnwrappedIndex(point_index);
 
   int center_x = config_.projection.size_x / 2;
   int center_y = config_.projection.size_y / 2;
@@ -291,7 +313,7 @@ void LineLayer::updateProbabilityLayer()
 
   for (auto it = *optional_it; !it.isPastEnd(); ++it)
   {
-    map_.at(probability_layer, *it) = probability_utils::fromLogOdds((*layer_)((*it)[0], (*it)[1]));
+    map_->at(layerName(probability_layer), *it) = probability_utils::fromLogOdds((*layer_)((*it)[0], (*it)[1]));
   }
 }
 
@@ -331,7 +353,7 @@ void LineLayer::updateRollingWindow()
   grid_map::Position costmap_tl_corner =
       costmap_br_corner + grid_map::Position{ costmap_2d_.getSizeInMetersX(), costmap_2d_.getSizeInMetersY() };
   grid_map::Index start_index;
-  map_.getIndex(costmap_tl_corner, start_index);
+  map_->getIndex(costmap_tl_corner, start_index);
 
   grid_map::Index submap_buffer_size{ costmap_2d_.getSizeInCellsX(), costmap_2d_.getSizeInCellsY() };
 
@@ -342,7 +364,7 @@ void LineLayer::updateRollingWindow()
 
   // This goes top -> down, left -> right
   // but costmap_2d_ indicies go down -> up, left -> right
-  for (grid_map::SubmapIterator it{ map_, start_index, submap_buffer_size }; !it.isPastEnd(); ++it)
+  for (grid_map::SubmapIterator it{ *map_, start_index, submap_buffer_size }; !it.isPastEnd(); ++it)
   {
     const auto &log_odds = (*layer_)((*it)[0], (*it)[1]);
     float probability = probability_utils::fromLogOdds(log_odds);
@@ -372,8 +394,6 @@ void LineLayer::updateRollingWindow()
 
 void LineLayer::updateStaticWindow()
 {
-  size_t num_cells = map_.getSize().prod();
-
   uchar *char_map = costmap_2d_.getCharMap();
 
   auto optional_it = getDirtyIterator();
@@ -387,25 +407,29 @@ void LineLayer::updateStaticWindow()
   {
     const auto &log_odds = (*layer_)((*it)[0], (*it)[1]);
     float probability = probability_utils::fromLogOdds(log_odds);
-    size_t linear_index = grid_map::getLinearIndexFromIndex(*it, map_.getSize(), false);
+    size_t costmap_index;
+    if (!getCostmapIndex(*it, costmap_2d_, costmap_index))
+    {
+      continue;
+    }
 
     if (probability > config_.map.occupied_threshold)
     {
-      char_map[num_cells - linear_index - 1] = costmap_2d::LETHAL_OBSTACLE;
+      char_map[costmap_index] = costmap_2d::LETHAL_OBSTACLE;
     }
     else
     {
-      char_map[num_cells - linear_index - 1] = costmap_2d::FREE_SPACE;
+      char_map[costmap_index] = costmap_2d::FREE_SPACE;
     }
   }
 }
 
 void LineLayer::debugPublishMap()
 {
-  map_.setTimestamp(ros::Time::now().toNSec());
+  map_->setTimestamp(ros::Time::now().toNSec());
   grid_map_msgs::GridMap message;
-  std::vector<std::string> layers{ probability_layer };
-  grid_map::GridMapRosConverter::toMessage(map_, layers, message);
+  std::vector<std::string> layers{ layerName(probability_layer) };
+  grid_map::GridMapRosConverter::toMessage(*map_, layers, message);
   gridmap_pub_.publish(message);
 }
 
@@ -438,10 +462,12 @@ void LineLayer::insertProjectionsIntoMap(const geometry_msgs::TransformStamped &
   const float camera_y = camera_to_odom.transform.translation.y;
   const double camera_heading =
       tf2::getYaw(camera_to_odom.transform.rotation) + M_PI / 2.0;  // For some reason this is off by pi/2
-  map_.getIndex({ camera_x, camera_y }, camera_index);
+  map_->getIndex({ camera_x, camera_y }, camera_index);
+  camera_index = toUnwrappedIndex(camera_index);
 
   const int center_x = config_.projection.size_x / 2;
   const int center_y = config_.projection.size_y / 2;
+  const grid_map::Size &map_size = map_->getSize();
 
   const int rows = line_buffer_.rows;
   const int cols = line_buffer_.cols;
@@ -455,12 +481,16 @@ void LineLayer::insertProjectionsIntoMap(const geometry_msgs::TransformStamped &
       {
         const int map_x = camera_index[0] - center_x + 1 + i;
         const int map_y = camera_index[1] - center_y + 1 + j;
-        grid_map::Index map_index{ map_x, map_y };
+        if (map_x < 0 || map_x >= map_size[0] || map_y < 0 || map_y >= map_size[1])
+        {
+          continue;
+        }
+        const grid_map::Index map_index = toBufferIndex({ map_x, map_y });
 
         touch(map_index);
 
         grid_map::Position position;
-        map_.getPosition(map_index, position);
+        map_->getPosition(map_index, position);
         const auto dx = position[0] - camera_x;
         const auto dy = position[1] - camera_y;
         double squared_distance = dx * dx + dy * dy;
@@ -481,12 +511,16 @@ void LineLayer::insertProjectionsIntoMap(const geometry_msgs::TransformStamped &
       {
         const int map_x = camera_index[0] - center_x + 1 + i;
         const int map_y = camera_index[1] - center_y + 1 + j;
-        grid_map::Index map_index{ map_x, map_y };
+        if (map_x < 0 || map_x >= map_size[0] || map_y < 0 || map_y >= map_size[1])
+        {
+          continue;
+        }
+        const grid_map::Index map_index = toBufferIndex({ map_x, map_y });
 
         touch(map_index);
 
         grid_map::Position position;
-        map_.getPosition(map_index, position);
+        map_->getPosition(map_index, position);
         const auto dx = position[0] - camera_x;
         const auto dy = position[1] - camera_y;
         const double squared_distance = dx * dx + dy * dy;
@@ -501,11 +535,12 @@ void LineLayer::insertProjectionsIntoMap(const geometry_msgs::TransformStamped &
   }
 }
 
-void LineLayer::debugPublishPC(ros::Publisher &pub, const cv::Mat &mat, geometry_msgs::TransformStamped &camera_to_odom)
+LineLayer::PointCloud::Ptr LineLayer::debugPointcloud(const cv::Mat &mat,
+                                                      const geometry_msgs::TransformStamped &camera_to_odom) const
 {
-  PointCloud pointcloud;
-  pointcloud.header.stamp = pcl_conversions::toPCL(ros::Time::now());
-  pointcloud.header.frame_id = config_.map.frame_id;
+  PointCloud::Ptr pointcloud{ new PointCloud };
+  pointcloud->header.stamp = pcl_conversions::toPCL(ros::Time::now());
+  pointcloud->header.frame_id = config_.map.frame_id;
 
   const int rows = mat.rows;
   const int cols = mat.cols;
@@ -516,9 +551,9 @@ void LineLayer::debugPublishPC(ros::Publisher &pub, const cv::Mat &mat, geometry
   const float camera_x = camera_to_odom.transform.translation.x;
   const float camera_y = camera_to_odom.transform.translation.y;
   grid_map::Index camera_index;
-  map_.getIndex({ camera_x, camera_y }, camera_index);
+  map_->getIndex({ camera_x, camera_y }, camera_index);
   grid_map::Position camera_pos;
-  map_.getPosition(camera_index, camera_pos);
+  map_->getPosition(camera_index, camera_pos);
 
   constexpr uchar line_val = 255U;
 
@@ -535,12 +570,12 @@ void LineLayer::debugPublishPC(ros::Publisher &pub, const cv::Mat &mat, geometry
         auto cell_y = static_cast<float>(camera_pos[1] - dy);
 
         pcl::PointXYZ pcl_point{ cell_x, cell_y, 0.0 };
-        pointcloud.points.emplace_back(pcl_point);
+        pointcloud->points.emplace_back(pcl_point);
       }
     }
   }
 
-  pub.publish(pointcloud);
+  return pointcloud;
 }
 
 void LineLayer::initCostTranslationTable()
@@ -585,9 +620,11 @@ void LineLayer::publishCostmap()
   msg->info.width = costmap_2d_.getSizeInCellsX();
   msg->info.height = costmap_2d_.getSizeInCellsY();
 
-  grid_map::Position position = map_.getPosition() - 0.5 * map_.getLength().matrix();  // NOLINT
-  msg->info.origin.position.x = position.x();
-  msg->info.origin.position.y = position.y();
+  double wx;
+  double wy;
+  costmap_2d_.mapToWorld(0, 0, wx, wy);
+  msg->info.origin.position.x = wx - resolution / 2;
+  msg->info.origin.position.y = wy - resolution / 2;
   msg->info.origin.position.z = 0.0;
   msg->info.origin.orientation.w = 1.0;
 
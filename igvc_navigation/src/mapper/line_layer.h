@@ -13,6 +13,8 @@
 #include <costmap_2d/layer.h>
 #include <costmap_2d/layered_costmap.h>
 
+#include <igvc_utils/lazy_publisher.h>
+#include <igvc_utils/transform_cache.h>
 #include <pcl_ros/point_cloud.h>
 #include <grid_map_ros/grid_map_ros.hpp>
 
@@ -64,8 +66,8 @@ private:
   std::vector<int8_t> cost_translation_table_;
   struct DebugPublishers
   {
-    ros::Publisher debug_line_pub_;
-    ros::Publisher debug_nonline_pub_;
+    igvc::LazyPublisher<PointCloud> debug_line_pub_;
+    igvc::LazyPublisher<PointCloud> debug_nonline_pub_;
   };
   std::vector<DebugPublishers> debug_publishers_;
 
@@ -83,6 +85,8 @@ private:
 
   costmap_2d::Costmap2D costmap_2d_{};
 
+  std::unique_ptr<igvc::TransformCache> transform_cache_;
+
   void initGridmap();
   void initPubSub();
 
@@ -93,7 +97,8 @@ private:
   void ensurePinholeModelInitialized(const sensor_msgs::CameraInfo& segmented_info, size_t camera_index);
   void calculateCachedRays(const sensor_msgs::CameraInfo& info, size_t camera_index);
 
-  geometry_msgs::TransformStamped getTransformToCamera(const std::string& frame, const ros::Time& stamp) const;
+  std::optional<geometry_msgs::TransformStamped> getTransformToCamera(const std::string& frame,
+                                                                      const ros::Time& stamp) const;
   cv::Mat convertToMat(const sensor_msgs::ImageConstPtr& image) const;
 
   void projectImage(const cv::Mat& segmented_mat, const geometry_msgs::TransformStamped& camera_to_odom,
@@ -104,7 +109,10 @@ private:
 
   grid_map::Index calculateBufferIndex(const Eigen::Vector3f& point, const grid_map::Index& camera_index) const;
 
-  void debugPublishPC(ros::Publisher& pub, const cv::Mat& mat, geometry_msgs::TransformStamped& camera_to_odom);
+  /**
+   * Converts the cells of a projection buffer that are set into a pointcloud in the map frame, for debugging
+   */
+  PointCloud::Ptr debugPointcloud(const cv::Mat& mat, const geometry_msgs::TransformStamped& camera_to_odom) const;
 
   void updateProbabilityLayer();
   void transferToCostmap();
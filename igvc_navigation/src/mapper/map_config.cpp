@@ -15,6 +15,7 @@ MapConfig::MapConfig(const ros::NodeHandle &parent_nh)
   assertions::getParam(nh, "frame_id", frame_id);
 
   costmap_topic = assertions::param(nh, "costmap_topic", std::string(""));
+  shared_grid = assertions::param(nh, "shared_grid", std::string(""));
 
   assertions::getParam(nh, "occupied_threshold", occupied_threshold);
 
@@ -25,5 +26,10 @@ MapConfig::MapConfig(const ros::NodeHandle &parent_nh)
 
   assertions::getParam(nh, "debug/map_topic", debug.map_topic);
   assertions::getParam(nh, "debug/enabled", debug.enabled);
+
+  recenter.enabled = assertions::param(nh, "recenter/enabled", false);
+  recenter.margin = assertions::param(nh, "recenter/margin", 10.0);
+  recenter.archive.enabled = assertions::param(nh, "recenter/archive/enabled", false);
+  recenter.archive.resolution = assertions::param(nh, "recenter/archive/resolution", 0.5);
 }
 }  // namespace map
@@ -19,6 +19,7 @@ public:
 
   std::string frame_id;
   std::string costmap_topic;
+  std::string shared_grid;
 
   double occupied_threshold;
 
@@ -27,6 +28,17 @@ public:
     std::string map_topic;
     bool enabled;
   } debug;
+
+  struct
+  {
+    bool enabled;
+    double margin;
+    struct
+    {
+      bool enabled;
+      double resolution;
+    } archive;
+  } recenter;
 };
 }  // namespace map
 
@@ -1,10 +1,40 @@
 #include "rolling_layer.h"
+#include <algorithm>
 #include <pluginlib/class_list_macros.h>
+#include "costmap_registry.h"
 
 PLUGINLIB_EXPORT_CLASS(rolling_layer::RollingLayer, costmap_2d::Layer)
 
 namespace rolling_layer
 {
+namespace
+{
+inline uint8_t translateMessageCost(int8_t cost)
+{
+  constexpr int8_t unknown_msg_cost = -1;
+  constexpr int8_t lethal_msg_cost = 100;
+
+  if (cost == unknown_msg_cost)
+  {
+    return costmap_2d::NO_INFORMATION;
+  }
+  if (cost == lethal_msg_cost)
+  {
+    return costmap_2d::LETHAL_OBSTACLE;
+  }
+  return costmap_2d::FREE_SPACE;
+}
+
+inline uint8_t translateCost(uint8_t cost)
+{
+  if (cost == costmap_2d::NO_INFORMATION || cost == costmap_2d::LETHAL_OBSTACLE)
+  {
+    return cost;
+  }
+  return costmap_2d::FREE_SPACE;
+}
+}  // namespace
+
 RollingLayer::RollingLayer() : private_nh_("~"), config_(private_nh_)
 {
 }
@@ -20,6 +50,12 @@ void RollingLayer::updateBounds(double robot_x, double robot_y, double robot_yaw
                                 double *max_x, double *max_y)
 {
   updateOrigin(robot_x - getSizeInMetersX() / 2, robot_y - getSizeInMetersY() / 2);
+
+  if (!copyWindowFromSharedCostmap())
+  {
+    copyWindowFromMirror();
+  }
+
   *min_x = getOriginX();
   *max_x = getOriginX() + getSizeInMetersX();
   *min_y = getOriginY();
@@ -46,41 +82,134 @@ void RollingLayer::updateCosts(costmap_2d::Costmap2D &master_grid, int min_i, in
 void RollingLayer::initPubSub()
 {
   costmap_sub_ = nh_.subscribe(config_.topic, 1, &RollingLayer::costmapCallback, this);
+  costmap_update_sub_ = nh_.subscribe(config_.topic + "_updates", 10, &RollingLayer::costmapUpdateCallback, this);
 }
 
 void RollingLayer::costmapCallback(const nav_msgs::OccupancyGridConstPtr &map)
 {
-  double local_origin_x = getOriginX();
-  double local_origin_y = getOriginY();
-  double resolution = map->info.resolution;
-  double global_origin_x = map->info.origin.position.x;
-  double global_origin_y = map->info.origin.position.y;
+  std::lock_guard<std::mutex> lock(mirror_mutex_);
+  mirror_info_ = map->info;
+  mirror_ = map->data;
+}
 
-  size_t global_start_index_x = (local_origin_x - global_origin_x) / resolution + 1;
-  size_t global_start_index_y = (local_origin_y - global_origin_y) / resolution + 1;
+void RollingLayer::costmapUpdateCallback(const map_msgs::OccupancyGridUpdateConstPtr &update)
+{
+  std::lock_guard<std::mutex> lock(mirror_mutex_);
+  if (!mirror_info_)
+  {
+    return;
+  }
+  // The rows are copied by offset into data, so a truncated update would be read past its end
+  if (update->data.size() != static_cast<size_t>(update->width) * update->height)
+  {
+    ROS_WARN_STREAM_THROTTLE(1.0, "Costmap update has " << update->data.size() << " cells instead of "
+                                                        << update->width << " x " << update->height
+                                                        << ", ignoring it");
+    return;
+  }
+
+  const int width = mirror_info_->width;
+  const int height = mirror_info_->height;
+
+  const int start_x = std::max(update->x, 0);
+  const int start_y = std::max(update->y, 0);
+  const int end_x = std::min(update->x + static_cast<int>(update->width), width);
+  const int end_y = std::min(update->y + static_cast<int>(update->height), height);
+
+  for (int y = start_y; y < end_y; y++)
+  {
+    const auto update_row = update->data.begin() + (y - update->y) * update->width;
+    std::copy(update_row + (start_x - update->x), update_row + (end_x - update->x),
+              mirror_.begin() + y * width + start_x);
+  }
+}
+
+bool RollingLayer::copyWindowFromSharedCostmap()
+{
+  if (config_.shared_costmap.empty())
+  {
+    return false;
+  }
+
+  costmap_2d::LayeredCostmap *shared_costmap = costmap_registry::getCostmap(config_.shared_costmap);
+  if (shared_costmap == nullptr)
+  {
+    return false;
+  }
+
+  // Reading in process, so the topics are no longer needed
+  if (costmap_sub_)
+  {
+    costmap_sub_.shutdown();
+    costmap_update_sub_.shutdown();
+  }
+
+  costmap_2d::Costmap2D *global_costmap = shared_costmap->getCostmap();
+  boost::unique_lock<costmap_2d::Costmap2D::mutex_t> lock(*(global_costmap->getMutex()));
+
+  const GlobalGridInfo global{ global_costmap->getOriginX(), global_costmap->getOriginY(),
+                               global_costmap->getResolution(), global_costmap->getSizeInCellsX(),
+                               global_costmap->getSizeInCellsY() };
+  const uint8_t *global_charmap = global_costmap->getCharMap();
+  copyWindow(global, [global_charmap](size_t index) { return translateCost(global_charmap[index]); });
+  return true;
+}
+
+void RollingLayer::copyWindowFromMirror()
+{
+  std::lock_guard<std::mutex> lock(mirror_mutex_);
+  if (!mirror_info_)
+  {
+    return;
+  }
+
+  const GlobalGridInfo global{ mirror_info_->origin.position.x, mirror_info_->origin.position.y,
+                               mirror_info_->resolution, mirror_info_->width, mirror_info_->height };
+  const int8_t *mirror = mirror_.data();
+  copyWindow(global, [mirror](size_t index) { return translateMessageCost(mirror[index]); });
+}
+
+template <typename Translator>
+void RollingLayer::copyWindow(const GlobalGridInfo &global, const Translator &translate)
+{
+  if (std::abs(global.resolution - getResolution()) > 1e-6)
+  {
+    ROS_WARN_STREAM_THROTTLE(1.0, "Global costmap resolution (" << global.resolution
+                                                                << ") does not match rolling layer resolution ("
+                                                                << getResolution() << "). Not updating.");
+    return;
+  }
+
+  const int local_width = getSizeInCellsX();
+  const int local_height = getSizeInCellsY();
+
+  // Offset of our origin in global cells. Both origins lie on the same grid, so rounding only removes float error
+  const auto offset_x = static_cast<int>(std::lround((getOriginX() - global.origin_x) / global.resolution));
+  const auto offset_y = static_cast<int>(std::lround((getOriginY() - global.origin_y) / global.resolution));
+
+  // Range of local x indices that lie within the global grid
+  const int start_x = std::clamp(-offset_x, 0, local_width);
+  const int end_x = std::clamp(static_cast<int>(global.width) - offset_x, start_x, local_width);
 
   unsigned char *charmap = getCharMap();
 
-  for (size_t local_index_y = 0; local_index_y < getSizeInCellsY(); local_index_y++)
+  for (int local_y = 0; local_y < local_height; local_y++)
   {
-    size_t global_index_y = global_start_index_y + local_index_y;
-    for (size_t local_index_x = 0; local_index_x < getSizeInCellsX(); local_index_x++)
+    unsigned char *row = charmap + local_y * local_width;
+    const int global_y = offset_y + local_y;
+    if (global_y < 0 || global_y >= static_cast<int>(global.height))
+    {
+      std::fill(row, row + local_width, costmap_2d::NO_INFORMATION);
+      continue;
+    }
+
+    std::fill(row, row + start_x, costmap_2d::NO_INFORMATION);
+    const long global_base = static_cast<long>(global_y) * global.width + offset_x;
+    for (int local_x = start_x; local_x < end_x; local_x++)
     {
-      size_t global_index_x = global_start_index_x + local_index_x;
-      char global_data = map->data[global_index_y * map->info.width + global_index_x];
-      if (global_data == -1)
-      {
-        charmap[local_index_y * getSizeInCellsX() + local_index_x] = costmap_2d::NO_INFORMATION;
-      }
-      else if (global_data == 100)
-      {
-        charmap[local_index_y * getSizeInCellsX() + local_index_x] = costmap_2d::LETHAL_OBSTACLE;
-      }
-      else
-      {
-        charmap[local_index_y * getSizeInCellsX() + local_index_x] = costmap_2d::FREE_SPACE;
-      }
+      row[local_x] = translate(global_base + local_x);
     }
+    std::fill(row + end_x, row + local_width, costmap_2d::NO_INFORMATION);
   }
 }
 }  // namespace rolling_layer
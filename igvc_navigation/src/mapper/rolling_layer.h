@@ -1,6 +1,9 @@
 #ifndef SRC_ROLLING_LAYER_H
 #define SRC_ROLLING_LAYER_H
 
+#include <mutex>
+#include <optional>
+
 #include <ros/ros.h>
 #include <costmap_2d/costmap_layer.h>
 #include <costmap_2d/layered_costmap.h>
@@ -20,13 +23,58 @@ public:
   void updateCosts(costmap_2d::Costmap2D& master_grid, int min_i, int min_j, int max_i, int max_j) override;
 
 private:
+  struct GlobalGridInfo
+  {
+    double origin_x;
+    double origin_y;
+    double resolution;
+    unsigned int width;
+    unsigned int height;
+  };
+
   void initPubSub();
 
+  /**
+   * Callback for a full global costmap. Replaces the mirrored global grid.
+   * @param map
+   */
   void costmapCallback(const nav_msgs::OccupancyGridConstPtr& map);
 
+  /**
+   * Callback for a partial update of the global costmap. Patches the mirrored global grid.
+   * @param update
+   */
+  void costmapUpdateCallback(const map_msgs::OccupancyGridUpdateConstPtr& update);
+
+  /**
+   * Copies the current window directly out of the global costmap's master grid, if that costmap is loaded in
+   * this process.
+   * @return true if the shared costmap was found and the window was copied
+   */
+  bool copyWindowFromSharedCostmap();
+
+  /**
+   * Copies the current window out of the mirrored global grid
+   */
+  void copyWindowFromMirror();
+
+  /**
+   * Fills this layer's charmap with the window of the global grid that it overlaps. Cells outside of the global grid
+   * are set to NO_INFORMATION.
+   * @param global geometry of the global grid
+   * @param translate functor mapping a linear index into the global grid to a costmap_2d cost
+   */
+  template <typename Translator>
+  void copyWindow(const GlobalGridInfo& global, const Translator& translate);
+
   ros::NodeHandle nh_;
   ros::NodeHandle private_nh_;
   ros::Subscriber costmap_sub_;
+  ros::Subscriber costmap_update_sub_;
+
+  std::mutex mirror_mutex_;
+  std::optional<nav_msgs::MapMetaData> mirror_info_;
+  std::vector<int8_t> mirror_;
 
   RollingLayerConfig config_;
 };
@@ -8,5 +8,6 @@ RollingLayerConfig::RollingLayerConfig(const ros::NodeHandle &parent_nh)
   ros::NodeHandle nh(parent_nh, "rolling_layer");
 
   assertions::getParam(nh, "topic", topic);
+  shared_costmap = assertions::param(nh, "shared_costmap", std::string(""));
 }
 }  // namespace rolling_layer
@@ -11,6 +11,7 @@ public:
   RollingLayerConfig(const ros::NodeHandle& parent_nh);
 
   std::string topic;
+  std::string shared_costmap;
 };
 }  // namespace rolling_layer
 
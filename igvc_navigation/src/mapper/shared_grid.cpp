@@ -0,0 +1,274 @@
+#include "shared_grid.h"
+
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+
+#include <mapper/probability_utils.h>
+
+namespace shared_grid
+{
+namespace
+{
+std::mutex registry_mutex;
+std::unordered_map<std::string, std::weak_ptr<SharedGrid>> registry;
+}  // namespace
+
+SharedGrid::SharedGrid(const map::MapConfig& config)
+  : recenter_enabled_{ config.recenter.enabled }
+  , recenter_margin_{ config.recenter.margin }
+  , archive_enabled_{ config.recenter.archive.enabled }
+  , archive_resolution_{ config.recenter.archive.resolution }
+{
+  // TODO: Configurable start positions
+  map_.setFrameId(config.frame_id);
+  grid_map::Length dimensions{ config.length_x, config.length_y };
+  map_.setGeometry(dimensions, config.resolution);
+}
+
+std::shared_ptr<SharedGrid> SharedGrid::acquire(const std::string& name, const map::MapConfig& config)
+{
+  std::lock_guard<std::mutex> lock(registry_mutex);
+
+  std::shared_ptr<SharedGrid> grid = registry[name].lock();
+  if (!grid)
+  {
+    grid = std::make_shared<SharedGrid>(config);
+    registry[name] = grid;
+    return grid;
+  }
+
+  const grid_map::Length dimensions{ config.length_x, config.length_y };
+  const bool same_geometry = grid->map_.getFrameId() == config.frame_id &&
+                             std::abs(grid->map_.getResolution() - config.resolution) < 1e-6 &&
+                             (grid->map_.getLength() - dimensions).abs().maxCoeff() < config.resolution;
+  if (!same_geometry)
+  {
+    ROS_WARN_STREAM("Geometry of shared grid '" << name << "' does not match. Using a private grid instead.");
+    return nullptr;
+  }
+  return grid;
+}
+
+void SharedGrid::addChannel(const std::string& logodds_layer, double occupied_threshold, const bool* enabled)
+{
+  const auto threshold = static_cast<float>(probability_utils::toLogOdds(occupied_threshold));
+  channels_.emplace_back(Channel{ logodds_layer, threshold, enabled });
+}
+
+void SharedGrid::requestComposite()
+{
+  composite_pending_ = true;
+}
+
+void SharedGrid::composite(costmap_2d::Costmap2D& master_grid, int min_i, int min_j, int max_i, int max_j)
+{
+  if (!composite_pending_)
+  {
+    return;
+  }
+  composite_pending_ = false;
+
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  const double resolution = map_.getResolution();
+  if (std::abs(master_grid.getResolution() - resolution) > 1e-6)
+  {
+    ROS_WARN_STREAM_THROTTLE(1.0, "Shared grid resolution (" << resolution << ") does not match costmap resolution ("
+                                                             << master_grid.getResolution() << "). Not updating.");
+    return;
+  }
+
+  std::vector<std::pair<const grid_map::Matrix*, float>> channels;
+  channels.reserve(channels_.size());
+  for (const auto& channel : channels_)
+  {
+    if (*channel.enabled)
+    {
+      channels.emplace_back(&map_.get(channel.logodds_layer), channel.occupied_threshold);
+    }
+  }
+  if (channels.empty())
+  {
+    return;
+  }
+
+  const grid_map::Size& size = map_.getSize();
+  const grid_map::Index& start_index = map_.getStartIndex();
+
+  // Unwrapped gridmap indices increase going down and right, ie. towards -x and -y
+  const grid_map::Position top_left = map_.getPosition() + 0.5 * map_.getLength().matrix();
+  const double first_x = master_grid.getOriginX() + (min_i + 0.5) * resolution;
+  const int first_unwrapped_x = static_cast<int>(std::floor((top_left.x() - first_x) / resolution));
+
+  uchar* master_array = master_grid.getCharMap();
+  const unsigned int span = master_grid.getSizeInCellsX();
+
+  for (int j = min_j; j < max_j; j++)
+  {
+    const double y = master_grid.getOriginY() + (j + 0.5) * resolution;
+    const int unwrapped_y = static_cast<int>(std::floor((top_left.y() - y) / resolution));
+    if (unwrapped_y < 0 || unwrapped_y >= size[1])
+    {
+      continue;
+    }
+    int buffer_y = unwrapped_y + start_index[1];
+    if (buffer_y >= size[1])
+    {
+      buffer_y -= size[1];
+    }
+
+    unsigned int it = j * span + min_i;
+    int unwrapped_x = first_unwrapped_x;
+    for (int i = min_i; i < max_i; i++, it++, unwrapped_x--)
+    {
+      if (unwrapped_x < 0 || unwrapped_x >= size[0])
+      {
+        continue;
+      }
+      int buffer_x = unwrapped_x + start_index[0];
+      if (buffer_x >= size[0])
+      {
+        buffer_x -= size[0];
+      }
+
+      unsigned char cost = costmap_2d::FREE_SPACE;
+      for (const auto& [data, threshold] : channels)
+      {
+        if ((*data)(buffer_x, buffer_y) > threshold)
+        {
+          cost = costmap_2d::LETHAL_OBSTACLE;
+          break;
+        }
+      }
+
+      unsigned char old_cost = master_array[it];
+      if (old_cost == costmap_2d::NO_INFORMATION || old_cost < cost)
+        master_array[it] = cost;
+    }
+  }
+}
+
+void SharedGrid::recenterIfNeeded(double robot_x, double robot_y)
+{
+  if (!recenter_enabled_)
+  {
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  const grid_map::Position robot_pos{ robot_x, robot_y };
+  const grid_map::Position offset = robot_pos - map_.getPosition();
+  const grid_map::Length half_length = map_.getLength() / 2;
+
+  const double distance_to_edge = (half_length - offset.array().abs()).minCoeff();
+  if (distance_to_edge > recenter_margin_)
+  {
+    return;
+  }
+
+  // Same alignment as grid_map::GridMap::move, so that cells keep their positions
+  const double resolution = map_.getResolution();
+  const grid_map::Position aligned_offset = ((offset.array() / resolution).round() * resolution).matrix();
+  const grid_map::Position new_center = map_.getPosition() + aligned_offset;
+
+  if (archive_enabled_)
+  {
+    archiveEvictedCells(new_center);
+  }
+
+  map_.move(new_center);
+  restoreUncoveredCells();
+
+  ROS_DEBUG_STREAM("Recentered shared grid to (" << new_center.x() << ", " << new_center.y() << ")");
+}
+
+void SharedGrid::archiveEvictedCells(const grid_map::Position& new_center)
+{
+  const grid_map::Length half_length = map_.getLength() / 2;
+
+  for (const auto& channel : channels_)
+  {
+    const grid_map::Matrix& data = map_.get(channel.logodds_layer);
+    std::unordered_map<grid_map::Index, ArchivedCell> spilled;
+    for (grid_map::GridMapIterator it{ map_ }; !it.isPastEnd(); ++it)
+    {
+      grid_map::Position position;
+      map_.getPosition(*it, position);
+      if (((position - new_center).array().abs() < half_length).all())
+      {
+        continue;
+      }
+
+      const float value = data((*it)[0], (*it)[1]);
+      if (!std::isfinite(value))
+      {
+        continue;
+      }
+
+      // Keep every occupied cell of each coarse cell, so that restored obstacles are never lost
+      ArchivedCell& cell = spilled.try_emplace(toArchiveIndex(position), ArchivedCell{ value, {} }).first->second;
+      cell.value = std::max(cell.value, value);
+      if (value > 0.0)
+      {
+        cell.occupied.emplace_back(OccupiedCell{ value, position });
+      }
+    }
+
+    auto& channel_archive = archive_[channel.logodds_layer];
+    for (auto& [archive_index, cell] : spilled)
+    {
+      channel_archive[archive_index] = std::move(cell);
+    }
+  }
+}
+
+void SharedGrid::restoreUncoveredCells()
+{
+  for (const auto& channel : channels_)
+  {
+    grid_map::Matrix& data = map_.get(channel.logodds_layer);
+    const auto& channel_archive = archive_[channel.logodds_layer];
+
+    // GridMap::move sets the uncovered cells to NaN
+    for (grid_map::GridMapIterator it{ map_ }; !it.isPastEnd(); ++it)
+    {
+      float& value = data((*it)[0], (*it)[1]);
+      if (!std::isnan(value))
+      {
+        continue;
+      }
+
+      value = 0.0;  // Unknown
+      if (archive_enabled_)
+      {
+        grid_map::Position position;
+        map_.getPosition(*it, position);
+        auto archive_it = channel_archive.find(toArchiveIndex(position));
+        if (archive_it != channel_archive.end())
+        {
+          const ArchivedCell& archived = archive_it->second;
+          if (archived.value <= 0.0)
+          {
+            value = archived.value;
+          }
+          for (const OccupiedCell& occupied : archived.occupied)
+          {
+            grid_map::Index occupied_index;
+            if (map_.getIndex(occupied.position, occupied_index) && (occupied_index == *it).all())
+            {
+              value = occupied.value;
+              break;
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
+grid_map::Index SharedGrid::toArchiveIndex(const grid_map::Position& position) const
+{
+  return (position.array() / archive_resolution_).floor().cast<int>();
+}
+}  // namespace shared_grid
@@ -0,0 +1,138 @@
+#ifndef SRC_SHARED_GRID_H
+#define SRC_SHARED_GRID_H
+
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include <costmap_2d/costmap_2d.h>
+#include <grid_map_ros/grid_map_ros.hpp>
+
+#include "eigen_hash.h"
+#include "map_config.h"
+
+namespace shared_grid
+{
+/**
+ * Backing store for GridmapLayer layers. Every layer writes its own channel (a set of grid_map layers) into one
+ * grid_map::GridMap, so all channels share a single geometry.
+ *
+ * Layers with the same map/shared_grid name in one process acquire the same SharedGrid, and are then composited into
+ * the master grid together in a single pass. Otherwise a SharedGrid is private to its layer.
+ *
+ * The channels are written from the sensor callbacks while the map is moved and composited from the costmap update
+ * thread, so every access to map() has to hold mutex().
+ */
+class SharedGrid
+{
+public:
+  explicit SharedGrid(const map::MapConfig& config);
+
+  /**
+   * Returns the SharedGrid registered under name, creating it from config if it doesn't exist yet
+   * @param name name of the shared grid
+   * @param config map config of the acquiring layer
+   * @return the shared grid, or nullptr if its geometry doesn't match config
+   */
+  static std::shared_ptr<SharedGrid> acquire(const std::string& name, const map::MapConfig& config);
+
+  grid_map::GridMap& map()
+  {
+    return map_;
+  }
+
+  std::mutex& mutex()
+  {
+    return mutex_;
+  }
+
+  /**
+   * Registers a channel to be composited and archived.
+   * @param logodds_layer name of the channel's logodds layer in map()
+   * @param occupied_threshold probability above which a cell of the channel is lethal
+   * @param enabled pointer to the owning layer's enabled flag. Disabled channels are not composited
+   */
+  void addChannel(const std::string& logodds_layer, double occupied_threshold, const bool* enabled);
+
+  [[nodiscard]] bool recenteringEnabled() const
+  {
+    return recenter_enabled_;
+  }
+
+  void disableRecentering()
+  {
+    recenter_enabled_ = false;
+  }
+
+  /**
+   * Moves the map so that it is centered on the robot if the robot is within the recentering margin of an edge.
+   * Locks mutex().
+   *
+   * This only bounds the memory of the map and the archive. The master costmap keeps its configured size, and so does
+   * the private costmap of a layer that isn't shared or has debug enabled, since it matches the master grid.
+   */
+  void recenterIfNeeded(double robot_x, double robot_y);
+
+  /**
+   * Marks that the channels should be composited on the next call to composite
+   */
+  void requestComposite();
+
+  /**
+   * Composites all enabled channels into master_grid in a single pass. A cell is lethal if it is occupied in any
+   * channel, and free otherwise. Only the first call after requestComposite does any work, so that each layer sharing
+   * the grid can call this from updateCosts. Locks mutex().
+   */
+  void composite(costmap_2d::Costmap2D& master_grid, int min_i, int min_j, int max_i, int max_j);
+
+private:
+  struct Channel
+  {
+    std::string logodds_layer;
+    float occupied_threshold;  // In logodds
+    const bool* enabled;
+  };
+
+  // Cell of the map that was occupied when it was evicted
+  struct OccupiedCell
+  {
+    float value;
+    grid_map::Position position;
+  };
+
+  // Cells of the map evicted into one archive cell
+  struct ArchivedCell
+  {
+    float value;                         // Most occupied value of the cells
+    std::vector<OccupiedCell> occupied;  // Every occupied cell, ie. with a positive value
+  };
+
+  std::mutex mutex_;
+  grid_map::GridMap map_;
+  std::vector<Channel> channels_;
+  bool composite_pending_ = false;
+
+  bool recenter_enabled_;
+  double recenter_margin_;
+  bool archive_enabled_;
+  double archive_resolution_;
+  std::unordered_map<std::string, std::unordered_map<grid_map::Index, ArchivedCell>> archive_;
+
+  /**
+   * Spills cells that will leave the map when it is moved to new_center into archive_
+   */
+  void archiveEvictedCells(const grid_map::Position& new_center);
+
+  /**
+   * Fills the cells uncovered by a move from archive_, or with the unknown value if they have not been seen before.
+   * An occupied archive cell only restores its occupied cells, each to the cell it came from, so that obstacles don't
+   * grow to the size of the archive cell. A free one bounds every cell it covers, so it is restored to all of them.
+   */
+  void restoreUncoveredCells();
+
+  [[nodiscard]] grid_map::Index toArchiveIndex(const grid_map::Position& position) const;
+};
+}  // namespace shared_grid
+
+#endif  // SRC_SHARED_GRID_H
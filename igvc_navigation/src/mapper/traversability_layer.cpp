@@ -16,26 +16,49 @@ TraversabilityLayer::TraversabilityLayer()
 
 void TraversabilityLayer::initGridmap()
 {
-  map_.setFrameId(config_.map.frame_id);
-  grid_map::Length dimensions{ config_.map.length_x, config_.map.length_y };
-  map_.setGeometry(dimensions, config_.map.resolution);
-  map_.get("logodds").setZero();
+  initMap(config_.map, "traversability", "logodds");
 }
 
 void TraversabilityLayer::initPubSub()
 {
-  slope_sub_ = private_nh_.subscribe("/slope/gridmap", 1, &TraversabilityLayer::slopeMapCallback, this);
-  costmap_pub_ = private_nh_.advertise<nav_msgs::OccupancyGrid>(config_.map.costmap_topic, 1);
+  // The slope filter sends the regions that changed, so a dropped message loses its region until the next full map.
+  // The queue holds the updates of a whole full_map_period of the slope filter.
+  slope_sub_ = private_nh_.subscribe("/slope/gridmap", 20, &TraversabilityLayer::slopeMapCallback, this);
+  if (config_.map.debug.enabled)
+  {
+    costmap_pub_ = private_nh_.advertise<nav_msgs::OccupancyGrid>(config_.map.costmap_topic, 1);
+  }
 }
 
 void TraversabilityLayer::onInitialize()
 {
   GridmapLayer::onInitialize();
-  matchCostmapDims(*layered_costmap_->getCostmap());
+  if (!isShared())
+  {
+    matchCostmapDims(*layered_costmap_->getCostmap());
+  }
 }
 
 void TraversabilityLayer::updateCosts(costmap_2d::Costmap2D &master_grid, int min_i, int min_j, int max_i, int max_j)
 {
+  if (isShared())
+  {
+    // The shared grid composites every channel into master_grid at once, so the layer's own costmap is only kept up
+    // to date for its debug topic
+    std::unique_lock<std::mutex> lock = lockMap();
+    if (config_.map.debug.enabled)
+    {
+      matchCostmapDims(master_grid);
+      transferToCostmap();
+      publishCostmap();
+    }
+    resetDirty();
+    lock.unlock();
+    compositeShared(master_grid, min_i, min_j, max_i, max_j);
+    return;
+  }
+
+  std::unique_lock<std::mutex> lock = lockMap();
   matchCostmapDims(master_grid);
   transferToCostmap();
   if (config_.map.debug.enabled)
@@ -43,6 +66,7 @@ void TraversabilityLayer::updateCosts(costmap_2d::Costmap2D &master_grid, int mi
     publishCostmap();
   }
   resetDirty();
+  lock.unlock();
 
   uchar *master_array = master_grid.getCharMap();
   uchar *line_array = costmap_2d_.getCharMap();
@@ -75,20 +99,23 @@ void TraversabilityLayer::updateBounds(double robot_x, double robot_y, double ro
 void TraversabilityLayer::slopeMapCallback(const grid_map_msgs::GridMap &slope_map_msg)
 {
   current_ = true;
+  // The slope filter only sends the region that changed, so each message is merged into the cells it covers
   grid_map::GridMap slope_map;
-  grid_map::GridMapRosConverter::fromMessage(slope_map_msg, slope_map);
+  grid_map::GridMapRosConverter::fromMessage(slope_map_msg, slope_map, { "slope" }, false, false);
+  const grid_map::Matrix &slopes = slope_map.get("slope");
 
+  std::unique_lock<std::mutex> lock = lockMap();
   for (grid_map::GridMapIterator it(slope_map); !it.isPastEnd(); ++it)
   {
     grid_map::Position pos;
     slope_map.getPosition((*it), pos);
-    if (map_.isInside(pos))
+    if (map_->isInside(pos))
     {
-      float slope = slope_map.get("slope")((*it)[0], (*it)[1]);
+      float slope = slopes((*it)[0], (*it)[1]);
       grid_map::Index map_index;
-      map_.getIndex(pos, map_index);
+      map_->getIndex(pos, map_index);
       touch(map_index);
-      float *logodd = &map_.at("logodds", map_index);
+      float *logodd = &map_->at(layerName("logodds"), map_index);
       if (slope > config_.slope_threshold)
       {
         *logodd = std::min(*logodd + config_.logodd_increment, config_.map.max_occupancy);
@@ -129,7 +156,6 @@ void TraversabilityLayer::transferToCostmap()
   {
     updateStaticWindow();
   }
-  publishCostmap();
 }
 
 void TraversabilityLayer::publishCostmap()
@@ -180,8 +206,6 @@ void TraversabilityLayer::publishCostmap()
 void TraversabilityLayer::updateStaticWindow()
 {
   // Static window, so we can only update dirty cells
-  size_t num_cells = map_.getSize().prod();
-
   unsigned char *char_map = costmap_2d_.getCharMap();
 
   auto optional_it = getDirtyIterator();
@@ -193,17 +217,21 @@ void TraversabilityLayer::updateStaticWindow()
 
   for (auto it = *optional_it; !it.isPastEnd(); ++it)
   {
-    const auto &log_odds = map_.get("logodds")((*it)[0], (*it)[1]);
+    const auto &log_odds = map_->get(layerName("logodds"))((*it)[0], (*it)[1]);
     float probability = probability_utils::fromLogOdds(log_odds);
-    size_t linear_index = grid_map::getLinearIndexFromIndex(*it, map_.getSize(), false);
+    size_t costmap_index;
+    if (!getCostmapIndex(*it, costmap_2d_, costmap_index))
+    {
+      continue;
+    }
 
     if (probability > config_.map.occupied_threshold)
     {
-      char_map[num_cells - linear_index - 1] = costmap_2d::LETHAL_OBSTACLE;
+      char_map[costmap_index] = costmap_2d::LETHAL_OBSTACLE;
     }
     else
     {
-      char_map[num_cells - linear_index - 1] = costmap_2d::FREE_SPACE;
+      char_map[costmap_index] = costmap_2d::FREE_SPACE;
     }
   }
 }
@@ -217,7 +245,7 @@ void TraversabilityLayer::updateRollingWindow()
   grid_map::Position costmap_tl_corner =
       costmap_br_corner + grid_map::Position{ costmap_2d_.getSizeInMetersX(), costmap_2d_.getSizeInMetersY() };
   grid_map::Index start_index;
-  map_.getIndex(costmap_tl_corner, start_index);
+  map_->getIndex(costmap_tl_corner, start_index);
 
   grid_map::Index submap_buffer_size{ costmap_2d_.getSizeInCellsX(), costmap_2d_.getSizeInCellsY() };
 
@@ -228,9 +256,9 @@ void TraversabilityLayer::updateRollingWindow()
 
   // This goes top -> down, left -> right
   // but costmap_2d_ indicies go down -> up, left -> right
-  for (grid_map::SubmapIterator it{ map_, start_index, submap_buffer_size }; !it.isPastEnd(); ++it)
+  for (grid_map::SubmapIterator it{ *map_, start_index, submap_buffer_size }; !it.isPastEnd(); ++it)
   {
-    const auto &log_odds = map_.get("logodds")((*it)[0], (*it)[1]);
+    const auto &log_odds = map_->get(layerName("logodds"))((*it)[0], (*it)[1]);
     float probability = probability_utils::fromLogOdds(log_odds);
 
     const size_t linear_idx = x_idx + y_idx * cells_x;
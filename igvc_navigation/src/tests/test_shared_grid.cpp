@@ -0,0 +1,91 @@
+#include <gtest/gtest.h>
+#include <ros/ros.h>
+
+#include "../mapper/shared_grid.h"
+
+using shared_grid::SharedGrid;
+
+/**
+ * A 10 m map at 0.1 m with a 0.5 m archive, configured in test_shared_grid.test
+ */
+class TestSharedGrid : public testing::Test
+{
+protected:
+  static constexpr const char* layer = "logodds";
+
+  map::MapConfig config{ ros::NodeHandle{ "~" } };
+  SharedGrid grid{ config };
+  bool enabled = true;
+
+  void SetUp() override
+  {
+    grid.map().add(layer, 0.0);
+    grid.addChannel(layer, 0.5, &enabled);
+  }
+
+  float& at(double x, double y)
+  {
+    grid_map::Index index;
+    EXPECT_TRUE(grid.map().getIndex(grid_map::Position{ x, y }, index)) << "(" << x << ", " << y << ")";
+    return grid.map().at(layer, index);
+  }
+
+  /**
+   * Drives far enough towards +x and +y to evict the cells around (-4, -4), and back
+   */
+  void driveAwayAndBack()
+  {
+    grid.recenterIfNeeded(4.0, 4.0);
+    ASSERT_FALSE(grid.map().isInside(grid_map::Position{ -4.0, -4.0 }));
+    grid.recenterIfNeeded(0.0, 0.0);
+    ASSERT_TRUE(grid.map().isInside(grid_map::Position{ -4.0, -4.0 }));
+  }
+};
+
+TEST_F(TestSharedGrid, RestoresEveryObstacleOfArchiveCell)
+{
+  // Both in the archive cell from (-4.5, -4.5) to (-4.0, -4.0)
+  at(-4.45, -4.45) = 2.0f;
+  at(-4.15, -4.35) = 1.5f;
+
+  driveAwayAndBack();
+
+  EXPECT_FLOAT_EQ(at(-4.45, -4.45), 2.0f);
+  EXPECT_FLOAT_EQ(at(-4.15, -4.35), 1.5f);
+  // The obstacles don't grow to the rest of the archive cell
+  EXPECT_FLOAT_EQ(at(-4.25, -4.05), 0.0f);
+  EXPECT_FLOAT_EQ(at(-4.45, -4.35), 0.0f);
+}
+
+TEST_F(TestSharedGrid, RestoresFreeArchiveCellEverywhere)
+{
+  for (double x = -3.95; x < -3.5; x += 0.1)
+  {
+    for (double y = -4.45; y < -4.0; y += 0.1)
+    {
+      at(x, y) = -1.0f;
+    }
+  }
+  // Only the most occupied value of a free archive cell is kept
+  at(-3.75, -4.25) = -0.5f;
+
+  driveAwayAndBack();
+
+  for (double x = -3.95; x < -3.5; x += 0.1)
+  {
+    for (double y = -4.45; y < -4.0; y += 0.1)
+    {
+      EXPECT_FLOAT_EQ(at(x, y), -0.5f) << "(" << x << ", " << y << ")";
+    }
+  }
+}
+
+int main(int argc, char** argv)
+{
+  ros::init(argc, argv, "test_shared_grid");
+  testing::InitGoogleTest(&argc, argv);
+
+  int ret = RUN_ALL_TESTS();
+  ros::shutdown();
+  return ret;
+}
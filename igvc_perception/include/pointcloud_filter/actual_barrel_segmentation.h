@@ -1,47 +1,101 @@
 #ifndef SRC_ACTUAL_BARREL_SEGMENTATION_H
 #define SRC_ACTUAL_BARREL_SEGMENTATION_H
 
+#include <memory>
+
+#include <pcl/ModelCoefficients.h>
+#include <pcl/PointIndices.h>
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+#include <pcl_ros/point_cloud.h>
 #include <ros/ros.h>
-#include <tf/transform_listener.h>
+#include <tf2_ros/transform_listener.h>
 
-#include <pointcloud_filter/back_filter/back_filter.h>
-#include <pointcloud_filter/ground_filter/ground_filter.h>
-#include <pointcloud_filter/pointcloud_filter_config.h>
-#include <pointcloud_filter/radius_filter/radius_filter.h>
-#include <pointcloud_filter/raycast_filter/raycast_filter.h>
-#include <pointcloud_filter/tf_transform_filter/tf_transform_filter.h>
+#include <igvc_utils/thread_pool.h>
+#include <igvc_utils/transform_cache.h>
+#include <pointcloud_filter/circle_fit.h>
+#include <pointcloud_filter/cluster_tracker/cluster_tracker.h>
+#include <pointcloud_filter/point_types.h>
 
 namespace pointcloud_filter
 {
-class PointcloudFilter
+/**
+ * Clusters the nonground points and fits an upright cylinder to each cluster to find barrels.
+ *
+ * With fitMode "upright", a cylinder is found by fitting a circle to the cluster projected onto the ground, and the
+ * slower 3D cylinder fit is only run on the clusters where that fails. The clusters of a cloud are fit in parallel.
+ *
+ * The clusters are tracked between clouds, so that their markers keep the same id and color, and so that the cylinder
+ * of a cluster that hasn't changed is reused instead of being fit again.
+ */
+class BarrelSegmentation
 {
 public:
   using PointCloud = pcl::PointCloud<velodyne_pcl::PointXYZIRT>;
 
-  PointcloudFilter(const ros::NodeHandle& nh = {}, const ros::NodeHandle& private_nh = { "~" });
+  BarrelSegmentation(const ros::NodeHandle& nh = {}, const ros::NodeHandle& private_nh = { "~" });
 
 private:
   ros::NodeHandle nh_;
   ros::NodeHandle private_nh_;
-  PointcloudFilterConfig config_;
 
   tf2_ros::Buffer buffer_;
   tf2_ros::TransformListener listener_;
+  igvc::TransformCache transform_cache_;
+  ClusterTracker tracker_;
+
+  std::string subTopic = "/nonground";
+  std::string countPubTopic = "/countOutput";
+  std::string visPubTopic = "/vizOutput";
+  std::string barrelPubTopic = "/barrelPos";
+
+  double clusterTolerance{};
+  int minClusterSize{};
+  int maxClusterSize{};
+  double cylinderMinRad{};
+  double cylinderMaxRad{};
+  double cylinderDistThres{};
+  double cylinderNormalDistWeight{};
+  bool showCyl{};
+  bool showClus{};
+  bool showInlier{};
+  std::string fitMode = "upright";  // "upright" or "cylinder"
+  int circleMaxIterations = 200;
+  double circleMinInlierRatio = 0.6;
+  int numThreads = 1;  // 0 uses one per core
+
+  CircleFitParams circle_params_;
+  std::unique_ptr<igvc::ThreadPool> thread_pool_;
+
+  ros::Subscriber pointcloud_sub_;
+
+  ros::Publisher cluster_count_pub_;
+  ros::Publisher cluster_vis_pub_;
+  ros::Publisher barrel_info_pub_;
+
+  // Cylinder coefficients as in SACMODEL_CYLINDER, empty if no barrel was found, and the positions of the inliers in
+  // the cluster's indices
+  struct CylinderFit
+  {
+    std::vector<float> coefficients;
+    std::vector<int> inliers;
+  };
 
-  BackFilter back_filter_;
-  RadiusFilter radius_filter_;
-  TFTransformFilter tf_transform_filter_;
-  GroundFilter ground_filter_;
-  RaycastFilter raycast_filter_;
+  void getCylinder(pcl::PointCloud<pcl::PointXYZ>::Ptr cloud, pcl::ModelCoefficients::Ptr coefficients_cylinder,
+                   pcl::PointIndices::Ptr inliers_cylinder) const;
 
-  ros::Subscriber raw_pointcloud_sub_;
+  /**
+   * Fits a cylinder to the points of cluster. Safe to call from several threads at once.
+   */
+  CylinderFit fitCylinder(const pcl::PointCloud<pcl::PointXYZ>& cloud, const pcl::PointIndices& cluster) const;
 
-  ros::Publisher transformed_pointcloud_pub_;
-  ros::Publisher occupied_pointcloud_pub_;
-  ros::Publisher free_pointcloud_pub_;
+  /**
+   * Returns the cylinder coefficients moved by transform
+   */
+  static std::vector<float> transformCylinder(const std::vector<float>& coefficients,
+                                              const Eigen::Isometry3f& transform);
 
-  void setupPubSub();
-  void pointcloudCallback(const PointCloud::ConstPtr& raw_pointcloud);
+  void clusteringCallBack(const PointCloud::ConstPtr& pointcloud);
 };
 }  // namespace pointcloud_filter
 
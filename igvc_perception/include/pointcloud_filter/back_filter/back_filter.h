@@ -5,18 +5,24 @@
 #include "pointcloud_filter/point_types.h"
 
 #include <pointcloud_filter/back_filter/back_filter_config.h>
-#include <pointcloud_filter/filter.h>
+#include <pointcloud_filter/point_kernels.h>
+#include <pointcloud_filter/range_image.h>
 
 namespace pointcloud_filter
 {
-class BackFilter : Filter
+/**
+ * Predicate for PredicatePipeline that keeps points with an azimuth between start_angle and end_angle
+ */
+class BackFilter
 {
 public:
-  using PointCloud = pcl::PointCloud<velodyne_pcl::PointXYZIRT>;
-
   explicit BackFilter(const ros::NodeHandle& nh);
 
-  void filter(Bundle& bundle) override;
+  void mask(const PointBuffer& /*points*/, const RangeImage& range_image, size_t begin, size_t count,
+            uint8_t* mask) const
+  {
+    kernels::maskInRange(range_image.azimuths() + begin, count, config_.start_angle, config_.end_angle, mask);
+  }
 
 private:
   BackFilterConfig config_{};
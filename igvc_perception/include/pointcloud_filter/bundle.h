@@ -1,20 +1,78 @@
 #ifndef SRC_POINTCLOUD_BUNDLE_H
 #define SRC_POINTCLOUD_BUNDLE_H
 
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <Eigen/Geometry>
+
+#include <igvc_msgs/polar_scan.h>
 #include <pcl/point_cloud.h>
+#include "pointcloud_filter/point_buffer.h"
 #include "pointcloud_filter/point_types.h"
+#include "pointcloud_filter/range_image.h"
 
 namespace pointcloud_filter
 {
+/**
+ * State passed through the filters for one scan. Filters don't copy points around, instead they select points of
+ * raw_pointcloud by index, and the selected points are only copied out when they get published.
+ */
 struct Bundle
 {
   using PointCloud = pcl::PointCloud<velodyne_pcl::PointXYZIRT>;
 
-  PointCloud::Ptr pointcloud;
-  PointCloud::Ptr occupied_pointcloud;
-  PointCloud::Ptr free_pointcloud;
+  PointCloud::ConstPtr raw_pointcloud;
+  // raw_pointcloud as a structure of arrays, for the vectorized kernels
+  PointBuffer points;
+  igvc_msgs::polar_scanPtr free_scan;
+
+  // Indices into raw_pointcloud (and points, rangeImage()) of the points that passed filtering so far
+  std::vector<int> indices;
+  // Indices into raw_pointcloud (and points, rangeImage()) of the occupied points, a subset of indices
+  std::vector<int> occupied_indices;
+
+  // Transforms from the frame of raw_pointcloud to other frames, so that each one is only looked up once per scan.
+  // There are only one or two target frames, so a vector keeps its memory between scans where a map wouldn't.
+  std::vector<std::pair<std::string, Eigen::Isometry3d>> transforms;
+
+  // LoadShedder level the scan is processed at
+  int degradation_level = 0;
+  // Time spent on the scan by the pipeline stages so far (ms): in total, and by the slowest stage
+  double total_stage_ms = 0.0;
+  double max_stage_ms = 0.0;
+
+  explicit Bundle(int range_image_columns = default_range_image_columns);
+  Bundle(const PointCloud::ConstPtr& raw_pointcloud, int range_image_columns = default_range_image_columns);
+
+  /**
+   * Starts over with a new scan, keeping the memory of the previous one so that a recycled bundle doesn't allocate
+   * once it has seen a scan of the same size. See BundlePool.
+   */
+  void reset(const PointCloud::ConstPtr& raw_pointcloud);
+
+  /**
+   * Size in bytes of the memory held by the bundle's buffers
+   */
+  size_t capacityBytes() const;
+
+  /**
+   * Returns the range image of raw_pointcloud, building it on the first call
+   */
+  const RangeImage& rangeImage();
+
+  /**
+   * Copies the points of raw_pointcloud in selection into a new pointcloud with the same header
+   */
+  PointCloud::Ptr materialize(const std::vector<int>& selection) const;
+
+private:
+  static constexpr int default_range_image_columns = 1800;
 
-  Bundle(const PointCloud::ConstPtr& raw_pointcloud);
+  int range_image_columns_;
+  RangeImage range_image_;
+  bool range_image_built_ = false;
 };
 }  // namespace pointcloud_filter
 
@@ -0,0 +1,68 @@
+#ifndef SRC_BUNDLE_POOL_H
+#define SRC_BUNDLE_POOL_H
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <pointcloud_filter/bundle.h>
+
+namespace pointcloud_filter
+{
+/**
+ * Recycles bundles between scans, so that their buffers keep their capacity instead of being allocated again for
+ * every scan. Once every bundle in flight has seen a full size scan, leasing and returning a bundle doesn't allocate.
+ *
+ * Leases return their bundle to the pool when they are destroyed, which may happen on any thread. The pool must
+ * outlive its leases.
+ */
+class BundlePool
+{
+public:
+  using PointCloud = Bundle::PointCloud;
+
+  class Release
+  {
+  public:
+    Release() = default;
+    Release(BundlePool* pool, size_t leased_capacity) : pool_{ pool }, leased_capacity_{ leased_capacity }
+    {
+    }
+
+    void operator()(Bundle* bundle) const;
+
+  private:
+    BundlePool* pool_ = nullptr;
+    size_t leased_capacity_ = 0;
+  };
+  using Lease = std::unique_ptr<Bundle, Release>;
+
+  // Counts since the pool was created, so that allocation regressions show up in diagnostics
+  struct Counters
+  {
+    size_t leases = 0;
+    size_t bundle_allocations = 0;  // Leases that found the pool empty and allocated a new bundle
+    size_t buffer_growths = 0;      // Leases whose bundle had to grow its buffers while in use
+  };
+
+  explicit BundlePool(int range_image_columns);
+
+  /**
+   * Returns a bundle reset to raw_pointcloud, reusing a returned bundle if there is one
+   */
+  Lease lease(const PointCloud::ConstPtr& raw_pointcloud);
+
+  Counters counters() const;
+
+private:
+  int range_image_columns_;
+
+  mutable std::mutex mutex_;
+  std::vector<std::unique_ptr<Bundle>> free_bundles_;
+  Counters counters_;
+
+  void release(Bundle* bundle, size_t leased_capacity);
+};
+}  // namespace pointcloud_filter
+
+#endif  // SRC_BUNDLE_POOL_H
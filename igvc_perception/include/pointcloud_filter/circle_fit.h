@@ -0,0 +1,47 @@
+#ifndef SRC_CIRCLE_FIT_H
+#define SRC_CIRCLE_FIT_H
+
+#include <vector>
+
+#include <Eigen/Core>
+
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+
+namespace pointcloud_filter
+{
+struct CircleFitParams
+{
+  double min_radius = 0.0;
+  double max_radius = 0.0;
+  // Largest distance from the circle of an inlier (m)
+  double distance_threshold = 0.0;
+  // Fewest inliers, as a fraction of the points, for the fit to succeed
+  double min_inlier_ratio = 0.0;
+  // Most RANSAC iterations. Fewer are run once enough inliers are found to be confident in the best circle
+  int max_iterations = 0;
+  double confidence = 0.99;
+};
+
+struct Circle
+{
+  Eigen::Vector2f center;
+  float radius = 0.0f;
+};
+
+/**
+ * Fits a circle to the points at indices of cloud projected onto the xy plane, such as the side of an upright barrel.
+ *
+ * The circle is first fit to every point with algebraic least squares. Then up to max_iterations circles through three
+ * random points are tried. Each iteration shrinks the number of iterations needed for confidence that an
+ * outlier-free sample has been drawn, so that a cluster that is already well fit stops after a few. The best circle is
+ * refit to its inliers with least squares.
+ *
+ * @param inliers set to the positions in indices of the inliers of circle
+ * @return whether a circle within the radius limits with enough inliers was found
+ */
+bool fitCircle(const pcl::PointCloud<pcl::PointXYZ>& cloud, const std::vector<int>& indices,
+               const CircleFitParams& params, Circle& circle, std::vector<int>& inliers);
+}  // namespace pointcloud_filter
+
+#endif  // SRC_CIRCLE_FIT_H
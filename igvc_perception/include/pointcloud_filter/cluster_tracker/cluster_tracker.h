@@ -0,0 +1,129 @@
+#ifndef SRC_CLUSTER_TRACKER_H
+#define SRC_CLUSTER_TRACKER_H
+
+#include <vector>
+
+#include <Eigen/Geometry>
+
+#include <igvc_utils/transform_cache.h>
+#include <pointcloud_filter/cluster_tracker/cluster_tracker_config.h>
+#include <std_msgs/ColorRGBA.h>
+
+namespace pointcloud_filter
+{
+/**
+ * Associates the clusters of consecutive clouds, so that each obstacle keeps the same id, and so that expensive
+ * per-cluster fits are only recomputed when the cluster has changed.
+ *
+ * The centroids are moved into the fixed frame of the transform cache, so that the robot's motion doesn't move them.
+ * Each cluster is then associated with the nearest track within gate_distance, nearest pairs first, and clusters
+ * without a track start a new one. Tracks without a cluster for more than max_missed_frames clouds are dropped.
+ *
+ * A fit is a list of coefficients, as in pcl::ModelCoefficients, that the caller expresses in the fixed frame. It's
+ * reused for as long as the cluster's centroid and number of points stay close to what they were when it was made.
+ */
+class ClusterTracker
+{
+public:
+  // Summary of one cluster of a cloud
+  struct Observation
+  {
+    Eigen::Vector3f centroid;  // In the frame of the cloud
+    size_t num_points = 0;
+  };
+
+  struct Track
+  {
+    int id = 0;
+    Eigen::Vector3f centroid;  // In the fixed frame
+    size_t num_points = 0;
+    int missed_frames = 0;
+
+    bool has_fit = false;
+    std::vector<float> fit;
+    Eigen::Vector3f fit_centroid;
+    size_t fit_num_points = 0;
+    int fit_age = 0;
+  };
+
+  ClusterTracker(const ros::NodeHandle& nh, igvc::TransformCache* transform_cache);
+
+  /**
+   * Associates the clusters of a cloud with the tracks
+   * @param frame frame of the cloud
+   * @param stamp time of the cloud
+   * @return index in tracks() of the track of each observation, valid until the next update
+   */
+  const std::vector<size_t>& update(const std::string& frame, const ros::Time& stamp,
+                                    const std::vector<Observation>& observations);
+
+  const std::vector<Track>& tracks() const
+  {
+    return tracks_;
+  }
+
+  /**
+   * Transform from the frame of the last cloud to the fixed frame. Falls back to the last transform that was found,
+   * or the identity, if the lookup fails.
+   */
+  const Eigen::Isometry3f& fixedFromCloud() const
+  {
+    return fixed_from_cloud_;
+  }
+
+  /**
+   * Returns the fit of the track if it can be reused for its current cluster, or nullptr if it has to be recomputed.
+   * An empty fit records that fitting failed, so that it isn't retried on every cloud either.
+   */
+  const std::vector<float>* cachedFit(size_t track_index);
+
+  /**
+   * Stores a new fit for the track's current cluster
+   */
+  void setFit(size_t track_index, std::vector<float> fit);
+
+  /**
+   * Returns a color for id that is the same on every cloud, and far from the colors of nearby ids
+   */
+  static std_msgs::ColorRGBA color(int id);
+
+  size_t fitsReused() const
+  {
+    return fits_reused_;
+  }
+
+  size_t fitsComputed() const
+  {
+    return fits_computed_;
+  }
+
+private:
+  // Candidate association of an observation with a track
+  struct Pair
+  {
+    float distance_squared;
+    size_t observation;
+    size_t track;
+  };
+
+  ClusterTrackerConfig config_;
+  igvc::TransformCache* transform_cache_;
+  Eigen::Isometry3f fixed_from_cloud_ = Eigen::Isometry3f::Identity();
+
+  std::vector<Track> tracks_;
+  int next_id_ = 0;
+
+  // Kept between clouds to avoid allocating
+  std::vector<size_t> assignments_;
+  std::vector<Eigen::Vector3f> centroids_;
+  std::vector<Pair> pairs_;
+  std::vector<bool> track_matched_;
+
+  size_t fits_reused_ = 0;
+  size_t fits_computed_ = 0;
+
+  void lookupFixedFrame(const std::string& frame, const ros::Time& stamp);
+};
+}  // namespace pointcloud_filter
+
+#endif  // SRC_CLUSTER_TRACKER_H
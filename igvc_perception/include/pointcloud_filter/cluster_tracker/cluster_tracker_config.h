@@ -0,0 +1,27 @@
+#ifndef SRC_CLUSTER_TRACKER_CONFIG_H
+#define SRC_CLUSTER_TRACKER_CONFIG_H
+
+#include <ros/ros.h>
+
+namespace pointcloud_filter
+{
+struct ClusterTrackerConfig
+{
+  // Largest distance between the centroids of a cluster and a track for them to be associated (m)
+  double gate_distance = 0.0;
+  // Frames a track is kept without a cluster before it's dropped
+  int max_missed_frames = 0;
+  // A fit is recomputed once the centroid has moved this far since it was made (m)
+  double refit_distance = 0.0;
+  // A fit is recomputed once the number of points has changed by this fraction since it was made
+  double refit_size_ratio = 0.0;
+  // A fit is recomputed after being reused for this many frames, so that a bad fit doesn't stick
+  int max_fit_age = 0;
+  // Timeout of the lookup of the fixed frame (s)
+  double timeout_duration = 0.0;
+
+  explicit ClusterTrackerConfig(const ros::NodeHandle& nh);
+};
+}  // namespace pointcloud_filter
+
+#endif  // SRC_CLUSTER_TRACKER_CONFIG_H
@@ -2,8 +2,11 @@
 #define GROUNDSEGMENTER_H
 
 #include <math.h>
+#include <limits>
 #include <pcl/point_cloud.h>
 #include <pcl_ros/point_cloud.h>
+#include <igvc_utils/lazy_publisher.h>
+#include <igvc_utils/thread_pool.h>
 #include <pointcloud_filter/fast_segment_filter/fast_segment_filter_config.h>
 #include <pointcloud_filter/filter.h>
 #include "pointcloud_filter/point_types.h"
@@ -36,8 +39,11 @@ struct Prototype
  * A struct to represent a line over the form:
  *   slope_ * t + intercept_
  * where t is a parameter.
- * The slope and intercept define the line. The slope is defined from a least squares approach using SVD.
- * And the intercept is defined as the mean of the points used to estimate the slope.
+ * The slope and intercept define the line. The slope is the least squares direction, ie. the principal eigenvector of
+ * the scatter matrix of the points, and the intercept is the mean of the points. The sum and the sum of outer
+ * products of the points are kept so that adding a point doesn't need to revisit the others.
+ * A line is fit to a run of consecutive prototype points of its segment, so it refers to its model points by their
+ * range in the segment's prototype_points_ instead of keeping a copy.
  */
 
 struct Line
@@ -47,11 +53,15 @@ struct Line
   Prototype start_point_ = {};
   Prototype end_point_ = {};
   double error_t_ = 0.0;
-  std::vector<Prototype> model_points_ = {};
+  size_t first_point_ = 0;  // Index of the first model point in the segment's prototype_points_
+  size_t num_points_ = 0;   // Number of model points
+  float max_z_ = -std::numeric_limits<float>::infinity();  // Highest z of the model points
   bool is_ground_ = false;
+  Eigen::Vector3d sum_ = Eigen::Vector3d::Zero();
+  Eigen::Matrix3d sum_outer_ = Eigen::Matrix3d::Zero();
 
   Line() = default;
-  Line(double threshold) : error_t_(threshold)
+  Line(double threshold, size_t first_point) : error_t_(threshold), first_point_(first_point)
   {
   }
 
@@ -59,10 +69,12 @@ struct Line
 
   /**
    * Considers new_point in addition to existing model_points, it then
-   * creates a model of a line using a least squares approach given these points.
+   * creates a model of a line using a least squares approach given these points,
+   * in constant time from the running sums of the points.
    * If the new model has too much error, new_point is not added to model_points
    * and attemptFitPoint returns false.
    * Else new_point is added to model_points and attemptFitPoint returns true.
+   * new_point must be the prototype point right after the current model points.
    *
    * @param new_point A new point to be used with model_points to estimate a line
    * @return True if new_point + model_points create a line without too much error
@@ -70,21 +82,24 @@ struct Line
    *
    */
   bool attemptFitPoint(const Prototype &new_point);
+};
 
-  /**
-   * Computes a slope and intercept for the line given a set of points. Uses SVD
-   * to compute the slope and uses the mean of the points as the intercept.
-   *
-   * @param A Matrix representing the sample points to fit the line/get slope from
-   * @param mean Matrix that is a 3d point which is the mean of all the sample points
-   *
-   */
-  void getSlopeIntercept(const Eigen::MatrixXd &A, const Eigen::MatrixXd &mean);
+/**
+ * Candidate prototype point for one ring of one segment: the lowest point seen so far
+ */
+struct PrototypeCell
+{
+  static constexpr int empty = -1;
+
+  float min_z = 0.0f;
+  int point = empty;  // Index of the point in its segment's raw_points_, or empty if the ring has no points
 };
 
 struct Segment
 {
   std::vector<velodyne_pcl::PointXYZIRT> raw_points_;
+  std::vector<int> raw_indices_;  // Index of each raw point in the bundle's raw pointcloud
+  std::vector<uint8_t> is_ground_;  // Classification of each raw point
   std::vector<Prototype> prototype_points_;
   std::vector<Line> lines_;
 };
@@ -94,13 +109,12 @@ class FastSegmentFilter
 public:
   FastSegmentFilter(const ros::NodeHandle &nh);
 
-  std::unordered_map<int, Segment> segments_;
-  pcl::PointCloud<velodyne_pcl::PointXYZIRT> ground_points_;
-  pcl::PointCloud<velodyne_pcl::PointXYZIRT> nonground_points_;
+  std::vector<Segment> segments_;  // Indexed by segment id, reused between scans
+  std::vector<PrototypeCell> prototype_cells_;  // num_segments x num_rings, indexed by segment id then ring
 
-  ros::Publisher ground_pub_;
-  ros::Publisher nonground_pub_;
-  ros::Publisher marker_pub_;
+  igvc::LazyPublisher<pcl::PointCloud<velodyne_pcl::PointXYZIRT>> ground_pub_;
+  igvc::LazyPublisher<pcl::PointCloud<velodyne_pcl::PointXYZIRT>> nonground_pub_;
+  igvc::LazyPublisher<visualization_msgs::MarkerArray> marker_pub_;
   std::string ground_topic_;
   std::string nonground_topic_;
   std::string velodyne_topic_;
@@ -110,10 +124,24 @@ public:
   void filter(pointcloud_filter::Bundle &bundle);
 
   /**
-   * This function goes through each segment and for each:
-   *   -Split the points into bins based on lidar ring.
-   *   -For each bin, pick one point to be the prototype point, to be used for
-   *    fitting lines within the segment.
+   * Uses num_segments / divisor segments from the next scan on, to trade accuracy for time under load
+   */
+  void setSegmentDivisor(int divisor);
+
+  /**
+   * Enables or disables the outputs that are only used for debugging: the ground cloud and the line markers
+   */
+  void setDebugOutput(bool enabled);
+
+  /**
+   * Number of threads that process the segments of a scan, including the calling thread
+   */
+  size_t numThreads() const;
+
+  /**
+   * This function goes through each segment and for each ring, takes the lowest point of the ring in the segment as
+   * the prototype point, to be used for fitting lines within the segment. The lowest points are tracked in
+   * prototype_cells_ while the points are binned into segments.
    */
   void computePrototypePoints();
 
@@ -135,19 +163,37 @@ public:
    * point as ground or nonground based on whether the closest line to it is
    * ground or nonground
    *
-   * @param ground_points Output parameter for determined ground points
-   * @param nonground_points Output parameter for determined nonground points
+   * @param ground_points Optional output parameter for determined ground points
+   * @param nonground_points Optional output parameter for determined nonground points
+   * @param nonground_indices Optional output parameter for the pointcloud indices of nonground_points
    *
    */
 
-  void classifyPoints(pcl::PointCloud<velodyne_pcl::PointXYZIRT> &ground_points,
-                      pcl::PointCloud<velodyne_pcl::PointXYZIRT> &nonground_points);
-  void debugViz();
+  void classifyPoints(pcl::PointCloud<velodyne_pcl::PointXYZIRT> *ground_points,
+                      pcl::PointCloud<velodyne_pcl::PointXYZIRT> *nonground_points,
+                      std::vector<int> *nonground_indices = nullptr);
+
+  /**
+   * Markers for the prototype points and lines of every segment, colored by whether the line is ground
+   */
+  visualization_msgs::MarkerArray debugViz() const;
 
 private:
   FastSegmentFilterConfig config_{};
+  int num_segments_ = 0;
+  bool debug_output_ = true;
+  int num_rings_ = 0;
+  // Segments are independent, so each stage processes them in parallel
+  igvc::ThreadPool thread_pool_;
 
-  int getSegIdFromPoint(const velodyne_pcl::PointXYZIRT point);
+  /**
+   * Clears the segments and prototype cells for a new scan, keeping their memory
+   */
+  void resetSegments(int num_rings);
+  void computePrototypePoints(size_t segment_id);
+  void getLinesFromSegment(Segment &seg);
+  void classifySegment(Segment &segment);
+  int getSegIdFromAzimuth(double azimuth) const;
   double getDistanceFromPoint(const velodyne_pcl::PointXYZIRT point);
   double getDistanceBetweenPoints(const velodyne_pcl::PointXYZIRT point1, const velodyne_pcl::PointXYZIRT point2);
   bool evaluateIsGround(Line &l);
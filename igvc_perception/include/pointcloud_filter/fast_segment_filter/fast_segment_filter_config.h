@@ -14,6 +14,7 @@ struct FastSegmentFilterConfig
   std::string ground_topic;
   std::string nonground_topic;
   bool debug_viz;
+  int num_threads;
 
   FastSegmentFilterConfig() = default;
   FastSegmentFilterConfig(const ros::NodeHandle& nh);
@@ -20,6 +20,7 @@ public:
 
 private:
   GroundFilterConfig config_{};
+  std::vector<uint8_t> within_thresholds_;  // Kept between scans to reuse its capacity
 };
 }  // namespace pointcloud_filter
 
@@ -0,0 +1,68 @@
+#ifndef SRC_LOAD_SHEDDER_H
+#define SRC_LOAD_SHEDDER_H
+
+#include <mutex>
+
+#include <pointcloud_filter/bundle.h>
+#include <pointcloud_filter/load_shedder/load_shedder_config.h>
+
+namespace pointcloud_filter
+{
+/**
+ * Picks how much work to do on each scan so that the pipeline keeps up when the CPU is saturated. The cost of each
+ * processed scan is smoothed into a moving average. While the average is over budget_ms the level goes up one step,
+ * and once it's under recover_ratio * budget_ms it comes back down one step. After each change the level is held for
+ * hold_frames scans, so that the average catches up with the new cost before it is judged again.
+ *
+ * Each level also applies the degradations of the levels below it.
+ */
+class LoadShedder
+{
+public:
+  enum Level
+  {
+    full_quality = 0,
+    subsampled_columns = 1,  // Keep only every column_stride-th column of the range image
+    coarse_segments = 2,     // Divide the number of FastSegmentFilter segments by segment_divisor
+    no_debug_output = 3,     // Skip outputs that are only used for debugging
+    num_levels
+  };
+
+  explicit LoadShedder(const ros::NodeHandle& nh);
+
+  /**
+   * Level for the next scan. Always full_quality if load shedding is disabled.
+   */
+  Level level() const;
+
+  /**
+   * Records the processing time of a scan (ms), and changes the level if needed
+   */
+  void recordFrame(double frame_ms);
+
+  double averageMs() const;
+
+  const LoadShedderConfig& config() const
+  {
+    return config_;
+  }
+
+  /**
+   * Removes the points of bundle's indices that aren't in every column_stride-th column of its range image
+   */
+  void subsample(Bundle& bundle) const;
+
+  static const char* levelName(Level level);
+
+private:
+  LoadShedderConfig config_;
+
+  mutable std::mutex mutex_;
+  Level level_ = full_quality;
+  double average_ms_ = 0.0;
+  bool has_average_ = false;
+  int frames_since_change_ = 0;
+};
+}  // namespace pointcloud_filter
+
+#endif  // SRC_LOAD_SHEDDER_H
@@ -0,0 +1,22 @@
+#ifndef SRC_LOAD_SHEDDER_CONFIG_H
+#define SRC_LOAD_SHEDDER_CONFIG_H
+
+#include <ros/ros.h>
+
+namespace pointcloud_filter
+{
+struct LoadShedderConfig
+{
+  bool enabled = false;
+  double budget_ms = 0.0;
+  double smoothing = 0.0;
+  double recover_ratio = 0.0;
+  int hold_frames = 0;
+  int column_stride = 1;
+  int segment_divisor = 1;
+
+  explicit LoadShedderConfig(const ros::NodeHandle& nh);
+};
+}  // namespace pointcloud_filter
+
+#endif  // SRC_LOAD_SHEDDER_CONFIG_H
@@ -0,0 +1,63 @@
+#ifndef SRC_POINT_BUFFER_H
+#define SRC_POINT_BUFFER_H
+
+#include <vector>
+
+#include <pcl/point_cloud.h>
+#include "pointcloud_filter/point_types.h"
+
+namespace pointcloud_filter
+{
+/**
+ * Structure of arrays copy of a Velodyne pointcloud, with each field stored contiguously so that the kernels in
+ * point_kernels.h can process 8 points per instruction.
+ */
+struct PointBuffer
+{
+  using PointCloud = pcl::PointCloud<velodyne_pcl::PointXYZIRT>;
+
+  std::vector<float> x;
+  std::vector<float> y;
+  std::vector<float> z;
+  std::vector<float> intensity;
+  std::vector<uint16_t> ring;
+  std::vector<float> time;
+
+  PointBuffer() = default;
+  explicit PointBuffer(const PointCloud& pointcloud);
+
+  size_t size() const
+  {
+    return x.size();
+  }
+
+  void resize(size_t size);
+
+  /**
+   * Replaces the points with those of pointcloud, reusing the capacity of the fields
+   */
+  void assign(const PointCloud& pointcloud);
+
+  /**
+   * Size in bytes of the memory held by the fields
+   */
+  size_t capacityBytes() const;
+
+  /**
+   * Returns the points with the given indices, in order
+   */
+  PointBuffer select(const std::vector<int>& indices) const;
+
+  /**
+   * Writes the points with the given indices to selected, in order, reusing its capacity
+   */
+  void select(const std::vector<int>& indices, PointBuffer& selected) const;
+
+  /**
+   * Writes the points to pointcloud's points, leaving its header untouched
+   */
+  void toPointCloud(PointCloud& pointcloud) const;
+};
+}  // namespace pointcloud_filter
+
+#endif  // SRC_POINT_BUFFER_H
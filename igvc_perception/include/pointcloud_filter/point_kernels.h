@@ -0,0 +1,42 @@
+#ifndef SRC_POINT_KERNELS_H
+#define SRC_POINT_KERNELS_H
+
+#include <Eigen/Geometry>
+
+#include <pointcloud_filter/point_buffer.h>
+
+namespace pointcloud_filter
+{
+/**
+ * Kernels over PointBuffer fields. On x86 CPUs that support AVX2 they process 8 points at a time, otherwise they fall
+ * back to plain loops. The CPU is checked at runtime, so that the AVX2 versions are built without any special flags.
+ */
+namespace kernels
+{
+/**
+ * Applies transform to the positions of points in place
+ */
+void transform(const Eigen::Isometry3f& transform, PointBuffer& points);
+
+/**
+ * Computes the range in the xy plane and the azimuth in [-pi, pi] of count points. The azimuth is a polynomial
+ * approximation of atan2, accurate to about 2e-5 rad, which both the AVX2 and plain versions use so that the results
+ * don't depend on the CPU.
+ */
+void rangeAzimuth(const float* x, const float* y, size_t count, float* range, float* azimuth);
+
+/**
+ * Computes the angle above the xy plane of the segment from point i of (x0, y0, z0) to point i of (x1, y1, z1) for
+ * each of the count pairs, in [-pi/2, pi/2]. This uses the same approximation of atan2 as rangeAzimuth.
+ */
+void inclination(const float* x0, const float* y0, const float* z0, const float* x1, const float* y1, const float* z1,
+                 size_t count, float* angle);
+
+/**
+ * Clears mask[i] for each of the count values that isn't in [min, max]
+ */
+void maskInRange(const float* values, size_t count, float min, float max, uint8_t* mask);
+}  // namespace kernels
+}  // namespace pointcloud_filter
+
+#endif  // SRC_POINT_KERNELS_H
@@ -1,23 +1,29 @@
 #ifndef SRC_POINTCLOUD_FILTER_H
 #define SRC_POINTCLOUD_FILTER_H
 
-#include <pointcloud_filter/back_filter/back_filter.h>
-#include <pointcloud_filter/fast_segment_filter/fast_segment_filter.h>
-#include <pointcloud_filter/ground_filter/ground_filter.h>
+#include <diagnostic_updater/diagnostic_updater.h>
+#include <igvc_utils/transform_cache.h>
 #include <pointcloud_filter/pointcloud_filter_config.h>
-#include <pointcloud_filter/radius_filter/radius_filter.h>
-#include <pointcloud_filter/raycast_filter/raycast_filter.h>
-#include <pointcloud_filter/tf_transform_filter/tf_transform_filter.h>
+#include <pointcloud_filter/scan_merger/scan_merger.h>
+#include <pointcloud_filter/sensor_pipeline/sensor_pipeline.h>
 #include <ros/ros.h>
-#include <tf/transform_listener.h>
+#include <memory>
+#include <vector>
+#include <tf2_ros/transform_listener.h>
 
 namespace pointcloud_filter
 {
+/**
+ * Filters the scans of one or more lidars into the occupied points and free space used by the mapper.
+ *
+ * Without a sensors parameter, a single lidar is configured in the pointcloud_filter namespace itself, and a
+ * SensorPipeline publishes its output directly. With sensors, each name in the list is the namespace of one lidar,
+ * which gets its own SensorPipeline and thread, and a ScanMerger combines their output into a single update per
+ * cycle. Every pipeline and the merger publish their own diagnostics.
+ */
 class PointcloudFilter
 {
 public:
-  using PointCloud = pcl::PointCloud<velodyne_pcl::PointXYZIRT>;
-
   PointcloudFilter(const ros::NodeHandle& nh = {}, const ros::NodeHandle& private_nh = { "~" });
 
 private:
@@ -27,24 +33,17 @@ private:
 
   tf2_ros::Buffer buffer_;
   tf2_ros::TransformListener listener_;
+  igvc::TransformCache transform_cache_;
 
-  BackFilter back_filter_;
-  RadiusFilter radius_filter_;
-  TFTransformFilter tf_transform_filter_;
-  GroundFilter ground_filter_;
-  RaycastFilter raycast_filter_;
-  FastSegmentFilter fast_segment_filter_;
-
-  ros::Subscriber raw_pointcloud_sub_;
-
-  ros::Publisher transformed_pointcloud_pub_;
-  ros::Publisher occupied_pointcloud_pub_;
-  ros::Publisher free_pointcloud_pub_;
+  // Declared before the pipelines, which add their scans to it until they're destroyed
+  std::unique_ptr<ScanMerger> merger_;
+  std::vector<std::unique_ptr<SensorPipeline>> sensors_;
 
-  ros::Publisher filtered_pointcloud_pub_;
+  // Declared after the pipelines and the merger, so that their diagnostics stop before they're destroyed
+  diagnostic_updater::Updater updater_;
+  ros::Timer diagnostics_timer_;
 
-  void setupPubSub();
-  void pointcloudCallback(const PointCloud::ConstPtr& raw_pointcloud);
+  void setupSensors();
 };
 }  // namespace pointcloud_filter
 
@@ -0,0 +1,71 @@
+#ifndef SRC_PREDICATE_PIPELINE_H
+#define SRC_PREDICATE_PIPELINE_H
+
+#include <algorithm>
+#include <array>
+#include <tuple>
+
+#include <pointcloud_filter/bundle.h>
+
+namespace pointcloud_filter
+{
+/**
+ * Runs point predicates over the selected points of a bundle in a single pass, keeping the points that pass all of
+ * them, in order. Each predicate needs a
+ *
+ *   void mask(const PointBuffer& points, const RangeImage& range_image, size_t begin, size_t count,
+ *             uint8_t* mask) const;
+ *
+ * that clears mask[i] for each point begin + i it rejects, for i in [0, count). The points are processed in blocks
+ * small enough to stay in cache, so every predicate sees a block before the pass moves on, and the predicates can use
+ * the vectorized kernels in point_kernels.h over the contiguous fields of the block. Since the predicates are known
+ * at compile time, the calls are inlined instead of each filter doing its own pass and copying the points that
+ * survive.
+ */
+template <typename... Predicates>
+class PredicatePipeline
+{
+public:
+  explicit PredicatePipeline(Predicates... predicates) : predicates_{ std::move(predicates)... }
+  {
+  }
+
+  void filter(Bundle& bundle) const
+  {
+    const RangeImage& range_image = bundle.rangeImage();
+    const PointBuffer& points = bundle.points;
+
+    // indices is sorted, so each block only needs to look at the next run of indices
+    auto& indices = bundle.indices;
+    auto in = indices.begin();
+    auto out = indices.begin();
+    std::array<uint8_t, block_size> mask;
+    for (size_t begin = 0; begin < points.size() && in != indices.end(); begin += block_size)
+    {
+      const size_t count = std::min(block_size, points.size() - begin);
+      std::fill_n(mask.begin(), count, 1);
+      std::apply(
+          [&](const Predicates&... predicates) {
+            (predicates.mask(points, range_image, begin, count, mask.data()), ...);
+          },
+          predicates_);
+
+      for (; in != indices.end() && static_cast<size_t>(*in) < begin + count; ++in)
+      {
+        if (mask[*in - begin])
+        {
+          *out++ = *in;
+        }
+      }
+    }
+    indices.erase(out, indices.end());
+  }
+
+private:
+  static constexpr size_t block_size = 1024;
+
+  std::tuple<Predicates...> predicates_;
+};
+}  // namespace pointcloud_filter
+
+#endif  // SRC_PREDICATE_PIPELINE_H
@@ -4,22 +4,29 @@
 #include <pcl/point_cloud.h>
 #include "pointcloud_filter/point_types.h"
 
-#include <pointcloud_filter/filter.h>
 #include <pointcloud_filter/radius_filter/radius_filter_config.h>
+#include <pointcloud_filter/point_kernels.h>
+#include <pointcloud_filter/range_image.h>
 
 namespace pointcloud_filter
 {
-class RadiusFilter : Filter
+/**
+ * Predicate for PredicatePipeline that keeps points within a radius of the lidar in the xy plane
+ */
+class RadiusFilter
 {
 public:
-  using PointCloud = pcl::PointCloud<velodyne_pcl::PointXYZIRT>;
-
   explicit RadiusFilter(const ros::NodeHandle& nh);
 
-  void filter(Bundle& bundle) override;
+  void mask(const PointBuffer& /*points*/, const RangeImage& range_image, size_t begin, size_t count,
+            uint8_t* mask) const
+  {
+    kernels::maskInRange(range_image.ranges() + begin, count, 0.0f, max_radius_, mask);
+  }
 
 private:
   RadiusFilterConfig config_{};
+  float max_radius_ = 0.0f;
 };
 }  // namespace pointcloud_filter
 
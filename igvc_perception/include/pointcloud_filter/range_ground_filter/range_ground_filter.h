@@ -0,0 +1,98 @@
+#ifndef SRC_RANGE_GROUND_FILTER_H
+#define SRC_RANGE_GROUND_FILTER_H
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include <igvc_utils/lazy_publisher.h>
+#include <pointcloud_filter/filter.h>
+#include <pointcloud_filter/range_ground_filter/range_ground_filter_config.h>
+
+namespace pointcloud_filter
+{
+/**
+ * Ground segmentation on the ring x azimuth grid of a Velodyne scan, as done by range image methods such as
+ * depth_clustering. Each cell of the grid is represented by its lowest point, and the inclination from the nearest
+ * cell below it in the same column is computed for a whole ring at once. The lowest cell of each column starts a
+ * ground region if it is flat and below the lidar, and the regions are grown breadth first to the neighbouring cells
+ * that are flat and whose inclination is close to that of the ground cell they're reached from. That follows gentle
+ * slopes while stopping at the foot of obstacles, in linear time in the number of cells. The inclinations come from
+ * kernels::inclination, which is accurate to about 2e-5 rad, well below max_slope and max_angle_change, and gives the
+ * same angles with and without AVX2, so that a scan is labelled the same on every CPU.
+ *
+ * Sets occupied_indices to the nonground points of indices. Points without a return (NaN) leave their cell empty and
+ * are in neither output. The grids are kept between scans, so a scan doesn't allocate once they have grown to the
+ * size of the range image.
+ */
+class RangeGroundFilter : Filter
+{
+public:
+  explicit RangeGroundFilter(const ros::NodeHandle& nh);
+
+  void filter(Bundle& bundle) override;
+
+  /**
+   * Enables or disables the outputs that are only used for debugging: the ground cloud
+   */
+  void setDebugOutput(bool enabled);
+
+private:
+  using PointCloud = Bundle::PointCloud;
+
+  RangeGroundFilterConfig config_;
+  bool debug_output_ = true;
+  float cos_pitch_;
+  float sin_pitch_;
+
+  igvc::LazyPublisher<PointCloud> ground_pub_;
+  igvc::LazyPublisher<PointCloud> nonground_pub_;
+
+  int rings_ = 0;
+  int columns_ = 0;
+  // Grids indexed by ring * columns_ + column, so that the cells of a ring are contiguous. Positions are levelled by
+  // the pitch of the lidar, and are 0 for empty cells.
+  std::vector<int> cells_;  // Index of the lowest point of each cell, or RangeImage::empty
+  std::vector<float> x_;
+  std::vector<float> y_;
+  std::vector<float> z_;
+  std::vector<int> below_;  // Nearest non empty cell below in the same column, or RangeImage::empty
+  std::vector<int> above_;  // Nearest non empty cell above in the same column, or RangeImage::empty
+  std::vector<float> below_x_;  // Position of the below_ cell
+  std::vector<float> below_y_;
+  std::vector<float> below_z_;
+  std::vector<float> angle_;  // Inclination from the below_ cell (rad). The lowest cell takes that of the one above
+  std::vector<uint8_t> ground_;
+  std::vector<int> queue_;
+  std::vector<int> ground_indices_;
+
+  /**
+   * Keeps the lowest point of indices in each cell
+   */
+  void buildGrid(const Bundle& bundle, const RangeImage& range_image);
+
+  /**
+   * Links each cell to its nearest non empty neighbours in the same column and computes the inclinations
+   */
+  void computeAngles();
+
+  /**
+   * Seeds the ground with the lowest cell of each column and grows it breadth first
+   */
+  void labelGround();
+
+  bool isGroundNeighbour(int from, int to) const;
+
+  static bool hasReturn(const PointBuffer& points, int index)
+  {
+    return std::isfinite(points.x[index]) && std::isfinite(points.y[index]) && std::isfinite(points.z[index]);
+  }
+
+  float levelZ(const PointBuffer& points, int index) const
+  {
+    return cos_pitch_ * points.z[index] - sin_pitch_ * points.x[index];
+  }
+};
+}  // namespace pointcloud_filter
+
+#endif  // SRC_RANGE_GROUND_FILTER_H
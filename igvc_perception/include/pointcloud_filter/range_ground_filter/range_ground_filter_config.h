@@ -0,0 +1,27 @@
+#ifndef SRC_RANGE_GROUND_FILTER_CONFIG_H
+#define SRC_RANGE_GROUND_FILTER_CONFIG_H
+
+#include <ros/ros.h>
+
+namespace pointcloud_filter
+{
+struct RangeGroundFilterConfig
+{
+  std::string ground_topic;
+  std::string nonground_topic;
+  // Steepest inclination between consecutive rings that is still ground (rad)
+  double max_slope = 0.17;
+  // Largest change of inclination between neighbouring ground cells (rad)
+  double max_angle_change = 0.09;
+  // Only the lowest cell of a column that is below this height relative to the lidar starts a ground region (m)
+  double seed_max_z = 0.0;
+  // Points of a ground cell that are higher than this above its lowest point are nonground (m)
+  double max_cell_height = 0.1;
+  // Pitch of the lidar relative to the ground, to measure the inclinations from the horizontal (rad)
+  double pitch = 0.0;
+
+  explicit RangeGroundFilterConfig(const ros::NodeHandle& nh);
+};
+}  // namespace pointcloud_filter
+
+#endif  // SRC_RANGE_GROUND_FILTER_CONFIG_H
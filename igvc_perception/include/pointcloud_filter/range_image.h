@@ -0,0 +1,102 @@
+#ifndef SRC_RANGE_IMAGE_H
+#define SRC_RANGE_IMAGE_H
+
+#include <pointcloud_filter/point_buffer.h>
+
+namespace pointcloud_filter
+{
+/**
+ * Polar view of a Velodyne scan, indexed by ring and azimuth column. The polar coordinates of each point are computed
+ * once when the image is built, so that filters don't need to recompute them.
+ *
+ * Everything is in the frame of the points the image was built from, ie. the lidar frame.
+ */
+class RangeImage
+{
+public:
+  static constexpr int empty = -1;
+
+  RangeImage() = default;
+  RangeImage(const PointBuffer& points, int num_columns);
+
+  /**
+   * Rebuilds the image from points, reusing the memory of the previous image
+   */
+  void build(const PointBuffer& points, int num_columns);
+
+  /**
+   * Size in bytes of the memory held by the image
+   */
+  size_t capacityBytes() const;
+
+  /**
+   * Azimuth of the point with index i, in [-pi, pi] (rad)
+   */
+  float azimuth(size_t i) const
+  {
+    return azimuth_[i];
+  }
+
+  /**
+   * Range of the point with index i in the xy plane (m)
+   */
+  float range(size_t i) const
+  {
+    return range_[i];
+  }
+
+  const float* azimuths() const
+  {
+    return azimuth_.data();
+  }
+
+  const float* ranges() const
+  {
+    return range_.data();
+  }
+
+  int column(size_t i) const
+  {
+    return column_[i];
+  }
+
+  int rings() const
+  {
+    return rings_;
+  }
+
+  int columns() const
+  {
+    return columns_;
+  }
+
+  size_t size() const
+  {
+    return azimuth_.size();
+  }
+
+  /**
+   * Returns the index of the closest point in the cell at (ring, column), or empty if there is none
+   */
+  int at(int ring, int column) const
+  {
+    return image_[ring * columns_ + column];
+  }
+
+  /**
+   * Returns the column that contains azimuth
+   */
+  int columnFromAzimuth(double azimuth) const;
+
+private:
+  int rings_ = 0;
+  int columns_ = 0;
+
+  std::vector<float> azimuth_;
+  std::vector<float> range_;
+  std::vector<int> column_;
+  std::vector<int> image_;
+};
+}  // namespace pointcloud_filter
+
+#endif  // SRC_RANGE_IMAGE_H
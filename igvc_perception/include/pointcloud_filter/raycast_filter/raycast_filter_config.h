@@ -12,6 +12,7 @@ struct RaycastFilterConfig
   double start_angle = 0.0;
   double end_angle = 0.0;
   double min_range = 0.0;
+  bool include_occupied = false;
 
   explicit RaycastFilterConfig(const ros::NodeHandle& nh);
 };
@@ -0,0 +1,112 @@
+#ifndef SRC_SCAN_MERGER_H
+#define SRC_SCAN_MERGER_H
+
+#include <mutex>
+#include <vector>
+
+#include <Eigen/Geometry>
+
+#include <diagnostic_updater/diagnostic_updater.h>
+#include <igvc_msgs/polar_scan.h>
+#include <igvc_utils/lazy_publisher.h>
+#include <igvc_utils/transform_cache.h>
+#include <pcl/point_cloud.h>
+#include <pcl_ros/point_cloud.h>
+#include <pointcloud_filter/point_types.h>
+#include <pointcloud_filter/pointcloud_filter_config.h>
+#include <pointcloud_filter/scan_merger/scan_merger_config.h>
+
+namespace pointcloud_filter
+{
+/**
+ * Merges the scans of several lidars into one occupied cloud and one free scan in base_frame, so that the mapper gets
+ * a single update per cycle instead of one per lidar.
+ *
+ * A cycle is published as soon as every lidar has added a scan to it. A lidar that adds a second scan before then
+ * closes the cycle early with the scans it has, so that a slow or stopped lidar doesn't hold up the others. Scans more
+ * than max_offset older than the newest scan of their cycle are dropped, and the others are moved to the time of the
+ * newest one using the odometry poses of the transform cache, if it has them.
+ *
+ * The free scan is binned around the origin of base_frame, so the free rays of a lidar away from the origin are
+ * approximated by the rays from the origin to their ends. A bin is free if at least one lidar has it free and no lidar
+ * has an occupied point in it, out to the shortest of the free ranges.
+ */
+class ScanMerger
+{
+public:
+  using PointCloud = pcl::PointCloud<velodyne_pcl::PointXYZIRT>;
+
+  // Free space of one bin of a lidar's polar scan, from the origin of base_frame
+  struct FreeRay
+  {
+    Eigen::Vector2f first_end;   // End of the ray along the first edge of the bin
+    Eigen::Vector2f second_end;  // End of the ray along the second edge of the bin
+  };
+
+  // Scan of one lidar, in base_frame at stamp
+  struct SensorScan
+  {
+    ros::Time stamp;
+    PointCloud occupied;
+    std::vector<FreeRay> free_rays;
+    // Distance from the origin of base_frame beyond which the free rays are known to be free
+    float min_range = 0.0f;
+
+    /**
+     * Replaces free_rays with the free bins of free_scan, a polar scan in the frame of the lidar
+     */
+    void setFreeSpace(const igvc_msgs::polar_scan& free_scan, const Eigen::Isometry3d& base_from_lidar);
+
+    /**
+     * Swaps the buffers of the two scans without copying them
+     */
+    void swap(SensorScan& other);
+  };
+
+  ScanMerger(const ros::NodeHandle& nh, const ros::NodeHandle& private_nh, const PointcloudFilterConfig& config,
+             size_t num_sensors, igvc::TransformCache* transform_cache);
+
+  /**
+   * Adds the scan of sensor, publishing the cycle if it's complete. Can be called from any thread.
+   *
+   * scan is swapped with the merger's buffer for sensor, so that the caller gets back the buffers of an earlier scan
+   * to fill next time instead of allocating new ones.
+   */
+  void add(size_t sensor, SensorScan& scan);
+
+  void diagnostic(diagnostic_updater::DiagnosticStatusWrapper& stat);
+
+private:
+  ScanMergerConfig config_;
+  std::string base_frame_;
+  igvc::TransformCache* transform_cache_;
+
+  igvc::LazyPublisher<PointCloud> occupied_pub_;
+  igvc::LazyPublisher<igvc_msgs::polar_scan> free_pub_;
+
+  std::mutex mutex_;
+  std::vector<SensorScan> pending_;
+  std::vector<bool> has_pending_;
+
+  // Counts since the last diagnostics update
+  size_t cycles_ = 0;
+  size_t merged_scans_ = 0;
+  size_t stale_scans_ = 0;
+
+  /**
+   * Publishes the pending scans as one cycle and clears them. mutex_ must be held.
+   */
+  void publishCycle();
+
+  /**
+   * Returns the motion of base_frame from from to to, or the identity if the transform cache has no odometry for them
+   */
+  Eigen::Isometry3f motionBetween(const ros::Time& from, const ros::Time& to) const;
+
+  void addFreeSpace(const SensorScan& scan, const Eigen::Isometry3f& motion, igvc_msgs::polar_scan& merged) const;
+  int numBins() const;
+  int discretize(float angle) const;
+};
+}  // namespace pointcloud_filter
+
+#endif  // SRC_SCAN_MERGER_H
@@ -0,0 +1,17 @@
+#ifndef SRC_SCAN_MERGER_CONFIG_H
+#define SRC_SCAN_MERGER_CONFIG_H
+
+#include <ros/ros.h>
+
+namespace pointcloud_filter
+{
+struct ScanMergerConfig
+{
+  double max_offset = 0.0;
+  double angular_resolution = 0.0;
+
+  explicit ScanMergerConfig(const ros::NodeHandle& nh);
+};
+}  // namespace pointcloud_filter
+
+#endif  // SRC_SCAN_MERGER_CONFIG_H
@@ -0,0 +1,146 @@
+#ifndef SRC_SENSOR_PIPELINE_H
+#define SRC_SENSOR_PIPELINE_H
+
+#include <array>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include <diagnostic_updater/diagnostic_updater.h>
+#include <igvc_utils/lazy_publisher.h>
+#include <igvc_utils/transform_cache.h>
+#include <pointcloud_filter/back_filter/back_filter.h>
+#include <pointcloud_filter/bundle_pool.h>
+#include <pointcloud_filter/fast_segment_filter/fast_segment_filter.h>
+#include <pointcloud_filter/ground_filter/ground_filter.h>
+#include <pointcloud_filter/load_shedder/load_shedder.h>
+#include <pointcloud_filter/pointcloud_filter_config.h>
+#include <pointcloud_filter/predicate_pipeline.h>
+#include <pointcloud_filter/radius_filter/radius_filter.h>
+#include <pointcloud_filter/range_ground_filter/range_ground_filter.h>
+#include <pointcloud_filter/raycast_filter/raycast_filter.h>
+#include <pointcloud_filter/scan_merger/scan_merger.h>
+#include <pointcloud_filter/sensor_pipeline/sensor_pipeline_config.h>
+#include <pointcloud_filter/spsc_queue.h>
+#include <pointcloud_filter/tf_transform_filter/tf_transform_filter.h>
+#include <pointcloud_filter/voxel_filter/voxel_filter.h>
+#include <ros/callback_queue.h>
+#include <ros/ros.h>
+
+namespace pointcloud_filter
+{
+/**
+ * Runs the lidar filters on the scans of one lidar in three stages: filtering and downsampling, ground segmentation,
+ * then raycasting and publishing. By default the stages run back to back in the subscriber callback. With
+ * pipeline/enabled, the last two stages get their own threads connected by bounded queues, so that a scan can be
+ * segmented while the previous one is being raycast and published. Bundles are recycled through a BundlePool, so that a
+ * scan doesn't allocate once the buffers have grown to the size of a scan. With load_shedding/enabled, a LoadShedder
+ * watches the time spent per scan and degrades the processing step by step while it's over budget.
+ *
+ * Without a ScanMerger, the occupied points and free space are published directly. With one, they are added to it in
+ * base_frame instead, and the subscriber callback runs on a thread of its own so that the lidars are processed in
+ * parallel.
+ */
+class SensorPipeline
+{
+public:
+  using PointCloud = pcl::PointCloud<velodyne_pcl::PointXYZIRT>;
+
+  /**
+   * @param nh node handle for the topics
+   * @param sensor_nh node handle for the parameters of the lidar
+   * @param config parameters shared by every lidar
+   * @param merger merger to add the scans to as sensor_index, or nullptr to publish them directly
+   */
+  SensorPipeline(const ros::NodeHandle& nh, const ros::NodeHandle& sensor_nh, const PointcloudFilterConfig& config,
+                 igvc::TransformCache* transform_cache, ScanMerger* merger = nullptr, size_t sensor_index = 0);
+  ~SensorPipeline();
+
+  void diagnostic(diagnostic_updater::DiagnosticStatusWrapper& stat);
+
+private:
+  enum Stage
+  {
+    filter_stage,
+    segment_stage,
+    publish_stage,
+    num_stages
+  };
+
+  // Latencies of one stage since the last diagnostics update
+  struct StageLatency
+  {
+    size_t frames = 0;
+    double total_ms = 0.0;
+    double max_ms = 0.0;
+  };
+
+  ros::NodeHandle nh_;
+  ros::NodeHandle sensor_nh_;
+  SensorPipelineConfig config_;
+  const PointcloudFilterConfig& shared_config_;
+
+  PredicatePipeline<RadiusFilter, BackFilter> predicate_filter_;
+  VoxelFilter voxel_filter_;
+  TFTransformFilter tf_transform_filter_;
+  GroundFilter ground_filter_;
+  RaycastFilter raycast_filter_;
+  FastSegmentFilter fast_segment_filter_;
+  RangeGroundFilter range_ground_filter_;
+  LoadShedder load_shedder_;
+
+  ScanMerger* merger_;
+  size_t sensor_index_;
+  // Filled with each scan for the merger, which hands back the buffers of an earlier scan
+  ScanMerger::SensorScan merger_scan_;
+
+  // Only used with a merger, to run the subscriber callback on its own thread
+  ros::CallbackQueue callback_queue_;
+  std::unique_ptr<ros::AsyncSpinner> spinner_;
+  ros::Subscriber raw_pointcloud_sub_;
+
+  // Each output is only built while it has a subscriber
+  igvc::LazyPublisher<PointCloud> transformed_pointcloud_pub_;
+  igvc::LazyPublisher<PointCloud> occupied_pointcloud_pub_;
+  igvc::LazyPublisher<igvc_msgs::polar_scan> free_scan_pub_;
+
+  igvc::LazyPublisher<PointCloud> filtered_pointcloud_pub_;
+
+  // Declared before the queues, since the bundles in them are returned to it when they're destroyed
+  BundlePool bundle_pool_;
+
+  using BundleQueue = SpscQueue<BundlePool::Lease>;
+  std::unique_ptr<BundleQueue> segment_queue_;
+  std::unique_ptr<BundleQueue> publish_queue_;
+  std::thread segment_thread_;
+  std::thread publish_thread_;
+
+  std::mutex stats_mutex_;
+  std::array<StageLatency, num_stages> stage_latency_;
+  std::array<size_t, LoadShedder::num_levels> level_frames_{};
+  size_t dropped_frames_ = 0;
+
+  void setupPubSub();
+  void setupPipeline();
+  void pointcloudCallback(const PointCloud::ConstPtr& raw_pointcloud);
+
+  BundlePool::Lease filterStage(const PointCloud::ConstPtr& raw_pointcloud);
+  void segmentStage(Bundle& bundle);
+  void publishStage(Bundle& bundle);
+
+  /**
+   * Adds the occupied points and free space of bundle to the merger
+   */
+  void addToMerger(Bundle& bundle, const Eigen::Isometry3d& base_from_lidar);
+
+  void segmentLoop();
+  void publishLoop();
+
+  void recordLatency(Stage stage, std::chrono::steady_clock::time_point start, Bundle& bundle);
+  void recordFrame(const Bundle& bundle);
+  void recordDroppedFrame();
+};
+}  // namespace pointcloud_filter
+
+#endif  // SRC_SENSOR_PIPELINE_H
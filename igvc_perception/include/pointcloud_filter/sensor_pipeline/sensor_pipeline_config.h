@@ -0,0 +1,34 @@
+#ifndef SRC_SENSOR_PIPELINE_CONFIG_H
+#define SRC_SENSOR_PIPELINE_CONFIG_H
+
+#include <ros/ros.h>
+
+namespace pointcloud_filter
+{
+struct SensorPipelineConfig
+{
+  enum class GroundMethod
+  {
+    fast_segment,
+    range_image
+  };
+
+  std::string topic_input;
+  std::string topic_transformed;
+  std::string topic_filtered;
+
+  int range_image_columns = 1800;
+
+  bool pipeline_enabled = false;
+  int pipeline_queue_size = 2;
+
+  // False for planar lidars, whose points are all obstacles
+  bool ground_segmentation = true;
+  // FastSegmentFilter's line fitting, or RangeGroundFilter's region growing on the range image
+  GroundMethod ground_method = GroundMethod::fast_segment;
+
+  explicit SensorPipelineConfig(const ros::NodeHandle& nh);
+};
+}  // namespace pointcloud_filter
+
+#endif  // SRC_SENSOR_PIPELINE_CONFIG_H
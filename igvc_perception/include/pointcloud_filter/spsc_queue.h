@@ -0,0 +1,113 @@
+#ifndef SRC_SPSC_QUEUE_H
+#define SRC_SPSC_QUEUE_H
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
+namespace pointcloud_filter
+{
+/**
+ * Bounded queue between exactly one producer thread and one consumer thread. Pushing and popping are lock free, the
+ * mutex is only used to park the consumer while the queue is empty.
+ */
+template <typename T>
+class SpscQueue
+{
+public:
+  explicit SpscQueue(size_t capacity) : slots_(capacity + 1)
+  {
+  }
+
+  /**
+   * Pushes value, or returns false without touching it if the queue is full. Producer only.
+   */
+  bool tryPush(T&& value)
+  {
+    const size_t tail = tail_.load(std::memory_order_relaxed);
+    const size_t next = (tail + 1) % slots_.size();
+    if (next == head_.load(std::memory_order_acquire))
+    {
+      return false;
+    }
+    slots_[tail] = std::move(value);
+    tail_.store(next, std::memory_order_release);
+
+    // Taking the mutex orders the push with a consumer that is about to wait, so the notification can't be lost
+    {
+      std::lock_guard<std::mutex> lock{ mutex_ };
+    }
+    cv_.notify_one();
+    return true;
+  }
+
+  /**
+   * Pops the oldest value, or returns false if the queue is empty. Consumer only.
+   */
+  bool tryPop(T& value)
+  {
+    const size_t head = head_.load(std::memory_order_relaxed);
+    if (head == tail_.load(std::memory_order_acquire))
+    {
+      return false;
+    }
+    value = std::move(slots_[head]);
+    head_.store((head + 1) % slots_.size(), std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * Waits for a value and pops it. Returns false once the queue is closed and empty. Consumer only.
+   */
+  bool pop(T& value)
+  {
+    while (!tryPop(value))
+    {
+      std::unique_lock<std::mutex> lock{ mutex_ };
+      if (closed_)
+      {
+        return tryPop(value);
+      }
+      cv_.wait(lock, [this] { return closed_ || !empty(); });
+    }
+    return true;
+  }
+
+  /**
+   * Wakes up the consumer, making pop return false once the queue is drained
+   */
+  void close()
+  {
+    {
+      std::lock_guard<std::mutex> lock{ mutex_ };
+      closed_ = true;
+    }
+    cv_.notify_all();
+  }
+
+  size_t size() const
+  {
+    const size_t head = head_.load(std::memory_order_acquire);
+    const size_t tail = tail_.load(std::memory_order_acquire);
+    return (tail + slots_.size() - head) % slots_.size();
+  }
+
+  bool empty() const
+  {
+    return size() == 0;
+  }
+
+private:
+  // One slot is always left empty to tell a full queue from an empty one
+  std::vector<T> slots_;
+  std::atomic<size_t> head_{ 0 };  // Next slot to pop, only written by the consumer
+  std::atomic<size_t> tail_{ 0 };  // Next slot to push, only written by the producer
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  bool closed_ = false;
+};
+}  // namespace pointcloud_filter
+
+#endif  // SRC_SPSC_QUEUE_H
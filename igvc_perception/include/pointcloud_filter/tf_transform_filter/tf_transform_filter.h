@@ -1,13 +1,12 @@
-
 #ifndef SRC_TF_TRANSFORM_FILTER_H
 #define SRC_TF_TRANSFORM_FILTER_H
 
+#include <igvc_utils/transform_cache.h>
+#include <optional>
 #include <pcl/point_cloud.h>
-#include <tf2_ros/buffer.h>
 #include "pointcloud_filter/point_types.h"
 
-#include <pointcloud_filter/filter.h>
-#include <tf2_ros/transform_listener.h>
+#include <pointcloud_filter/bundle.h>
 
 namespace pointcloud_filter
 {
@@ -16,12 +15,28 @@ class TFTransformFilter
 public:
   using PointCloud = pcl::PointCloud<velodyne_pcl::PointXYZIRT>;
 
-  explicit TFTransformFilter(tf2_ros::Buffer* buffer_);
+  explicit TFTransformFilter(igvc::TransformCache* transform_cache);
+
+  /**
+   * Returns the transform from the frame of bundle's raw pointcloud to target_frame. The transform is stored in the
+   * bundle, so every cloud of the bundle shares a single lookup.
+   */
+  std::optional<Eigen::Isometry3d> lookup(Bundle& bundle, const std::string& target_frame,
+                                          const ros::Duration& timeout);
 
-  void transform(const PointCloud& from, PointCloud& to, const std::string& target_frame, const ros::Duration& timeout);
+  /**
+   * Transforms the points of bundle in indices into target_frame and writes them to to. Every cloud of a bundle is a
+   * selection of the raw pointcloud, so each point is transformed once, and not at all if the transform is the
+   * identity.
+   * @return false if the transform isn't available, in which case to is left untouched
+   */
+  bool transform(Bundle& bundle, const std::vector<int>& indices, PointCloud& to, const std::string& target_frame,
+                 const ros::Duration& timeout);
 
 private:
-  tf2_ros::Buffer* buffer_;
+  igvc::TransformCache* transform_cache_;
+  // Scratch space for the selected points, kept between scans
+  PointBuffer selected_;
 };
 }  // namespace pointcloud_filter
 
@@ -0,0 +1,54 @@
+#ifndef SRC_VOXEL_FILTER_H
+#define SRC_VOXEL_FILTER_H
+
+#include <cstdint>
+#include <vector>
+
+#include <pointcloud_filter/filter.h>
+#include <pointcloud_filter/voxel_filter/voxel_filter_config.h>
+
+namespace pointcloud_filter
+{
+/**
+ * Downsamples the points of a bundle to one point per voxel, keeping the lowest or the nearest point of each voxel.
+ * The kept points are points of the raw scan, so their ring and time are preserved, and with per_ring every ring
+ * keeps a point in each voxel it went through. The voxel size is set per band of distance from the lidar, so that
+ * the dense returns close to the lidar are thinned out while the sparse ones far away are left alone.
+ *
+ * Voxels are looked up in an open addressing hash table that is kept between scans, so a scan is filtered in linear
+ * time and doesn't allocate once the table has grown to the size of a scan. The kept indices stay in their order.
+ */
+class VoxelFilter : Filter
+{
+public:
+  explicit VoxelFilter(const ros::NodeHandle& nh);
+
+  void filter(Bundle& bundle) override;
+
+private:
+  struct Slot
+  {
+    uint64_t key = 0;
+    uint32_t generation = 0;  // The slot is empty unless this is the current generation
+    uint32_t kept = 0;        // Position of the voxel's point in the indices
+    float score = 0.0f;       // z or range of the voxel's point, lower is better
+  };
+
+  VoxelFilterConfig config_;
+  std::vector<float> inverse_voxel_sizes_;  // 0 for bands that aren't downsampled
+
+  std::vector<Slot> slots_;
+  int shift_ = 64;
+  uint32_t generation_ = 0;
+  std::vector<uint8_t> keep_;  // Whether the point at each position of the indices is kept
+
+  /**
+   * Grows the table to fit num_points voxels if needed, and empties it by starting a new generation
+   */
+  void prepareTable(size_t num_points);
+  size_t band(float range) const;
+  static uint64_t voxelKey(size_t band, uint16_t ring, float x, float y, float z);
+};
+}  // namespace pointcloud_filter
+
+#endif  // SRC_VOXEL_FILTER_H
@@ -0,0 +1,30 @@
+#ifndef SRC_VOXEL_FILTER_CONFIG_H
+#define SRC_VOXEL_FILTER_CONFIG_H
+
+#include <ros/ros.h>
+#include <vector>
+
+namespace pointcloud_filter
+{
+struct VoxelFilterConfig
+{
+  enum class Keep
+  {
+    lowest,
+    nearest
+  };
+
+  bool enabled = false;
+  // Distance from the lidar at which each band ends (m), increasing. The last band has no end
+  std::vector<double> band_ranges;
+  // Voxel size of each band (m), one more than band_ranges. 0 keeps every point of the band
+  std::vector<double> voxel_sizes;
+  Keep keep = Keep::lowest;
+  // Voxelize each ring separately, so that every ring keeps points wherever it had some
+  bool per_ring = true;
+
+  explicit VoxelFilterConfig(const ros::NodeHandle& nh);
+};
+}  // namespace pointcloud_filter
+
+#endif  // SRC_VOXEL_FILTER_CONFIG_H
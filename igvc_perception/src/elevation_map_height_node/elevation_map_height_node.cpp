@@ -9,7 +9,8 @@ ElevationMapHeightNode::ElevationMapHeightNode()
   std::string output_topic;
   assertions::getParam(private_nh_, "output_topic", output_topic);
   robot_pose_estimate_pub_ = private_nh_.advertise<geometry_msgs::PoseWithCovarianceStamped>(output_topic, 1);
-  elevation_map_sub_ = private_nh_.subscribe("/slope/gridmap", 1, &ElevationMapHeightNode::elevationMapCallback, this);
+  // Queue a full_map_period of the slope filter, so that the region under the robot isn't dropped for another one
+  elevation_map_sub_ = private_nh_.subscribe("/slope/gridmap", 20, &ElevationMapHeightNode::elevationMapCallback, this);
   robot_pose_sub_ = private_nh_.subscribe("/odometry/filtered", 1, &ElevationMapHeightNode::robotPoseCallback, this);
 }
 
@@ -21,7 +22,11 @@ void ElevationMapHeightNode::elevationMapCallback(const grid_map_msgs::GridMap&
   // get index corresponding to robot position
   grid_map::Index index;
   grid_map::Position position = { robot_pose_.pose.pose.position.x, robot_pose_.pose.pose.position.y };
-  map.getIndex(position, index);
+  // The slope filter only publishes the region that changed, which may not include the robot
+  if (!map.getIndex(position, index))
+  {
+    return;
+  }
   // create new pose message with elevation map height
   geometry_msgs::PoseWithCovarianceStamped new_pose;
   new_pose.header = robot_pose_.header;
@@ -1,9 +1,11 @@
-#include <ros/ros.h>
+#include <pointcloud_filter/actual_barrel_segmentation.h>
+
+#include <pcl_conversions/pcl_conversions.h>
+
 #include <pcl/PointIndices.h>
 #include <pcl/segmentation/extract_clusters.h>
 #include <std_msgs/Int32.h>
-#include <sensor_msgs/PointCloud2.h>
-#include <pcl_conversions/pcl_conversions.h>
+#include <pcl/common/io.h>
 #include <visualization_msgs/Marker.h>
 #include <visualization_msgs/MarkerArray.h>
 #include <pcl/filters/extract_indices.h>
@@ -14,29 +16,49 @@
 #include <pcl/sample_consensus/model_types.h>
 #include <pcl/segmentation/sac_segmentation.h>
 #include <igvc_msgs/barrels.h>
+#include <algorithm>
 #include <exception>
 
-ros::Publisher clusterCountPub;
-ros::Publisher clusterVisPub;
-ros::Publisher barrelInfoPub;
-std::string subTopic = "/nonground";
-std::string countPubTopic = "/countOutput";
-std::string visPubTopic = "/vizOutput";
-std::string barrelPubTopic = "/barrelPos";
-
-double clusterTolerance;
-int minClusterSize;
-int maxClusterSize;
-double cylinderMinRad;
-double cylinderMaxRad;
-double cylinderDistThres;
-double cylinderNormalDistWeight;
-bool showCyl;
-bool showClus;
-bool showInlier;
-
-void getCylinder(pcl::PointCloud<pcl::PointXYZ>::Ptr cloud, pcl::ModelCoefficients::Ptr coefficients_cylinder,
-                 pcl::PointIndices::Ptr inliers_cylinder)
+namespace pointcloud_filter
+{
+BarrelSegmentation::BarrelSegmentation(const ros::NodeHandle& nh, const ros::NodeHandle& private_nh)
+  : nh_{ nh }
+  , private_nh_{ private_nh }
+  , listener_{ buffer_ }
+  , transform_cache_{ &buffer_, private_nh_ }
+  , tracker_{ private_nh_, &transform_cache_ }
+{
+  private_nh_.getParam("clusterTolerance", clusterTolerance);
+  private_nh_.getParam("minClusterSize", minClusterSize);
+  private_nh_.getParam("maxClusterSize", maxClusterSize);
+  private_nh_.getParam("cylinderMinRad", cylinderMinRad);
+  private_nh_.getParam("cylinderMaxRad", cylinderMaxRad);
+  private_nh_.getParam("cylinderDistThres", cylinderDistThres);
+  private_nh_.getParam("cylinderNormalDistWeight", cylinderNormalDistWeight);
+  private_nh_.getParam("showCyl", showCyl);
+  private_nh_.getParam("showClus", showClus);
+  private_nh_.getParam("showInlier", showInlier);
+  private_nh_.getParam("fitMode", fitMode);
+  private_nh_.getParam("circleMaxIterations", circleMaxIterations);
+  private_nh_.getParam("circleMinInlierRatio", circleMinInlierRatio);
+  private_nh_.getParam("numThreads", numThreads);
+
+  circle_params_.min_radius = cylinderMinRad;
+  circle_params_.max_radius = cylinderMaxRad;
+  circle_params_.distance_threshold = cylinderDistThres;
+  circle_params_.min_inlier_ratio = circleMinInlierRatio;
+  circle_params_.max_iterations = circleMaxIterations;
+  thread_pool_ = std::make_unique<igvc::ThreadPool>(static_cast<size_t>(std::max(numThreads, 0)));
+
+  cluster_count_pub_ = nh_.advertise<std_msgs::Int32>(countPubTopic, 1);
+  cluster_vis_pub_ = nh_.advertise<visualization_msgs::MarkerArray>(visPubTopic, 1);
+  barrel_info_pub_ = nh_.advertise<igvc_msgs::barrels>(barrelPubTopic, 1);
+  pointcloud_sub_ = nh_.subscribe(subTopic, 1, &BarrelSegmentation::clusteringCallBack, this);
+}
+
+void BarrelSegmentation::getCylinder(pcl::PointCloud<pcl::PointXYZ>::Ptr cloud,
+                                     pcl::ModelCoefficients::Ptr coefficients_cylinder,
+                                     pcl::PointIndices::Ptr inliers_cylinder) const
 {
   // Cylinder Fitting Init
   pcl::NormalEstimation<pcl::PointXYZ, pcl::Normal> ne;
@@ -70,14 +92,51 @@ void getCylinder(pcl::PointCloud<pcl::PointXYZ>::Ptr cloud, pcl::ModelCoefficien
   seg.segment(*inliers_cylinder, *coefficients_cylinder);
 }
 
-void clusteringCallBack(const sensor_msgs::PointCloud2ConstPtr& pointcloudMsg)
+BarrelSegmentation::CylinderFit BarrelSegmentation::fitCylinder(const pcl::PointCloud<pcl::PointXYZ>& cloud,
+                                                               const pcl::PointIndices& cluster) const
 {
-  // Converting Sensor message to pcl::PCLPointCloud2
-  pcl::PCLPointCloud2* cloud = new pcl::PCLPointCloud2;
-  pcl_conversions::toPCL(*pointcloudMsg, *cloud);
-  pcl::PointCloud<pcl::PointXYZ>* cloudXYZ = new pcl::PointCloud<pcl::PointXYZ>;
-  pcl::PointCloud<pcl::PointXYZ>::Ptr cloudXYZPtr(cloudXYZ);
-  pcl::fromPCLPointCloud2(*cloud, *cloudXYZPtr);
+  CylinderFit fit;
+  if (fitMode == "upright")
+  {
+    Circle circle;
+    if (fitCircle(cloud, cluster.indices, circle_params_, circle, fit.inliers))
+    {
+      // An upright cylinder, in the same form as the coefficients of SACMODEL_CYLINDER
+      fit.coefficients = { circle.center.x(), circle.center.y(), 0.0f, 0.0f, 0.0f, 1.0f, circle.radius };
+      return fit;
+    }
+  }
+
+  // Leaning or partly hidden barrels that aren't upright circles get the full cylinder fit
+  pcl::PointCloud<pcl::PointXYZ>::Ptr cluster_cloud(new pcl::PointCloud<pcl::PointXYZ>);
+  for (int ptInd : cluster.indices)
+  {
+    cluster_cloud->push_back(cloud.points[ptInd]);
+  }
+  pcl::ModelCoefficients::Ptr coefficients_cylinder(new pcl::ModelCoefficients);
+  pcl::PointIndices::Ptr inliers_cylinder(new pcl::PointIndices);
+  getCylinder(cluster_cloud, coefficients_cylinder, inliers_cylinder);
+
+  fit.coefficients = coefficients_cylinder->values;
+  fit.inliers = inliers_cylinder->indices;
+  return fit;
+}
+
+std::vector<float> BarrelSegmentation::transformCylinder(const std::vector<float>& coefficients,
+                                                         const Eigen::Isometry3f& transform)
+{
+  // A point on the axis, the direction of the axis and the radius
+  const Eigen::Vector3f point = transform * Eigen::Vector3f{ coefficients[0], coefficients[1], coefficients[2] };
+  const Eigen::Vector3f direction =
+      transform.linear() * Eigen::Vector3f{ coefficients[3], coefficients[4], coefficients[5] };
+  return { point.x(), point.y(), point.z(), direction.x(), direction.y(), direction.z(), coefficients[6] };
+}
+
+void BarrelSegmentation::clusteringCallBack(const PointCloud::ConstPtr& pointcloud)
+{
+  // Only the positions are needed, and the nonground cloud is shared with other subscribers
+  pcl::PointCloud<pcl::PointXYZ>::Ptr cloudXYZPtr(new pcl::PointCloud<pcl::PointXYZ>);
+  pcl::copyPointCloud(*pointcloud, *cloudXYZPtr);
 
   // Clustering Init
   pcl::search::KdTree<pcl::PointXYZ>::Ptr tree(new pcl::search::KdTree<pcl::PointXYZ>);
@@ -96,7 +155,38 @@ void clusteringCallBack(const sensor_msgs::PointCloud2ConstPtr& pointcloudMsg)
   // Publish the number of clusters
   std_msgs::Int32 clusterCount;
   clusterCount.data = cluster_indices.size();
-  clusterCountPub.publish(clusterCount);
+  cluster_count_pub_.publish(clusterCount);
+
+  // Track the clusters, so that the cylinders of unchanged clusters can be reused
+  std::vector<ClusterTracker::Observation> observations;
+  for (const pcl::PointIndices& cluster : cluster_indices)
+  {
+    ClusterTracker::Observation& observation = observations.emplace_back();
+    observation.centroid.setZero();
+    for (int ptInd : cluster.indices)
+    {
+      observation.centroid += cloudXYZPtr->points[ptInd].getVector3fMap();
+    }
+    observation.centroid /= cluster.indices.size();
+    observation.num_points = cluster.indices.size();
+  }
+  const std::vector<size_t>& tracks =
+      tracker_.update(pointcloud->header.frame_id, pcl_conversions::fromPCL(pointcloud->header.stamp), observations);
+  const Eigen::Isometry3f cloud_from_fixed = tracker_.fixedFromCloud().inverse();
+
+  // The clusters without a cylinder to reuse are fit in parallel, each into its own slot
+  std::vector<const std::vector<float>*> cached_cylinders(cluster_indices.size());
+  for (size_t clusterInd = 0; clusterInd < cluster_indices.size(); clusterInd++)
+  {
+    cached_cylinders[clusterInd] = tracker_.cachedFit(tracks[clusterInd]);
+  }
+  std::vector<CylinderFit> fits(cluster_indices.size());
+  thread_pool_->parallelFor(cluster_indices.size(), [&](size_t clusterInd) {
+    if (!cached_cylinders[clusterInd])
+    {
+      fits[clusterInd] = fitCylinder(*cloudXYZPtr, cluster_indices[clusterInd]);
+    }
+  });
 
   // Visualization Message and Barrel Info Init
   visualization_msgs::MarkerArray clusters_vis;
@@ -104,35 +194,28 @@ void clusteringCallBack(const sensor_msgs::PointCloud2ConstPtr& pointcloudMsg)
 
   for (int clusterInd = 0; clusterInd < (int)cluster_indices.size(); clusterInd++)
   {
+    const size_t track = tracks[clusterInd];
+    const int track_id = tracker_.tracks()[track].id;
+    const std::vector<int>& indices = cluster_indices[clusterInd].indices;
+
     // Visualization Init
     visualization_msgs::Marker clusterPoints;
     visualization_msgs::Marker inlierPoints;
 
-    // PointClout Init
-    pcl::PointCloud<pcl::PointXYZ> curr_cloud;
-
-    // Cluster Storing
-    pcl::PointCloud<pcl::PointXYZ>* currClus = new pcl::PointCloud<pcl::PointXYZ>;
-    pcl::PointCloud<pcl::PointXYZ>::Ptr currCloudXYZPtr(currClus);
-
-    // Barrel Points
+    // Barrel Points, with the id and color of the track so that they don't change between clouds
     clusterPoints.header.frame_id = "/lidar";
     clusterPoints.header.stamp = ros::Time::now();
-    clusterPoints.ns = "Barrel_" + std::to_string(clusterInd);
+    clusterPoints.ns = "Barrel";
     clusterPoints.action = visualization_msgs::Marker::ADD;
     clusterPoints.pose.orientation.w = 1.0;
-    clusterPoints.id = 0;
+    clusterPoints.id = track_id;
     clusterPoints.type = visualization_msgs::Marker::POINTS;
     clusterPoints.scale.x = 0.01;
     clusterPoints.scale.y = 0.01;
-
-    clusterPoints.color.a = 1.0;
-    clusterPoints.color.r = clusterInd * 0.25;
-    clusterPoints.color.g = clusterInd * 0.25;
-    clusterPoints.color.b = clusterInd * 0.25;
+    clusterPoints.color = ClusterTracker::color(track_id);
     clusterPoints.lifetime = ros::Duration(0.1);
 
-    for (int ptInd : cluster_indices.at(clusterInd).indices)
+    for (int ptInd : indices)
     {
       pcl::PointXYZ curr = cloudXYZPtr->points[ptInd];
 
@@ -141,42 +224,52 @@ void clusteringCallBack(const sensor_msgs::PointCloud2ConstPtr& pointcloudMsg)
       p.y = curr.y;
       p.z = curr.z;
       clusterPoints.points.push_back(p);
-
-      currClus->push_back(curr);
     }
-    // Variables to store cylinder fitting result
-    pcl::ModelCoefficients::Ptr coefficients_cylinder(new pcl::ModelCoefficients);
-    pcl::PointIndices::Ptr inliers_cylinder(new pcl::PointIndices);
 
-    // Get Cylinder Fitting from the current cluster
-    getCylinder(currCloudXYZPtr, coefficients_cylinder, inliers_cylinder);
-    if (coefficients_cylinder->values.size() == 0)
+    // The cached cylinder is in the fixed frame, so that it stays put while the robot moves
+    std::vector<float> coefficients;
+    if (cached_cylinders[clusterInd])
+    {
+      if (cached_cylinders[clusterInd]->empty())
+      {
+        continue;
+      }
+      coefficients = transformCylinder(*cached_cylinders[clusterInd], cloud_from_fixed);
+    }
+    else
     {
-      continue;
+      const CylinderFit& fit = fits[clusterInd];
+      if (fit.coefficients.empty())
+      {
+        tracker_.setFit(track, {});
+        continue;
+      }
+      coefficients = fit.coefficients;
+      tracker_.setFit(track, transformCylinder(coefficients, tracker_.fixedFromCloud()));
     }
 
     // Extract Cylinder Info
     // X = a1 + v1*t
     // Y = a2 + v2*t
     // Z = a3 + v3*t
-    double a1 = coefficients_cylinder->values[0];
-    double a2 = coefficients_cylinder->values[1];
-    double a3 = coefficients_cylinder->values[2];
-    double v1 = coefficients_cylinder->values[3];
-    double v2 = coefficients_cylinder->values[4];
-    double v3 = coefficients_cylinder->values[5];
-    double r = coefficients_cylinder->values[6];
+    double a1 = coefficients[0];
+    double a2 = coefficients[1];
+    double a3 = coefficients[2];
+    double v1 = coefficients[3];
+    double v2 = coefficients[4];
+    double v3 = coefficients[5];
+    double r = coefficients[6];
 
     // Solve t for Z = 0
     double t = -a3 / v3;
 
-    // Cylinder Inlier Points
+    // Cylinder Inlier Points, which are only known when the cylinder was fit on this cloud
     inlierPoints.header.frame_id = "/lidar";
     inlierPoints.header.stamp = ros::Time::now();
-    inlierPoints.ns = "CylPoints_" + std::to_string(clusterInd);
+    inlierPoints.ns = "CylPoints";
     inlierPoints.action = visualization_msgs::Marker::ADD;
     inlierPoints.pose.orientation.w = 1.0;
-    inlierPoints.id = 0;
+    inlierPoints.id = track_id;
     inlierPoints.type = visualization_msgs::Marker::POINTS;
     inlierPoints.scale.x = 0.01;
     inlierPoints.scale.y = 0.01;
@@ -186,9 +279,9 @@ void clusteringCallBack(const sensor_msgs::PointCloud2ConstPtr& pointcloudMsg)
     inlierPoints.color.b = 0.0;
     inlierPoints.lifetime = ros::Duration(0.1);
 
-    for (int ptInd : inliers_cylinder->indices)
+    for (int ptInd : fits[clusterInd].inliers)
     {
-      pcl::PointXYZ curr = currCloudXYZPtr->points[ptInd];
+      pcl::PointXYZ curr = cloudXYZPtr->points[indices[ptInd]];
 
       geometry_msgs::Point pt_real;
       pt_real.x = curr.x;
@@ -201,9 +294,8 @@ void clusteringCallBack(const sensor_msgs::PointCloud2ConstPtr& pointcloudMsg)
     visualization_msgs::Marker cylinder;
     cylinder.header.frame_id = "/lidar";
     cylinder.header.stamp = ros::Time::now();
-    cylinder.ns = "Cylinder_" + std::to_string(clusterInd);
-    ;
-    cylinder.id = 0;
+    cylinder.ns = "Cylinder";
+    cylinder.id = track_id;
     cylinder.type = visualization_msgs::Marker::CYLINDER;
     cylinder.action = visualization_msgs::Marker::ADD;
     cylinder.pose.position.x = a1 + v1 * t;
@@ -244,32 +336,7 @@ void clusteringCallBack(const sensor_msgs::PointCloud2ConstPtr& pointcloudMsg)
       clusters_vis.markers.push_back(inlierPoints);
     }
   }
-  clusterVisPub.publish(clusters_vis);
-  barrelInfoPub.publish(barrelInfo);
+  cluster_vis_pub_.publish(clusters_vis);
+  barrel_info_pub_.publish(barrelInfo);
 }
-
-int main(int argc, char** argv)
-{
-  ros::init(argc, argv, "actualBarrelSegmentation");
-
-  ros::NodeHandle nh;
-
-  ros::NodeHandle pnh{ "~" };
-  pnh.getParam("clusterTolerance", clusterTolerance);
-  pnh.getParam("minClusterSize", minClusterSize);
-  pnh.getParam("maxClusterSize", maxClusterSize);
-  pnh.getParam("cylinderMinRad", cylinderMinRad);
-  pnh.getParam("cylinderMaxRad", cylinderMaxRad);
-  pnh.getParam("cylinderDistThres", cylinderDistThres);
-  pnh.getParam("cylinderNormalDistWeight", cylinderNormalDistWeight);
-  pnh.getParam("showCyl", showCyl);
-  pnh.getParam("showClus", showClus);
-  pnh.getParam("showInlier", showInlier);
-
-  clusterCountPub = nh.advertise<std_msgs::Int32>(countPubTopic, 1);
-  clusterVisPub = nh.advertise<visualization_msgs::MarkerArray>(visPubTopic, 1);
-  barrelInfoPub = nh.advertise<igvc_msgs::barrels>(barrelPubTopic, 1);
-  ros::Subscriber pointcloud_sub = nh.subscribe(subTopic, 1, clusteringCallBack);
-
-  ros::spin();
-}
\ No newline at end of file
+}  // namespace pointcloud_filter
@@ -0,0 +1,11 @@
+#include <pointcloud_filter/actual_barrel_segmentation.h>
+#include <ros/ros.h>
+
+int main(int argc, char** argv)
+{
+  ros::init(argc, argv, "actualBarrelSegmentation");
+
+  pointcloud_filter::BarrelSegmentation barrel_segmentation{};
+
+  ros::spin();
+}
@@ -1,11 +1,61 @@
+#include <pcl/common/io.h>
 #include <pointcloud_filter/bundle.h>
+#include <numeric>
 
 namespace pointcloud_filter
 {
-Bundle::Bundle(const PointCloud::ConstPtr& raw_pointcloud)
-  : pointcloud{ new PointCloud }, occupied_pointcloud{ new PointCloud }, free_pointcloud{ new PointCloud }
+Bundle::Bundle(int range_image_columns)
+  : free_scan{ new igvc_msgs::polar_scan }, range_image_columns_{ range_image_columns }
 {
-  pointcloud->points = raw_pointcloud->points;
-  pointcloud->header = raw_pointcloud->header;
+}
+
+Bundle::Bundle(const PointCloud::ConstPtr& raw_pointcloud, int range_image_columns) : Bundle{ range_image_columns }
+{
+  reset(raw_pointcloud);
+}
+
+void Bundle::reset(const PointCloud::ConstPtr& raw_pointcloud)
+{
+  this->raw_pointcloud = raw_pointcloud;
+  points.assign(*raw_pointcloud);
+
+  // A subscriber in the same process may still hold the last free scan, in which case it can't be reused
+  if (free_scan.use_count() > 1)
+  {
+    free_scan.reset(new igvc_msgs::polar_scan);
+  }
+
+  indices.resize(raw_pointcloud->size());
+  std::iota(indices.begin(), indices.end(), 0);
+  occupied_indices.clear();
+  transforms.clear();
+  degradation_level = 0;
+  total_stage_ms = 0.0;
+  max_stage_ms = 0.0;
+  range_image_built_ = false;
+}
+
+size_t Bundle::capacityBytes() const
+{
+  return points.capacityBytes() + (indices.capacity() + occupied_indices.capacity()) * sizeof(int) +
+         range_image_.capacityBytes() + free_scan->free_ranges.capacity() * sizeof(float) +
+         free_scan->occupied_ranges.capacity() * sizeof(float);
+}
+
+const RangeImage& Bundle::rangeImage()
+{
+  if (!range_image_built_)
+  {
+    range_image_.build(points, range_image_columns_);
+    range_image_built_ = true;
+  }
+  return range_image_;
+}
+
+Bundle::PointCloud::Ptr Bundle::materialize(const std::vector<int>& selection) const
+{
+  PointCloud::Ptr pointcloud{ new PointCloud };
+  pcl::copyPointCloud(*raw_pointcloud, selection, *pointcloud);
+  return pointcloud;
 }
 }  // namespace pointcloud_filter
@@ -0,0 +1,67 @@
+#include <pointcloud_filter/bundle_pool.h>
+
+namespace pointcloud_filter
+{
+void BundlePool::Release::operator()(Bundle* bundle) const
+{
+  if (pool_ == nullptr)
+  {
+    delete bundle;
+    return;
+  }
+  pool_->release(bundle, leased_capacity_);
+}
+
+BundlePool::BundlePool(int range_image_columns) : range_image_columns_{ range_image_columns }
+{
+}
+
+BundlePool::Lease BundlePool::lease(const PointCloud::ConstPtr& raw_pointcloud)
+{
+  std::unique_ptr<Bundle> bundle;
+  {
+    std::lock_guard<std::mutex> lock{ mutex_ };
+    counters_.leases++;
+    if (free_bundles_.empty())
+    {
+      counters_.bundle_allocations++;
+    }
+    else
+    {
+      bundle = std::move(free_bundles_.back());
+      free_bundles_.pop_back();
+    }
+  }
+
+  if (!bundle)
+  {
+    bundle = std::make_unique<Bundle>(range_image_columns_);
+  }
+
+  // Measured before the reset, so that growing to fit this scan counts as well
+  const size_t leased_capacity = bundle->capacityBytes();
+  bundle->reset(raw_pointcloud);
+  return Lease{ bundle.release(), Release{ this, leased_capacity } };
+}
+
+BundlePool::Counters BundlePool::counters() const
+{
+  std::lock_guard<std::mutex> lock{ mutex_ };
+  return counters_;
+}
+
+void BundlePool::release(Bundle* bundle, size_t leased_capacity)
+{
+  std::unique_ptr<Bundle> owned{ bundle };
+  // Don't keep the scan alive while the bundle waits in the pool
+  owned->raw_pointcloud.reset();
+  const bool grew = owned->capacityBytes() > leased_capacity;
+
+  std::lock_guard<std::mutex> lock{ mutex_ };
+  if (grew)
+  {
+    counters_.buffer_growths++;
+  }
+  free_bundles_.emplace_back(std::move(owned));
+}
+}  // namespace pointcloud_filter
@@ -0,0 +1,205 @@
+#include <pointcloud_filter/circle_fit.h>
+
+#include <Eigen/Dense>
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+namespace pointcloud_filter
+{
+namespace
+{
+/**
+ * Fits a circle to the points at positions of points by minimizing the algebraic distance (x - a)^2 + (y - b)^2 - r^2
+ */
+bool leastSquaresCircle(const std::vector<Eigen::Vector2f>& points, const std::vector<int>& positions, Circle& circle)
+{
+  if (positions.size() < 3)
+  {
+    return false;
+  }
+
+  // Centered on the mean so that the normal equations stay well conditioned far from the lidar
+  Eigen::Vector2d mean = Eigen::Vector2d::Zero();
+  for (int position : positions)
+  {
+    mean += points[position].cast<double>();
+  }
+  mean /= positions.size();
+
+  // x^2 + y^2 + d x + e y + f = 0 for every point
+  Eigen::Matrix3d normal_matrix = Eigen::Matrix3d::Zero();
+  Eigen::Vector3d normal_vector = Eigen::Vector3d::Zero();
+  for (int position : positions)
+  {
+    const Eigen::Vector2d point = points[position].cast<double>() - mean;
+    const Eigen::Vector3d row{ point.x(), point.y(), 1.0 };
+    normal_matrix += row * row.transpose();
+    normal_vector -= row * point.squaredNorm();
+  }
+
+  const Eigen::LDLT<Eigen::Matrix3d> solver{ normal_matrix };
+  if (solver.info() != Eigen::Success || !solver.isPositive())
+  {
+    return false;
+  }
+  const Eigen::Vector3d def = solver.solve(normal_vector);
+
+  const Eigen::Vector2d center = -def.head<2>() / 2;
+  const double radius_squared = center.squaredNorm() - def.z();
+  if (!std::isfinite(radius_squared) || radius_squared <= 0.0)
+  {
+    return false;
+  }
+
+  circle.center = (center + mean).cast<float>();
+  circle.radius = static_cast<float>(std::sqrt(radius_squared));
+  return true;
+}
+
+/**
+ * Finds the circle through three points
+ */
+bool circleThrough(const Eigen::Vector2f& first, const Eigen::Vector2f& second, const Eigen::Vector2f& third,
+                   Circle& circle)
+{
+  const Eigen::Vector2f b = second - first;
+  const Eigen::Vector2f c = third - first;
+  const float determinant = 2 * (b.x() * c.y() - b.y() * c.x());
+  if (std::abs(determinant) < 1e-9f)
+  {
+    return false;
+  }
+
+  const Eigen::Vector2f offset{ (c.y() * b.squaredNorm() - b.y() * c.squaredNorm()) / determinant,
+                                (b.x() * c.squaredNorm() - c.x() * b.squaredNorm()) / determinant };
+  circle.center = first + offset;
+  circle.radius = offset.norm();
+  return true;
+}
+
+bool withinLimits(const Circle& circle, const CircleFitParams& params)
+{
+  return circle.radius >= params.min_radius && circle.radius <= params.max_radius;
+}
+
+size_t countInliers(const std::vector<Eigen::Vector2f>& points, const Circle& circle, float threshold)
+{
+  size_t count = 0;
+  for (const Eigen::Vector2f& point : points)
+  {
+    count += std::abs((point - circle.center).norm() - circle.radius) <= threshold;
+  }
+  return count;
+}
+
+void collectInliers(const std::vector<Eigen::Vector2f>& points, const Circle& circle, float threshold,
+                    std::vector<int>& inliers)
+{
+  inliers.clear();
+  for (size_t position = 0; position < points.size(); position++)
+  {
+    if (std::abs((points[position] - circle.center).norm() - circle.radius) <= threshold)
+    {
+      inliers.push_back(static_cast<int>(position));
+    }
+  }
+}
+
+/**
+ * Iterations needed to draw a sample of three inliers with the given confidence, if inlier_ratio of the points are
+ */
+int requiredIterations(double inlier_ratio, double confidence, int max_iterations)
+{
+  const double outlier_free = inlier_ratio * inlier_ratio * inlier_ratio;
+  if (outlier_free >= 1.0)
+  {
+    return 0;
+  }
+  if (outlier_free <= 0.0)
+  {
+    return max_iterations;
+  }
+  const double iterations = std::ceil(std::log(1.0 - confidence) / std::log(1.0 - outlier_free));
+  return static_cast<int>(std::min(iterations, static_cast<double>(max_iterations)));
+}
+}  // namespace
+
+bool fitCircle(const pcl::PointCloud<pcl::PointXYZ>& cloud, const std::vector<int>& indices,
+               const CircleFitParams& params, Circle& circle, std::vector<int>& inliers)
+{
+  inliers.clear();
+  const size_t num_points = indices.size();
+  if (num_points < 3)
+  {
+    return false;
+  }
+
+  std::vector<Eigen::Vector2f> points;
+  points.reserve(num_points);
+  for (int index : indices)
+  {
+    points.emplace_back(cloud.points[index].x, cloud.points[index].y);
+  }
+  const float threshold = static_cast<float>(params.distance_threshold);
+
+  std::vector<int> all(num_points);
+  for (size_t position = 0; position < num_points; position++)
+  {
+    all[position] = static_cast<int>(position);
+  }
+
+  Circle best;
+  size_t best_inliers = 0;
+  if (leastSquaresCircle(points, all, best) && withinLimits(best, params))
+  {
+    best_inliers = countInliers(points, best, threshold);
+  }
+
+  // Seeded by the cluster, so that the same cluster gets the same fit on every run and on every thread
+  std::minstd_rand random{ static_cast<std::minstd_rand::result_type>(num_points) };
+  std::uniform_int_distribution<size_t> pick{ 0, num_points - 1 };
+  int iterations = requiredIterations(static_cast<double>(best_inliers) / num_points, params.confidence,
+                                      params.max_iterations);
+  for (int iteration = 0; iteration < iterations; iteration++)
+  {
+    const size_t first = pick(random);
+    const size_t second = pick(random);
+    const size_t third = pick(random);
+    Circle candidate;
+    if (first == second || first == third || second == third ||
+        !circleThrough(points[first], points[second], points[third], candidate) || !withinLimits(candidate, params))
+    {
+      continue;
+    }
+
+    const size_t candidate_inliers = countInliers(points, candidate, threshold);
+    if (candidate_inliers > best_inliers)
+    {
+      best = candidate;
+      best_inliers = candidate_inliers;
+      iterations = requiredIterations(static_cast<double>(best_inliers) / num_points, params.confidence,
+                                      params.max_iterations);
+    }
+  }
+
+  if (best_inliers == 0)
+  {
+    return false;
+  }
+
+  collectInliers(points, best, threshold, inliers);
+
+  // The refit is only kept if it's still a barrel, since a few outliers can pull the least squares radius off
+  Circle refit;
+  if (leastSquaresCircle(points, inliers, refit) && withinLimits(refit, params) &&
+      countInliers(points, refit, threshold) >= best_inliers)
+  {
+    best = refit;
+    collectInliers(points, best, threshold, inliers);
+  }
+
+  circle = best;
+  return inliers.size() >= params.min_inlier_ratio * num_points;
+}
+}  // namespace pointcloud_filter
@@ -0,0 +1,164 @@
+#include <pointcloud_filter/cluster_tracker/cluster_tracker.h>
+#include <tf2_eigen/tf2_eigen.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace pointcloud_filter
+{
+ClusterTracker::ClusterTracker(const ros::NodeHandle& nh, igvc::TransformCache* transform_cache)
+  : config_{ nh }, transform_cache_{ transform_cache }
+{
+}
+
+const std::vector<size_t>& ClusterTracker::update(const std::string& frame, const ros::Time& stamp,
+                                                  const std::vector<Observation>& observations)
+{
+  lookupFixedFrame(frame, stamp);
+
+  tracks_.erase(std::remove_if(tracks_.begin(), tracks_.end(),
+                               [&](const Track& track) { return track.missed_frames >= config_.max_missed_frames; }),
+                tracks_.end());
+
+  centroids_.clear();
+  for (const Observation& observation : observations)
+  {
+    centroids_.emplace_back(fixed_from_cloud_ * observation.centroid);
+  }
+
+  // There are only tens of clusters, so every pair within the gate is considered
+  const float gate_squared = static_cast<float>(config_.gate_distance * config_.gate_distance);
+  pairs_.clear();
+  for (size_t observation = 0; observation < observations.size(); observation++)
+  {
+    for (size_t track = 0; track < tracks_.size(); track++)
+    {
+      const float distance_squared = (centroids_[observation] - tracks_[track].centroid).squaredNorm();
+      if (distance_squared <= gate_squared)
+      {
+        pairs_.push_back({ distance_squared, observation, track });
+      }
+    }
+  }
+  std::sort(pairs_.begin(), pairs_.end(),
+            [](const Pair& first, const Pair& second) { return first.distance_squared < second.distance_squared; });
+
+  const size_t unassigned = tracks_.size() + observations.size();
+  assignments_.assign(observations.size(), unassigned);
+  track_matched_.assign(tracks_.size(), false);
+  for (const Pair& pair : pairs_)
+  {
+    if (assignments_[pair.observation] == unassigned && !track_matched_[pair.track])
+    {
+      assignments_[pair.observation] = pair.track;
+      track_matched_[pair.track] = true;
+    }
+  }
+
+  for (size_t track = 0; track < track_matched_.size(); track++)
+  {
+    if (!track_matched_[track])
+    {
+      tracks_[track].missed_frames++;
+    }
+  }
+
+  for (size_t observation = 0; observation < observations.size(); observation++)
+  {
+    if (assignments_[observation] == unassigned)
+    {
+      assignments_[observation] = tracks_.size();
+      Track& track = tracks_.emplace_back();
+      track.id = next_id_++;
+    }
+
+    Track& track = tracks_[assignments_[observation]];
+    track.centroid = centroids_[observation];
+    track.num_points = observations[observation].num_points;
+    track.missed_frames = 0;
+  }
+  return assignments_;
+}
+
+const std::vector<float>* ClusterTracker::cachedFit(size_t track_index)
+{
+  Track& track = tracks_[track_index];
+  if (!track.has_fit || track.fit_age >= config_.max_fit_age)
+  {
+    return nullptr;
+  }
+
+  const double size_change =
+      std::abs(static_cast<double>(track.num_points) - static_cast<double>(track.fit_num_points));
+  if ((track.centroid - track.fit_centroid).norm() > config_.refit_distance ||
+      size_change > config_.refit_size_ratio * track.fit_num_points)
+  {
+    return nullptr;
+  }
+
+  track.fit_age++;
+  fits_reused_++;
+  return &track.fit;
+}
+
+void ClusterTracker::setFit(size_t track_index, std::vector<float> fit)
+{
+  Track& track = tracks_[track_index];
+  track.has_fit = true;
+  track.fit = std::move(fit);
+  track.fit_centroid = track.centroid;
+  track.fit_num_points = track.num_points;
+  track.fit_age = 0;
+  fits_computed_++;
+}
+
+std_msgs::ColorRGBA ClusterTracker::color(int id)
+{
+  // Stepping the hue by the golden ratio keeps consecutive ids far apart on the color wheel
+  const float hue = static_cast<float>(std::fmod(id * 0.6180339887, 1.0) * 6.0);
+  const float rising = hue - std::floor(hue);
+  std_msgs::ColorRGBA color;
+  color.a = 1.0f;
+  switch (static_cast<int>(hue))
+  {
+    case 0:
+      color.r = 1.0f;
+      color.g = rising;
+      break;
+    case 1:
+      color.r = 1.0f - rising;
+      color.g = 1.0f;
+      break;
+    case 2:
+      color.g = 1.0f;
+      color.b = rising;
+      break;
+    case 3:
+      color.g = 1.0f - rising;
+      color.b = 1.0f;
+      break;
+    case 4:
+      color.r = rising;
+      color.b = 1.0f;
+      break;
+    default:
+      color.r = 1.0f;
+      color.b = 1.0f - rising;
+      break;
+  }
+  return color;
+}
+
+void ClusterTracker::lookupFixedFrame(const std::string& frame, const ros::Time& stamp)
+{
+  const std::optional<geometry_msgs::TransformStamped> transform = transform_cache_->lookupTransform(
+      transform_cache_->fixedFrame(), frame, stamp, ros::Duration{ config_.timeout_duration });
+  if (!transform)
+  {
+    ROS_WARN_STREAM_THROTTLE(1.0, "No transform from " << frame << " to " << transform_cache_->fixedFrame()
+                                                       << ", tracking clusters with the last one found");
+    return;
+  }
+  fixed_from_cloud_ = tf2::transformToEigen(*transform).cast<float>();
+}
+}  // namespace pointcloud_filter
@@ -0,0 +1,17 @@
+#include <parameter_assertions/assertions.h>
+#include <pointcloud_filter/cluster_tracker/cluster_tracker_config.h>
+
+namespace pointcloud_filter
+{
+ClusterTrackerConfig::ClusterTrackerConfig(const ros::NodeHandle &nh)
+{
+  ros::NodeHandle child_nh{ nh, "cluster_tracker" };
+
+  gate_distance = assertions::param(child_nh, "gate_distance", 0.5);
+  max_missed_frames = assertions::param(child_nh, "max_missed_frames", 5);
+  refit_distance = assertions::param(child_nh, "refit_distance", 0.05);
+  refit_size_ratio = assertions::param(child_nh, "refit_size_ratio", 0.2);
+  max_fit_age = assertions::param(child_nh, "max_fit_age", 50);
+  timeout_duration = assertions::param(child_nh, "timeout_duration", 0.05);
+}
+}  // namespace pointcloud_filter
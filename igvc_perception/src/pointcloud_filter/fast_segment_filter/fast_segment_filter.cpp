@@ -4,29 +4,82 @@ namespace pointcloud_filter
 {
 void FastSegmentFilter::filter(pointcloud_filter::Bundle &bundle)
 {
-  segments_.clear();
-  ground_points_.clear();
-  nonground_points_.clear();
+  const RangeImage &range_image = bundle.rangeImage();
+  resetSegments(range_image.rings());
 
-  for (const auto &point : bundle.pointcloud->points)
+  for (int index : bundle.indices)
   {
-    int segment_id = getSegIdFromPoint(point);
-    segments_[segment_id].raw_points_.emplace_back(point);
+    const int segment_id = getSegIdFromAzimuth(range_image.azimuth(index));
+    Segment &segment = segments_[segment_id];
+    const velodyne_pcl::PointXYZIRT &point = bundle.raw_pointcloud->points[index];
+
+    PrototypeCell &cell = prototype_cells_[segment_id * num_rings_ + point.ring];
+    if (cell.point == PrototypeCell::empty || point.z < cell.min_z)
+    {
+      cell.min_z = point.z;
+      cell.point = static_cast<int>(segment.raw_points_.size());
+    }
+
+    segment.raw_points_.emplace_back(point);
+    segment.raw_indices_.emplace_back(index);
   }
   computePrototypePoints();
   getLinesFromSegments();
-  if (config_.debug_viz)
+  if (config_.debug_viz && debug_output_)
+  {
+    marker_pub_.publish([this] { return debugViz(); });
+  }
+
+  // Subscribers in the same nodelet manager keep a reference to the published clouds, so each scan gets new ones.
+  // They're only needed for publishing, so they aren't built at all without subscribers.
+  pcl::PointCloud<velodyne_pcl::PointXYZIRT>::Ptr ground_points;
+  pcl::PointCloud<velodyne_pcl::PointXYZIRT>::Ptr nonground_points;
+  if (debug_output_ && ground_pub_.hasSubscribers())
+  {
+    ground_points.reset(new pcl::PointCloud<velodyne_pcl::PointXYZIRT>);
+    ground_points->header.frame_id = "/lidar";
+  }
+  if (nonground_pub_.hasSubscribers())
   {
-    debugViz();
+    nonground_points.reset(new pcl::PointCloud<velodyne_pcl::PointXYZIRT>);
+    nonground_points->header.frame_id = "/lidar";
   }
-  ground_points_.header.frame_id = "/lidar";
-  nonground_points_.header.frame_id = "/lidar";
-  classifyPoints(ground_points_, nonground_points_);
-  ground_pub_.publish(ground_points_);
-  nonground_pub_.publish(nonground_points_);
+  bundle.occupied_indices.clear();
+  classifyPoints(ground_points.get(), nonground_points.get(), &bundle.occupied_indices);
+  ground_pub_.publish([&] { return ground_points; });
+  nonground_pub_.publish([&] { return nonground_points; });
+}
+
+void FastSegmentFilter::resetSegments(int num_rings)
+{
+  // clear() keeps the capacity of each vector, so after the first few scans this doesn't allocate
+  segments_.resize(num_segments_);
+  for (Segment &segment : segments_)
+  {
+    segment.raw_points_.clear();
+    segment.raw_indices_.clear();
+    segment.is_ground_.clear();
+    segment.prototype_points_.clear();
+    segment.lines_.clear();
+  }
+
+  num_rings_ = num_rings;
+  prototype_cells_.assign(static_cast<size_t>(num_segments_) * num_rings_, PrototypeCell{});
+}
+
+void FastSegmentFilter::setSegmentDivisor(int divisor)
+{
+  num_segments_ = std::max(config_.num_segments / std::max(divisor, 1), 1);
+}
 
-  bundle.occupied_pointcloud->header = bundle.pointcloud->header;
-  bundle.occupied_pointcloud->points = std::move(nonground_points_.points);
+void FastSegmentFilter::setDebugOutput(bool enabled)
+{
+  debug_output_ = enabled;
+}
+
+size_t FastSegmentFilter::numThreads() const
+{
+  return thread_pool_.size();
 }
 
 double Line::distFromPoint(const Prototype point) const
@@ -40,10 +93,14 @@ double Line::distFromPoint(const Prototype point) const
 
 bool Line::attemptFitPoint(const Prototype &new_point)
 {
-  int total_points = model_points_.size() + 1;
+  const Eigen::Vector3d point{ new_point.point_.x, new_point.point_.y, new_point.point_.z };
+  const Eigen::Vector3d sum = sum_ + point;
+  const Eigen::Matrix3d sum_outer = sum_outer_ + point * point.transpose();
+
+  int total_points = num_points_ + 1;
   if (total_points < 3)
   {
-    if (model_points_.empty())
+    if (num_points_ == 0)
     {
       start_point_ = new_point;
     }
@@ -51,155 +108,157 @@ bool Line::attemptFitPoint(const Prototype &new_point)
     {
       end_point_ = new_point;
     }
-    model_points_.emplace_back(new_point);
+    num_points_++;
+    max_z_ = std::max(max_z_, new_point.point_.z);
+    sum_ = sum;
+    sum_outer_ = sum_outer;
     return true;
   }
-  Eigen::Vector3d old_params = slope_;
-  Eigen::Vector3d old_intercept = intercept_;
-  Eigen::MatrixXd A(total_points, 3);
-  Eigen::MatrixXd mean(1, 3);
-  for (int i = 0; i < total_points; i++)
-  {
-    Prototype pt;
-    if (i == total_points - 1)
-    {
-      pt = new_point;
-    }
-    else
-    {
-      pt = model_points_[i];
-    }
 
-    A(i, 0) = pt.point_.x;
-    A(i, 1) = pt.point_.y;
-    A(i, 2) = pt.point_.z;
-    mean(0, 0) += pt.point_.x;
-    mean(0, 1) += pt.point_.y;
-    mean(0, 2) += pt.point_.z;
-  }
-  mean /= -total_points;
-  A += mean.replicate(total_points, 1);
-  getSlopeIntercept(A, mean);
-  double squared_error = distFromPoint(new_point);
-  for (const Prototype &pt : model_points_)
-  {
-    squared_error += distFromPoint(pt);
-  }
+  const Eigen::Vector3d mean = sum / total_points;
+  const Eigen::Matrix3d scatter = sum_outer - total_points * mean * mean.transpose();
+  Eigen::SelfAdjointEigenSolver<Eigen::Matrix3d> solver;
+  solver.computeDirect(scatter);
+
+  // The eigenvalues are in increasing order. The largest one is the scatter along the best fit line, so the other two
+  // add up to the sum of squared distances from the points to the line.
+  double squared_error = solver.eigenvalues()(0) + solver.eigenvalues()(1);
   if (squared_error > error_t_)
   {
-    slope_ = old_params;
-    intercept_ = old_intercept;
     return false;
   }
-  model_points_.emplace_back(new_point);
+  slope_ = solver.eigenvectors().col(2);
+  intercept_ = mean;
+  sum_ = sum;
+  sum_outer_ = sum_outer;
+  num_points_++;
+  max_z_ = std::max(max_z_, new_point.point_.z);
   end_point_ = new_point;
   return true;
 }
 
-void Line::getSlopeIntercept(const Eigen::MatrixXd &A, const Eigen::MatrixXd &mean)
+FastSegmentFilter::FastSegmentFilter(const ros::NodeHandle &nh)
+  : private_nh_{ nh }
+  , config_{ nh }
+  , num_segments_{ config_.num_segments }
+  , thread_pool_{ static_cast<size_t>(std::max(config_.num_threads, 0)) }
 {
-  Eigen::JacobiSVD<Eigen::MatrixXd> svd(A, Eigen::ComputeFullU | Eigen::ComputeFullV);
-  slope_ = svd.matrixV().col(0);
-  intercept_(0) = -mean(0, 0);
-  intercept_(1) = -mean(0, 1);
-  intercept_(2) = -mean(0, 2);
-  slope_.normalize();
+  ground_pub_ = { private_nh_, config_.ground_topic, 1 };
+  nonground_pub_ = { private_nh_, config_.nonground_topic, 1 };
+  marker_pub_ = { private_nh_, "Lines_array", 1 };
 }
 
-FastSegmentFilter::FastSegmentFilter(const ros::NodeHandle &nh) : private_nh_{ nh }, config_{ nh }
+void FastSegmentFilter::computePrototypePoints()
 {
-  ground_pub_ = private_nh_.advertise<pcl::PointCloud<velodyne_pcl::PointXYZIRT>>(config_.ground_topic, 1);
-  nonground_pub_ = private_nh_.advertise<pcl::PointCloud<velodyne_pcl::PointXYZIRT>>(config_.nonground_topic, 1);
-  marker_pub_ = private_nh_.advertise<visualization_msgs::MarkerArray>("Lines_array", 1);
-  ;
+  thread_pool_.parallelFor(segments_.size(), [this](size_t segment_id) { computePrototypePoints(segment_id); });
 }
 
-void FastSegmentFilter::computePrototypePoints()
+void FastSegmentFilter::computePrototypePoints(size_t segment_id)
 {
-  for (const auto &seg : segments_)
+  Segment &segment = segments_[segment_id];
+  const PrototypeCell *cells = prototype_cells_.data() + segment_id * num_rings_;
+  for (int ring = 0; ring < num_rings_; ring++)
   {
-    std::map<int, std::vector<velodyne_pcl::PointXYZIRT>> bins_raw;
-    for (const auto &point : seg.second.raw_points_)
-    {
-      bins_raw[point.ring].emplace_back(point);
-    }
-    for (const auto &bin : bins_raw)
+    if (cells[ring].point != PrototypeCell::empty)
     {
-      velodyne_pcl::PointXYZIRT prototype_pt = bin.second[0];
-      for (const auto &point : bin.second)
-      {
-        if (point.z < prototype_pt.z)
-        {
-          prototype_pt = point;
-        }
-      }
+      const velodyne_pcl::PointXYZIRT &prototype_pt = segment.raw_points_[cells[ring].point];
       Prototype ptype = { getDistanceFromPoint(prototype_pt), prototype_pt };
-      segments_[seg.first].prototype_points_.emplace_back(ptype);
+      segment.prototype_points_.emplace_back(ptype);
     }
   }
 }
 
 void FastSegmentFilter::getLinesFromSegments()
 {
-  for (auto &seg : segments_)
+  thread_pool_.parallelFor(segments_.size(), [this](size_t segment_id) { getLinesFromSegment(segments_[segment_id]); });
+}
+
+void FastSegmentFilter::getLinesFromSegment(Segment &seg)
+{
+  sort(seg.prototype_points_.begin(), seg.prototype_points_.end());
+  Line curr_line = Line(config_.error_t, 0);
+  for (size_t i = 0; i < seg.prototype_points_.size(); i++)
   {
-    sort(seg.second.prototype_points_.begin(), seg.second.prototype_points_.end());
-    Line curr_line = Line(config_.error_t);
-    for (const Prototype &pt : seg.second.prototype_points_)
-    {
-      if (!curr_line.attemptFitPoint(pt))
-      {
-        curr_line.is_ground_ = evaluateIsGround(curr_line);
-        seg.second.lines_.emplace_back(curr_line);
-        curr_line = Line(config_.error_t);
-        curr_line.attemptFitPoint(pt);
-      }
-    }
-    curr_line.is_ground_ = evaluateIsGround(curr_line);
-    if (curr_line.model_points_.size() > 1)
+    const Prototype &pt = seg.prototype_points_[i];
+    if (!curr_line.attemptFitPoint(pt))
     {
-      seg.second.lines_.emplace_back(curr_line);
+      curr_line.is_ground_ = evaluateIsGround(curr_line);
+      seg.lines_.emplace_back(curr_line);
+      curr_line = Line(config_.error_t, i);
+      curr_line.attemptFitPoint(pt);
     }
   }
+  curr_line.is_ground_ = evaluateIsGround(curr_line);
+  if (curr_line.num_points_ > 1)
+  {
+    seg.lines_.emplace_back(curr_line);
+  }
 }
 
-void FastSegmentFilter::classifyPoints(pcl::PointCloud<velodyne_pcl::PointXYZIRT> &ground_points,
-                                       pcl::PointCloud<velodyne_pcl::PointXYZIRT> &nonground_points)
+void FastSegmentFilter::classifyPoints(pcl::PointCloud<velodyne_pcl::PointXYZIRT> *ground_points,
+                                       pcl::PointCloud<velodyne_pcl::PointXYZIRT> *nonground_points,
+                                       std::vector<int> *nonground_indices)
 {
-  for (const auto &[segment_id, segment] : segments_)
+  thread_pool_.parallelFor(segments_.size(), [this](size_t segment_id) { classifySegment(segments_[segment_id]); });
+
+  // Concatenating in segment order gives the same output as classifying the segments one after the other
+  for (const auto &segment : segments_)
   {
-    for (const auto &point : segment.raw_points_)
+    for (size_t i = 0; i < segment.raw_points_.size(); i++)
     {
-      Line mapped_line;
-      double min_dist = -1;
-      for (const auto &line : segment.lines_)
+      const auto &point = segment.raw_points_[i];
+      if (segment.is_ground_[i])
       {
-        for (const auto &pt : line.model_points_)
+        if (ground_points != nullptr)
         {
-          double distance = getDistanceBetweenPoints(point, pt.point_);
-          if (min_dist == -1 || distance < min_dist)
-          {
-            min_dist = distance;
-            mapped_line = line;
-          }
+          ground_points->push_back(point);
         }
       }
-      if (mapped_line.is_ground_)  // Removed max dist = nonground since was more pain than good
+      else
       {
-        ground_points.push_back(point);
+        if (nonground_points != nullptr)
+        {
+          nonground_points->push_back(point);
+        }
+        if (nonground_indices != nullptr)
+        {
+          nonground_indices->emplace_back(segment.raw_indices_[i]);
+        }
       }
-      else
+    }
+  }
+}
+
+void FastSegmentFilter::classifySegment(Segment &segment)
+{
+  segment.is_ground_.resize(segment.raw_points_.size());
+  for (size_t i = 0; i < segment.raw_points_.size(); i++)
+  {
+    const auto &point = segment.raw_points_[i];
+    const Line *mapped_line = nullptr;
+    double min_dist = -1;
+    for (const auto &line : segment.lines_)
+    {
+      for (size_t p = line.first_point_; p < line.first_point_ + line.num_points_; p++)
       {
-        nonground_points.push_back(point);
+        double distance = getDistanceBetweenPoints(point, segment.prototype_points_[p].point_);
+        if (min_dist == -1 || distance < min_dist)
+        {
+          min_dist = distance;
+          mapped_line = &line;
+        }
       }
     }
+    // Removed max dist = nonground since was more pain than good
+    segment.is_ground_[i] = mapped_line != nullptr && mapped_line->is_ground_;
   }
 }
 
-int FastSegmentFilter::getSegIdFromPoint(const velodyne_pcl::PointXYZIRT point)
+int FastSegmentFilter::getSegIdFromAzimuth(double azimuth) const
 {
-  double angle = atan2(point.y, point.x) + M_PI;
-  return angle * config_.num_segments / (2 * M_PI);
+  double angle = azimuth + M_PI;
+  const int segment_id = angle * num_segments_ / (2 * M_PI);
+  return std::clamp(segment_id, 0, num_segments_ - 1);
 }
 
 double FastSegmentFilter::getDistanceFromPoint(const velodyne_pcl::PointXYZIRT point)
@@ -215,8 +274,7 @@ double FastSegmentFilter::getDistanceBetweenPoints(const velodyne_pcl::PointXYZI
 
 bool FastSegmentFilter::evaluateIsGround(Line &l)
 {
-  const auto below_intercept = [&](const Prototype &pt) { return pt.point_.z < config_.dist_t; };
-  bool all_below = std::all_of(l.model_points_.begin(), l.model_points_.end(), below_intercept);
+  bool all_below = l.max_z_ < config_.dist_t;
   if (all_below)
   {
     return true;
@@ -229,17 +287,18 @@ bool FastSegmentFilter::evaluateIsGround(Line &l)
   return slope < config_.slope_t;
 }
 
-void FastSegmentFilter::debugViz()
+visualization_msgs::MarkerArray FastSegmentFilter::debugViz() const
 {
   visualization_msgs::MarkerArray lines;
   int i = 0;
 
   for (const auto &seg : segments_)
   {
-    for (const Line &line : seg.second.lines_)
+    for (const Line &line : seg.lines_)
     {
-      for (Prototype pt : line.model_points_)
+      for (size_t point_index = line.first_point_; point_index < line.first_point_ + line.num_points_; point_index++)
       {
+        const Prototype &pt = seg.prototype_points_[point_index];
         visualization_msgs::Marker points;
         points.header.frame_id = "/lidar";
         points.header.stamp = ros::Time::now();
@@ -297,6 +356,6 @@ void FastSegmentFilter::debugViz()
       lines.markers.push_back(line_list);
     }
   }
-  marker_pub_.publish(lines);
+  return lines;
 }
 }  // namespace pointcloud_filter
@@ -15,5 +15,6 @@ FastSegmentFilterConfig::FastSegmentFilterConfig(const ros::NodeHandle& nh)
   assertions::getParam(child_nh, "slope_t", slope_t);
   assertions::getParam(child_nh, "dist_t", dist_t);
   assertions::getParam(child_nh, "debug_viz", debug_viz);
+  num_threads = assertions::param(child_nh, "num_threads", 1);
 }
 }  // namespace pointcloud_filter
\ No newline at end of file
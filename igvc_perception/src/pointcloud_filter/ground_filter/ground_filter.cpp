@@ -1,4 +1,5 @@
 #include <pointcloud_filter/ground_filter/ground_filter.h>
+#include <pointcloud_filter/point_kernels.h>
 
 namespace pointcloud_filter
 {
@@ -8,21 +9,18 @@ GroundFilter::GroundFilter(const ros::NodeHandle& nh) : config_{ nh }
 
 void GroundFilter::filter(pointcloud_filter::Bundle& bundle)
 {
-  const auto& height_min = config_.height_min;
-  const auto& height_max = config_.height_max;
+  const auto& z = bundle.points.z;
 
-  PointCloud filtered_pc;
-  filtered_pc.points.reserve(bundle.pointcloud->points.size());
+  within_thresholds_.assign(z.size(), 1);
+  kernels::maskInRange(z.data(), z.size(), config_.height_min, config_.height_max, within_thresholds_.data());
 
-  for (const auto& point : *bundle.pointcloud)
+  bundle.occupied_indices.clear();
+  for (int index : bundle.indices)
   {
-    bool within_thresholds = height_min <= point.z && point.z <= height_max;
-    if (within_thresholds)
+    if (within_thresholds_[index])
     {
-      filtered_pc.points.emplace_back(point);
+      bundle.occupied_indices.emplace_back(index);
     }
   }
-  bundle.occupied_pointcloud->header = bundle.pointcloud->header;
-  bundle.occupied_pointcloud->points = std::move(filtered_pc.points);
 }
 }  // namespace pointcloud_filter
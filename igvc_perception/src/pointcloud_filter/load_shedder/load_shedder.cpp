@@ -0,0 +1,83 @@
+#include <pointcloud_filter/load_shedder/load_shedder.h>
+
+#include <algorithm>
+
+namespace pointcloud_filter
+{
+LoadShedder::LoadShedder(const ros::NodeHandle& nh) : config_{ nh }
+{
+}
+
+LoadShedder::Level LoadShedder::level() const
+{
+  std::lock_guard<std::mutex> lock{ mutex_ };
+  return level_;
+}
+
+double LoadShedder::averageMs() const
+{
+  std::lock_guard<std::mutex> lock{ mutex_ };
+  return average_ms_;
+}
+
+void LoadShedder::recordFrame(double frame_ms)
+{
+  if (!config_.enabled)
+  {
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock{ mutex_ };
+  average_ms_ = has_average_ ? average_ms_ + config_.smoothing * (frame_ms - average_ms_) : frame_ms;
+  has_average_ = true;
+
+  if (++frames_since_change_ < config_.hold_frames)
+  {
+    return;
+  }
+
+  const Level previous = level_;
+  if (average_ms_ > config_.budget_ms && level_ + 1 < num_levels)
+  {
+    level_ = static_cast<Level>(level_ + 1);
+  }
+  else if (average_ms_ < config_.recover_ratio * config_.budget_ms && level_ > full_quality)
+  {
+    level_ = static_cast<Level>(level_ - 1);
+  }
+
+  if (level_ != previous)
+  {
+    frames_since_change_ = 0;
+    ROS_INFO("Pointcloud filter averaging %.1f ms per scan for a budget of %.1f ms, switching from %s to %s",
+             average_ms_, config_.budget_ms, levelName(previous), levelName(level_));
+  }
+}
+
+void LoadShedder::subsample(Bundle& bundle) const
+{
+  const RangeImage& range_image = bundle.rangeImage();
+  const int stride = config_.column_stride;
+  auto& indices = bundle.indices;
+  indices.erase(std::remove_if(indices.begin(), indices.end(),
+                               [&](int index) { return range_image.column(index) % stride != 0; }),
+                indices.end());
+}
+
+const char* LoadShedder::levelName(Level level)
+{
+  switch (level)
+  {
+    case full_quality:
+      return "full quality";
+    case subsampled_columns:
+      return "subsampled columns";
+    case coarse_segments:
+      return "coarse segments";
+    case no_debug_output:
+      return "no debug output";
+    default:
+      return "unknown";
+  }
+}
+}  // namespace pointcloud_filter
@@ -0,0 +1,19 @@
+#include <parameter_assertions/assertions.h>
+#include <pointcloud_filter/load_shedder/load_shedder_config.h>
+#include <algorithm>
+
+namespace pointcloud_filter
+{
+LoadShedderConfig::LoadShedderConfig(const ros::NodeHandle &nh)
+{
+  ros::NodeHandle child_nh{ nh, "load_shedding" };
+
+  enabled = assertions::param(child_nh, "enabled", false);
+  budget_ms = assertions::param(child_nh, "budget_ms", 80.0);
+  smoothing = assertions::param(child_nh, "smoothing", 0.2);
+  recover_ratio = assertions::param(child_nh, "recover_ratio", 0.7);
+  hold_frames = assertions::param(child_nh, "hold_frames", 10);
+  column_stride = std::max(assertions::param(child_nh, "column_stride", 2), 1);
+  segment_divisor = std::max(assertions::param(child_nh, "segment_divisor", 2), 1);
+}
+}  // namespace pointcloud_filter
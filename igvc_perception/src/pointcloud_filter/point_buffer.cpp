@@ -0,0 +1,80 @@
+#include <pointcloud_filter/point_buffer.h>
+
+namespace pointcloud_filter
+{
+PointBuffer::PointBuffer(const PointCloud& pointcloud)
+{
+  assign(pointcloud);
+}
+
+void PointBuffer::resize(size_t size)
+{
+  x.resize(size);
+  y.resize(size);
+  z.resize(size);
+  intensity.resize(size);
+  ring.resize(size);
+  time.resize(size);
+}
+
+void PointBuffer::assign(const PointCloud& pointcloud)
+{
+  resize(pointcloud.size());
+  for (size_t i = 0; i < pointcloud.size(); i++)
+  {
+    const auto& point = pointcloud.points[i];
+    x[i] = point.x;
+    y[i] = point.y;
+    z[i] = point.z;
+    intensity[i] = point.intensity;
+    ring[i] = point.ring;
+    time[i] = point.time;
+  }
+}
+
+size_t PointBuffer::capacityBytes() const
+{
+  return (x.capacity() + y.capacity() + z.capacity() + intensity.capacity() + time.capacity()) * sizeof(float) +
+         ring.capacity() * sizeof(uint16_t);
+}
+
+PointBuffer PointBuffer::select(const std::vector<int>& indices) const
+{
+  PointBuffer selected;
+  select(indices, selected);
+  return selected;
+}
+
+void PointBuffer::select(const std::vector<int>& indices, PointBuffer& selected) const
+{
+  selected.resize(indices.size());
+  for (size_t i = 0; i < indices.size(); i++)
+  {
+    const int index = indices[i];
+    selected.x[i] = x[index];
+    selected.y[i] = y[index];
+    selected.z[i] = z[index];
+    selected.intensity[i] = intensity[index];
+    selected.ring[i] = ring[index];
+    selected.time[i] = time[index];
+  }
+}
+
+void PointBuffer::toPointCloud(PointCloud& pointcloud) const
+{
+  pointcloud.points.resize(size());
+  for (size_t i = 0; i < size(); i++)
+  {
+    auto& point = pointcloud.points[i];
+    point.x = x[i];
+    point.y = y[i];
+    point.z = z[i];
+    point.data[3] = 1.0f;
+    point.intensity = intensity[i];
+    point.ring = ring[i];
+    point.time = time[i];
+  }
+  pointcloud.width = size();
+  pointcloud.height = 1;
+}
+}  // namespace pointcloud_filter
@@ -0,0 +1,256 @@
+#include <pointcloud_filter/point_kernels.h>
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__x86_64__) || defined(__i386__)
+// The AVX2 kernels are compiled for AVX2 regardless of the build flags, and only called if the CPU supports it
+#define POINT_KERNELS_AVX2
+#define AVX2_TARGET __attribute__((target("avx2")))
+#include <immintrin.h>
+#endif
+
+namespace pointcloud_filter
+{
+namespace kernels
+{
+namespace
+{
+// atan(a) for a in [0, 1], max error ~2e-5 rad
+inline float atanUnit(float a)
+{
+  const float s = a * a;
+  return ((((0.0208351f * s - 0.085133f) * s + 0.180141f) * s - 0.3302995f) * s + 0.999866f) * a;
+}
+
+// Same approximation as the vector version, so that the results don't depend on the CPU
+inline float approxAtan2(float y, float x)
+{
+  const float abs_x = std::abs(x);
+  const float abs_y = std::abs(y);
+  const float max = std::max(abs_x, abs_y);
+  const float ratio = max == 0.0f ? 0.0f : std::min(abs_x, abs_y) / max;
+  float angle = atanUnit(ratio);
+  if (abs_y > abs_x)
+  {
+    angle = static_cast<float>(M_PI_2) - angle;
+  }
+  if (x < 0.0f)
+  {
+    angle = static_cast<float>(M_PI) - angle;
+  }
+  return std::copysign(angle, y);
+}
+
+#ifdef POINT_KERNELS_AVX2
+constexpr size_t lanes = 8;
+
+bool hasAvx2()
+{
+  static const bool supported = [] {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") != 0;
+  }();
+  return supported;
+}
+
+AVX2_TARGET inline __m256 atanUnit(__m256 a)
+{
+  const __m256 s = _mm256_mul_ps(a, a);
+  __m256 result = _mm256_set1_ps(0.0208351f);
+  result = _mm256_add_ps(_mm256_mul_ps(result, s), _mm256_set1_ps(-0.085133f));
+  result = _mm256_add_ps(_mm256_mul_ps(result, s), _mm256_set1_ps(0.180141f));
+  result = _mm256_add_ps(_mm256_mul_ps(result, s), _mm256_set1_ps(-0.3302995f));
+  result = _mm256_add_ps(_mm256_mul_ps(result, s), _mm256_set1_ps(0.999866f));
+  return _mm256_mul_ps(result, a);
+}
+
+AVX2_TARGET inline __m256 approxAtan2(__m256 y, __m256 x)
+{
+  const __m256 sign_bit = _mm256_set1_ps(-0.0f);
+  const __m256 abs_x = _mm256_andnot_ps(sign_bit, x);
+  const __m256 abs_y = _mm256_andnot_ps(sign_bit, y);
+  const __m256 max = _mm256_max_ps(abs_x, abs_y);
+  const __m256 min = _mm256_min_ps(abs_x, abs_y);
+  const __m256 max_is_zero = _mm256_cmp_ps(max, _mm256_setzero_ps(), _CMP_EQ_OQ);
+  const __m256 ratio = _mm256_andnot_ps(max_is_zero, _mm256_div_ps(min, max));
+
+  __m256 angle = atanUnit(ratio);
+  const __m256 y_larger = _mm256_cmp_ps(abs_y, abs_x, _CMP_GT_OQ);
+  angle = _mm256_blendv_ps(angle, _mm256_sub_ps(_mm256_set1_ps(M_PI_2), angle), y_larger);
+  const __m256 x_negative = _mm256_cmp_ps(x, _mm256_setzero_ps(), _CMP_LT_OQ);
+  angle = _mm256_blendv_ps(angle, _mm256_sub_ps(_mm256_set1_ps(M_PI), angle), x_negative);
+  return _mm256_or_ps(angle, _mm256_and_ps(sign_bit, y));
+}
+
+/**
+ * Transforms the points in whole vectors, and returns the number of points transformed
+ */
+AVX2_TARGET size_t transformAvx2(const Eigen::Matrix3f& rotation, const Eigen::Vector3f& translation, float* x,
+                                 float* y, float* z, size_t count)
+{
+  __m256 r[3][3];
+  __m256 t[3];
+  for (int row = 0; row < 3; row++)
+  {
+    for (int col = 0; col < 3; col++)
+    {
+      r[row][col] = _mm256_set1_ps(rotation(row, col));
+    }
+    t[row] = _mm256_set1_ps(translation(row));
+  }
+
+  size_t i = 0;
+  for (; i + lanes <= count; i += lanes)
+  {
+    const __m256 px = _mm256_loadu_ps(x + i);
+    const __m256 py = _mm256_loadu_ps(y + i);
+    const __m256 pz = _mm256_loadu_ps(z + i);
+    __m256 out[3];
+    for (int row = 0; row < 3; row++)
+    {
+      out[row] = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(r[row][0], px), _mm256_mul_ps(r[row][1], py)),
+                               _mm256_add_ps(_mm256_mul_ps(r[row][2], pz), t[row]));
+    }
+    _mm256_storeu_ps(x + i, out[0]);
+    _mm256_storeu_ps(y + i, out[1]);
+    _mm256_storeu_ps(z + i, out[2]);
+  }
+  return i;
+}
+
+AVX2_TARGET void rangeAzimuthAvx2(const float* x, const float* y, size_t count, float* range, float* azimuth)
+{
+  size_t i = 0;
+  for (; i + lanes <= count; i += lanes)
+  {
+    const __m256 px = _mm256_loadu_ps(x + i);
+    const __m256 py = _mm256_loadu_ps(y + i);
+    _mm256_storeu_ps(range + i, _mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(px, px), _mm256_mul_ps(py, py))));
+    _mm256_storeu_ps(azimuth + i, approxAtan2(py, px));
+  }
+  for (; i < count; i++)
+  {
+    range[i] = std::sqrt(x[i] * x[i] + y[i] * y[i]);
+    azimuth[i] = approxAtan2(y[i], x[i]);
+  }
+}
+
+AVX2_TARGET void inclinationAvx2(const float* x0, const float* y0, const float* z0, const float* x1, const float* y1,
+                                 const float* z1, size_t count, float* angle)
+{
+  size_t i = 0;
+  for (; i + lanes <= count; i += lanes)
+  {
+    const __m256 dx = _mm256_sub_ps(_mm256_loadu_ps(x1 + i), _mm256_loadu_ps(x0 + i));
+    const __m256 dy = _mm256_sub_ps(_mm256_loadu_ps(y1 + i), _mm256_loadu_ps(y0 + i));
+    const __m256 dz = _mm256_sub_ps(_mm256_loadu_ps(z1 + i), _mm256_loadu_ps(z0 + i));
+    const __m256 horizontal = _mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)));
+    _mm256_storeu_ps(angle + i, approxAtan2(dz, horizontal));
+  }
+  for (; i < count; i++)
+  {
+    const float dx = x1[i] - x0[i];
+    const float dy = y1[i] - y0[i];
+    angle[i] = approxAtan2(z1[i] - z0[i], std::sqrt(dx * dx + dy * dy));
+  }
+}
+
+/**
+ * Masks the values in whole vectors, and returns the number of values masked
+ */
+AVX2_TARGET size_t maskInRangeAvx2(const float* values, size_t count, float min, float max, uint8_t* mask)
+{
+  const __m256 min_v = _mm256_set1_ps(min);
+  const __m256 max_v = _mm256_set1_ps(max);
+  size_t i = 0;
+  for (; i + lanes <= count; i += lanes)
+  {
+    const __m256 v = _mm256_loadu_ps(values + i);
+    const __m256 in_range = _mm256_and_ps(_mm256_cmp_ps(v, min_v, _CMP_GE_OQ), _mm256_cmp_ps(v, max_v, _CMP_LE_OQ));
+    const int bits = _mm256_movemask_ps(in_range);
+    for (size_t lane = 0; lane < lanes; lane++)
+    {
+      mask[i + lane] &= (bits >> lane) & 1;
+    }
+  }
+  return i;
+}
+#endif
+}  // namespace
+
+void transform(const Eigen::Isometry3f& transform, PointBuffer& points)
+{
+  const Eigen::Matrix3f rotation = transform.linear();
+  const Eigen::Vector3f translation = transform.translation();
+  float* x = points.x.data();
+  float* y = points.y.data();
+  float* z = points.z.data();
+  const size_t count = points.size();
+
+  size_t i = 0;
+#ifdef POINT_KERNELS_AVX2
+  if (hasAvx2())
+  {
+    i = transformAvx2(rotation, translation, x, y, z, count);
+  }
+#endif
+  for (; i < count; i++)
+  {
+    const Eigen::Vector3f point = rotation * Eigen::Vector3f{ x[i], y[i], z[i] } + translation;
+    x[i] = point(0);
+    y[i] = point(1);
+    z[i] = point(2);
+  }
+}
+
+void rangeAzimuth(const float* x, const float* y, size_t count, float* range, float* azimuth)
+{
+#ifdef POINT_KERNELS_AVX2
+  if (hasAvx2())
+  {
+    rangeAzimuthAvx2(x, y, count, range, azimuth);
+    return;
+  }
+#endif
+  for (size_t i = 0; i < count; i++)
+  {
+    range[i] = std::sqrt(x[i] * x[i] + y[i] * y[i]);
+    azimuth[i] = approxAtan2(y[i], x[i]);
+  }
+}
+
+void inclination(const float* x0, const float* y0, const float* z0, const float* x1, const float* y1, const float* z1,
+                 size_t count, float* angle)
+{
+#ifdef POINT_KERNELS_AVX2
+  if (hasAvx2())
+  {
+    inclinationAvx2(x0, y0, z0, x1, y1, z1, count, angle);
+    return;
+  }
+#endif
+  for (size_t i = 0; i < count; i++)
+  {
+    const float dx = x1[i] - x0[i];
+    const float dy = y1[i] - y0[i];
+    angle[i] = approxAtan2(z1[i] - z0[i], std::sqrt(dx * dx + dy * dy));
+  }
+}
+
+void maskInRange(const float* values, size_t count, float min, float max, uint8_t* mask)
+{
+  size_t i = 0;
+#ifdef POINT_KERNELS_AVX2
+  if (hasAvx2())
+  {
+    i = maskInRangeAvx2(values, count, min, max, mask);
+  }
+#endif
+  for (; i < count; i++)
+  {
+    mask[i] &= min <= values[i] && values[i] <= max;
+  }
+}
+}  // namespace kernels
+}  // namespace pointcloud_filter
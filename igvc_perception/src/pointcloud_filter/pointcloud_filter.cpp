@@ -1,9 +1,4 @@
-#include <parameter_assertions/assertions.h>
-#include <pcl/filters/voxel_grid.h>
-#include <pcl_ros/point_cloud.h>
-#include <pcl_ros/transforms.h>
 #include <pointcloud_filter/pointcloud_filter.h>
-#include <sensor_msgs/PointCloud2.h>
 
 namespace pointcloud_filter
 {
@@ -13,50 +8,34 @@ PointcloudFilter::PointcloudFilter(const ros::NodeHandle& nh, const ros::NodeHan
   , config_{ private_nh_ }
   , buffer_{}
   , listener_{ buffer_ }
-  , back_filter_{ private_nh_ }
-  , radius_filter_{ private_nh_ }
-  , tf_transform_filter_{ &buffer_ }
-  , ground_filter_{ private_nh_ }
-  , raycast_filter_{ private_nh_ }
-  , fast_segment_filter_{ private_nh_ }
+  , transform_cache_{ &buffer_, private_nh_ }
 {
-  setupPubSub();
-}
-
-void PointcloudFilter::setupPubSub()
-{
-  raw_pointcloud_sub_ = nh_.subscribe(config_.topic_input, 1, &PointcloudFilter::pointcloudCallback, this);
+  updater_.setHardwareID("lidar");
+  diagnostics_timer_ = nh_.createTimer(ros::Duration(1.0), [this](const ros::TimerEvent&) { updater_.update(); });
 
-  transformed_pointcloud_pub_ = nh_.advertise<sensor_msgs::PointCloud2>(config_.topic_transformed, 1);
-  occupied_pointcloud_pub_ = nh_.advertise<sensor_msgs::PointCloud2>(config_.topic_occupied, 1);
-  free_pointcloud_pub_ = nh_.advertise<sensor_msgs::PointCloud2>(config_.topic_free, 1);
-
-  filtered_pointcloud_pub_ = nh_.advertise<sensor_msgs::PointCloud2>(config_.topic_filtered, 1);
+  setupSensors();
 }
 
-void PointcloudFilter::pointcloudCallback(const PointCloud::ConstPtr& raw_pointcloud)
+void PointcloudFilter::setupSensors()
 {
-  Bundle bundle{ raw_pointcloud };
-
-  radius_filter_.filter(bundle);
-
-  back_filter_.filter(bundle);
-
-  filtered_pointcloud_pub_.publish(bundle.pointcloud);
-
-  fast_segment_filter_.filter(bundle);
-
-  std::string base_frame = config_.base_frame;
-  std::string lidar_frame = raw_pointcloud->header.frame_id;
-  ros::Duration timeout{ config_.timeout_duration };
-
-  tf_transform_filter_.transform(*bundle.pointcloud, *bundle.pointcloud, base_frame, timeout);
-
-  tf_transform_filter_.transform(*bundle.occupied_pointcloud, *bundle.occupied_pointcloud, lidar_frame, timeout);
-  raycast_filter_.filter(bundle);
-
-  transformed_pointcloud_pub_.publish(bundle.pointcloud);
-  occupied_pointcloud_pub_.publish(bundle.occupied_pointcloud);
-  free_pointcloud_pub_.publish(bundle.free_pointcloud);
+  if (config_.sensors.empty())
+  {
+    SensorPipeline& sensor =
+        *sensors_.emplace_back(std::make_unique<SensorPipeline>(nh_, private_nh_, config_, &transform_cache_));
+    updater_.add("Pointcloud Filter Pipeline", &sensor, &SensorPipeline::diagnostic);
+    return;
+  }
+
+  merger_ = std::make_unique<ScanMerger>(nh_, private_nh_, config_, config_.sensors.size(), &transform_cache_);
+  updater_.add("Pointcloud Filter Merger", merger_.get(), &ScanMerger::diagnostic);
+
+  for (size_t sensor_index = 0; sensor_index < config_.sensors.size(); sensor_index++)
+  {
+    const std::string& name = config_.sensors[sensor_index];
+    ros::NodeHandle sensor_nh{ private_nh_, name };
+    SensorPipeline& sensor = *sensors_.emplace_back(
+        std::make_unique<SensorPipeline>(nh_, sensor_nh, config_, &transform_cache_, merger_.get(), sensor_index));
+    updater_.add("Pointcloud Filter Pipeline: " + name, &sensor, &SensorPipeline::diagnostic);
+  }
 }
 }  // namespace pointcloud_filter
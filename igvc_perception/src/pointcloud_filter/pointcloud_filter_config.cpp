@@ -5,14 +5,13 @@ namespace pointcloud_filter
 {
 PointcloudFilterConfig::PointcloudFilterConfig(const ros::NodeHandle &nh)
 {
-  assertions::getParam(nh, "topic/input", topic_input);
-  assertions::getParam(nh, "topic/transformed", topic_transformed);
   assertions::getParam(nh, "topic/occupied", topic_occupied);
   assertions::getParam(nh, "topic/free", topic_free);
-  assertions::getParam(nh, "topic/filtered", topic_filtered);
 
   assertions::getParam(nh, "frames/base_footprint", base_frame);
 
+  sensors = assertions::param(nh, "sensors", std::vector<std::string>{});
+
   assertions::getParam(nh, "timeout_duration", timeout_duration);
 }
 }  // namespace pointcloud_filter
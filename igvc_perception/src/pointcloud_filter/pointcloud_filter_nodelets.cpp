@@ -0,0 +1,40 @@
+#include <nodelet/nodelet.h>
+#include <pluginlib/class_list_macros.h>
+
+#include <pointcloud_filter/actual_barrel_segmentation.h>
+#include <pointcloud_filter/pointcloud_filter.h>
+
+namespace pointcloud_filter
+{
+/**
+ * Runs PointcloudFilter inside a nodelet manager, so that its clouds reach the other lidar nodelets as shared
+ * pointers instead of being serialized.
+ */
+class PointcloudFilterNodelet : public nodelet::Nodelet
+{
+private:
+  std::unique_ptr<PointcloudFilter> pointcloud_filter_;
+
+  void onInit() override
+  {
+    pointcloud_filter_ = std::make_unique<PointcloudFilter>(getNodeHandle(), getPrivateNodeHandle());
+  }
+};
+
+/**
+ * Runs BarrelSegmentation inside a nodelet manager, so that it shares the nonground cloud with PointcloudFilter.
+ */
+class BarrelSegmentationNodelet : public nodelet::Nodelet
+{
+private:
+  std::unique_ptr<BarrelSegmentation> barrel_segmentation_;
+
+  void onInit() override
+  {
+    barrel_segmentation_ = std::make_unique<BarrelSegmentation>(getNodeHandle(), getPrivateNodeHandle());
+  }
+};
+}  // namespace pointcloud_filter
+
+PLUGINLIB_EXPORT_CLASS(pointcloud_filter::PointcloudFilterNodelet, nodelet::Nodelet)
+PLUGINLIB_EXPORT_CLASS(pointcloud_filter::BarrelSegmentationNodelet, nodelet::Nodelet)
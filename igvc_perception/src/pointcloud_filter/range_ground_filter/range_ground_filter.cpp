@@ -0,0 +1,189 @@
+#include <algorithm>
+#include <cmath>
+
+#include <pointcloud_filter/point_kernels.h>
+#include <pointcloud_filter/range_ground_filter/range_ground_filter.h>
+
+namespace pointcloud_filter
+{
+RangeGroundFilter::RangeGroundFilter(const ros::NodeHandle& nh)
+  : config_{ nh }
+  , cos_pitch_{ static_cast<float>(std::cos(config_.pitch)) }
+  , sin_pitch_{ static_cast<float>(std::sin(config_.pitch)) }
+{
+  ros::NodeHandle publisher_nh{ nh };
+  ground_pub_ = { publisher_nh, config_.ground_topic, 1 };
+  nonground_pub_ = { publisher_nh, config_.nonground_topic, 1 };
+}
+
+void RangeGroundFilter::setDebugOutput(bool enabled)
+{
+  debug_output_ = enabled;
+}
+
+void RangeGroundFilter::filter(Bundle& bundle)
+{
+  const RangeImage& range_image = bundle.rangeImage();
+  buildGrid(bundle, range_image);
+  computeAngles();
+  labelGround();
+
+  const bool publish_ground = debug_output_ && ground_pub_.hasSubscribers();
+  const auto max_cell_height = static_cast<float>(config_.max_cell_height);
+  bundle.occupied_indices.clear();
+  ground_indices_.clear();
+  for (int index : bundle.indices)
+  {
+    if (!hasReturn(bundle.points, index))
+    {
+      continue;
+    }
+    const int cell = bundle.points.ring[index] * columns_ + range_image.column(index);
+    // The other points of a ground cell can still be the foot of an obstacle
+    if (ground_[cell] && levelZ(bundle.points, index) - z_[cell] <= max_cell_height)
+    {
+      if (publish_ground)
+      {
+        ground_indices_.emplace_back(index);
+      }
+    }
+    else
+    {
+      bundle.occupied_indices.emplace_back(index);
+    }
+  }
+
+  if (publish_ground)
+  {
+    ground_pub_.publish([&] { return bundle.materialize(ground_indices_); });
+  }
+  nonground_pub_.publish([&] { return bundle.materialize(bundle.occupied_indices); });
+}
+
+void RangeGroundFilter::buildGrid(const Bundle& bundle, const RangeImage& range_image)
+{
+  rings_ = range_image.rings();
+  columns_ = range_image.columns();
+  const size_t num_cells = static_cast<size_t>(rings_) * columns_;
+
+  // assign() keeps the capacity of each grid, so after the first scan this doesn't allocate
+  cells_.assign(num_cells, RangeImage::empty);
+  x_.assign(num_cells, 0.0f);
+  y_.assign(num_cells, 0.0f);
+  z_.assign(num_cells, 0.0f);
+
+  const PointBuffer& points = bundle.points;
+  for (int index : bundle.indices)
+  {
+    // A point without a return has no meaningful column or height
+    if (!hasReturn(points, index))
+    {
+      continue;
+    }
+    const int cell = points.ring[index] * columns_ + range_image.column(index);
+    const float z = levelZ(points, index);
+    if (cells_[cell] == RangeImage::empty || z < z_[cell])
+    {
+      cells_[cell] = index;
+      x_[cell] = cos_pitch_ * points.x[index] + sin_pitch_ * points.z[index];
+      y_[cell] = points.y[index];
+      z_[cell] = z;
+    }
+  }
+}
+
+void RangeGroundFilter::computeAngles()
+{
+  const size_t num_cells = cells_.size();
+  if (num_cells == 0)
+  {
+    return;
+  }
+  below_.resize(num_cells);
+  above_.resize(num_cells);
+  below_x_.resize(num_cells);
+  below_y_.resize(num_cells);
+  below_z_.resize(num_cells);
+  angle_.resize(num_cells);
+
+  // Ring by ring, each cell takes the previous ring's cell if it's non empty and what it was linked to otherwise
+  std::fill_n(below_.begin(), columns_, RangeImage::empty);
+  std::fill_n(below_x_.begin(), columns_, 0.0f);
+  std::fill_n(below_y_.begin(), columns_, 0.0f);
+  std::fill_n(below_z_.begin(), columns_, 0.0f);
+  for (int cell = columns_; cell < static_cast<int>(num_cells); cell++)
+  {
+    const int previous = cell - columns_;
+    const bool occupied = cells_[previous] != RangeImage::empty;
+    below_[cell] = occupied ? previous : below_[previous];
+    below_x_[cell] = occupied ? x_[previous] : below_x_[previous];
+    below_y_[cell] = occupied ? y_[previous] : below_y_[previous];
+    below_z_[cell] = occupied ? z_[previous] : below_z_[previous];
+  }
+
+  const int last_ring = (rings_ - 1) * columns_;
+  std::fill_n(above_.begin() + last_ring, columns_, RangeImage::empty);
+  for (int cell = last_ring - 1; cell >= 0; cell--)
+  {
+    const int next = cell + columns_;
+    above_[cell] = cells_[next] != RangeImage::empty ? next : above_[next];
+  }
+
+  kernels::inclination(below_x_.data(), below_y_.data(), below_z_.data(), x_.data(), y_.data(), z_.data(), num_cells,
+                       angle_.data());
+
+  // The lowest cell of a column has nothing below it, so it's judged by the inclination up to the next cell
+  for (size_t cell = 0; cell < num_cells; cell++)
+  {
+    if (cells_[cell] != RangeImage::empty && below_[cell] == RangeImage::empty)
+    {
+      angle_[cell] = above_[cell] == RangeImage::empty ? static_cast<float>(M_PI_2) : angle_[above_[cell]];
+    }
+  }
+}
+
+void RangeGroundFilter::labelGround()
+{
+  ground_.assign(cells_.size(), 0);
+  queue_.clear();
+
+  const auto max_slope = static_cast<float>(config_.max_slope);
+  const auto seed_max_z = static_cast<float>(config_.seed_max_z);
+  for (int cell = 0; cell < static_cast<int>(cells_.size()); cell++)
+  {
+    if (cells_[cell] != RangeImage::empty && below_[cell] == RangeImage::empty && z_[cell] <= seed_max_z &&
+        std::abs(angle_[cell]) <= max_slope)
+    {
+      ground_[cell] = 1;
+      queue_.emplace_back(cell);
+    }
+  }
+
+  // queue_ only grows, so a read position is enough for the breadth first order
+  for (size_t head = 0; head < queue_.size(); head++)
+  {
+    const int cell = queue_[head];
+    const int ring_start = cell - cell % columns_;
+    const int column = cell - ring_start;
+    // Columns wrap around, since the range image covers the whole revolution
+    const int left = ring_start + (column == 0 ? columns_ - 1 : column - 1);
+    const int right = ring_start + (column == columns_ - 1 ? 0 : column + 1);
+
+    for (int neighbour : { below_[cell], above_[cell], left, right })
+    {
+      if (neighbour != RangeImage::empty && isGroundNeighbour(cell, neighbour))
+      {
+        ground_[neighbour] = 1;
+        queue_.emplace_back(neighbour);
+      }
+    }
+  }
+}
+
+bool RangeGroundFilter::isGroundNeighbour(int from, int to) const
+{
+  return cells_[to] != RangeImage::empty && !ground_[to] &&
+         std::abs(angle_[to]) <= static_cast<float>(config_.max_slope) &&
+         std::abs(angle_[to] - angle_[from]) <= static_cast<float>(config_.max_angle_change);
+}
+}  // namespace pointcloud_filter
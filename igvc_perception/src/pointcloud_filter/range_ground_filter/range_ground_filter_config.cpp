@@ -0,0 +1,18 @@
+#include <parameter_assertions/assertions.h>
+#include <pointcloud_filter/range_ground_filter/range_ground_filter_config.h>
+
+namespace pointcloud_filter
+{
+RangeGroundFilterConfig::RangeGroundFilterConfig(const ros::NodeHandle &nh)
+{
+  ros::NodeHandle child_nh{ nh, "range_ground_filter" };
+
+  ground_topic = assertions::param(child_nh, "ground_topic", std::string{ "/ground" });
+  nonground_topic = assertions::param(child_nh, "nonground_topic", std::string{ "/nonground" });
+  max_slope = assertions::param(child_nh, "max_slope", 0.17);
+  max_angle_change = assertions::param(child_nh, "max_angle_change", 0.09);
+  seed_max_z = assertions::param(child_nh, "seed_max_z", 0.0);
+  max_cell_height = assertions::param(child_nh, "max_cell_height", 0.1);
+  pitch = assertions::param(child_nh, "pitch", 0.0);
+}
+}  // namespace pointcloud_filter
@@ -0,0 +1,53 @@
+#include <pointcloud_filter/point_kernels.h>
+#include <pointcloud_filter/range_image.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace pointcloud_filter
+{
+RangeImage::RangeImage(const PointBuffer& points, int num_columns)
+{
+  build(points, num_columns);
+}
+
+void RangeImage::build(const PointBuffer& points, int num_columns)
+{
+  rings_ = 0;
+  columns_ = std::max(num_columns, 1);
+
+  const size_t num_points = points.size();
+  azimuth_.resize(num_points);
+  range_.resize(num_points);
+  column_.resize(num_points);
+
+  kernels::rangeAzimuth(points.x.data(), points.y.data(), num_points, range_.data(), azimuth_.data());
+  for (size_t i = 0; i < num_points; i++)
+  {
+    column_[i] = columnFromAzimuth(azimuth_[i]);
+    rings_ = std::max(rings_, points.ring[i] + 1);
+  }
+
+  image_.assign(static_cast<size_t>(rings_) * columns_, empty);
+  for (size_t i = 0; i < num_points; i++)
+  {
+    int& cell = image_[points.ring[i] * columns_ + column_[i]];
+    if (cell == empty || range_[i] < range_[cell])
+    {
+      cell = static_cast<int>(i);
+    }
+  }
+}
+
+size_t RangeImage::capacityBytes() const
+{
+  return (azimuth_.capacity() + range_.capacity()) * sizeof(float) +
+         (column_.capacity() + image_.capacity()) * sizeof(int);
+}
+
+int RangeImage::columnFromAzimuth(double azimuth) const
+{
+  const int column = static_cast<int>((azimuth + M_PI) * columns_ / (2 * M_PI));
+  return std::clamp(column, 0, columns_ - 1);
+}
+}  // namespace pointcloud_filter
@@ -1,5 +1,6 @@
+#include <pcl_conversions/pcl_conversions.h>
 #include <pointcloud_filter/raycast_filter/raycast_filter.h>
-#include <unordered_set>
+#include <limits>
 
 namespace pointcloud_filter
 {
@@ -9,7 +10,7 @@ RaycastFilter::RaycastFilter(const ros::NodeHandle& nh) : config_{ nh }
 
 void RaycastFilter::filter(pointcloud_filter::Bundle& bundle)
 {
-  // Precondition: bundle.occupied_pointcloud has lidar frame
+  // The range image is in the lidar frame, so the bins are relative to the lidar
 
   const auto& min_range = config_.min_range;
   const auto& end_distance = config_.end_distance;
@@ -19,39 +20,46 @@ void RaycastFilter::filter(pointcloud_filter::Bundle& bundle)
 
   int discretized_start = discretize(start_angle);
   int discretized_end = discretize(end_angle);
+  const int num_bins = std::max(discretized_end - discretized_start, 0);
 
-  bundle.free_pointcloud->points.reserve(discretized_end - discretized_start + 1);
+  // The bins are accumulated in the scan's own buffer, which keeps its capacity when the bundle is recycled
+  auto& scan = *bundle.free_scan;
+  constexpr float no_range = std::numeric_limits<float>::quiet_NaN();
+  std::vector<float>& occupied_ranges = scan.occupied_ranges;
+  occupied_ranges.assign(num_bins, no_range);
+  const auto add_occupied = [&](double angle, float range) {
+    int bin = discretize(angle) - discretized_start;
+    // NaN compares false, so the first point of a bin is always taken
+    if (bin >= 0 && bin < num_bins && !(occupied_ranges[bin] <= range))
+    {
+      occupied_ranges[bin] = range;
+    }
+  };
 
-  std::unordered_set<int> discretized_angles{};
-  for (auto point : *bundle.occupied_pointcloud)
+  const RangeImage& range_image = bundle.rangeImage();
+  for (int index : bundle.occupied_indices)
   {
-    double angle = atan2(point.y, point.x);
-    discretized_angles.emplace(discretize(angle));
+    add_occupied(range_image.azimuth(index), range_image.range(index));
   }
 
-  // For each angle, if it's not in the set (empty), put it into a pointcloud.
-  // From Robot's frame. Need to rotate angle to world frame
-  for (int i = discretized_start; i < discretized_end; i++)
+  // For each bin without any occupied points, the free space goes from min_range to end_distance.
+  // The bins are in the lidar frame, sensor_pose is filled in once the transform to the robot is known
+  scan.header = pcl_conversions::fromPCL(bundle.raw_pointcloud->header);
+  scan.start_angle = static_cast<float>(discretized_start * angular_resolution);
+  scan.angular_resolution = static_cast<float>(angular_resolution);
+  scan.min_range = static_cast<float>(min_range);
+  scan.sensor_pose.orientation.w = 1.0;
+
+  scan.free_ranges.resize(num_bins);
+  for (int i = 0; i < num_bins; i++)
   {
-    if (discretized_angles.find(i) == discretized_angles.end())
-    {
-      double angle = i * angular_resolution;
-      {
-        auto x = static_cast<float>(min_range * cos(angle));
-        auto y = static_cast<float>(min_range * sin(angle));
-        velodyne_pcl::PointXYZIRT min_range_point{ { { x, y, 0.0, 0.0 } }, 0.0, 0 };
-        bundle.free_pointcloud->points.emplace_back(min_range_point);
-      }
-      {
-        auto x = static_cast<float>(end_distance * cos(angle));
-        auto y = static_cast<float>(end_distance * sin(angle));
-        velodyne_pcl::PointXYZIRT raycasted_point{ { { x, y, 0.0, 0.0 } }, 0.0, 0 };
-        bundle.free_pointcloud->points.emplace_back(raycasted_point);
-      }
-    }
+    scan.free_ranges[i] = std::isnan(occupied_ranges[i]) ? static_cast<float>(end_distance) : no_range;
   }
 
-  bundle.free_pointcloud->header = bundle.occupied_pointcloud->header;
+  if (!config_.include_occupied)
+  {
+    scan.occupied_ranges.clear();
+  }
 }
 
 int RaycastFilter::discretize(double angle) const
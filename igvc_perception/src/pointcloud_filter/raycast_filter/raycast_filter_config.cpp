@@ -12,5 +12,6 @@ RaycastFilterConfig::RaycastFilterConfig(const ros::NodeHandle &nh)
   assertions::getParam(child_nh, "min_range", min_range);
   assertions::getParam(child_nh, "start_angle", start_angle);
   assertions::getParam(child_nh, "end_angle", end_angle);
+  include_occupied = assertions::param(child_nh, "include_occupied", false);
 }
 }  // namespace pointcloud_filter
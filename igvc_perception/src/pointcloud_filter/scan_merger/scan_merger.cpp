@@ -0,0 +1,239 @@
+#include <pcl_conversions/pcl_conversions.h>
+#include <pointcloud_filter/scan_merger/scan_merger.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace pointcloud_filter
+{
+void ScanMerger::SensorScan::setFreeSpace(const igvc_msgs::polar_scan& free_scan,
+                                          const Eigen::Isometry3d& base_from_lidar)
+{
+  const Eigen::Isometry3f transform = base_from_lidar.cast<float>();
+  const Eigen::Vector2f origin = transform.translation().head<2>();
+  min_range = origin.norm() + free_scan.min_range;
+
+  const auto ray_end = [&](float angle, float range) -> Eigen::Vector2f {
+    const Eigen::Vector3f direction = transform.linear() * Eigen::Vector3f{ std::cos(angle), std::sin(angle), 0.0f };
+    return origin + range * direction.head<2>();
+  };
+
+  free_rays.clear();
+  const float half_bin = free_scan.angular_resolution / 2;
+  for (size_t i = 0; i < free_scan.free_ranges.size(); i++)
+  {
+    const float free_range = free_scan.free_ranges[i];
+    if (std::isnan(free_range))
+    {
+      continue;
+    }
+
+    const float angle = free_scan.start_angle + i * free_scan.angular_resolution;
+    free_rays.push_back({ ray_end(angle - half_bin, free_range), ray_end(angle + half_bin, free_range) });
+  }
+}
+
+void ScanMerger::SensorScan::swap(SensorScan& other)
+{
+  std::swap(stamp, other.stamp);
+  occupied.swap(other.occupied);
+  free_rays.swap(other.free_rays);
+  std::swap(min_range, other.min_range);
+}
+
+ScanMerger::ScanMerger(const ros::NodeHandle& nh, const ros::NodeHandle& private_nh,
+                       const PointcloudFilterConfig& config, size_t num_sensors,
+                       igvc::TransformCache* transform_cache)
+  : config_{ private_nh }
+  , base_frame_{ config.base_frame }
+  , transform_cache_{ transform_cache }
+  , pending_(num_sensors)
+  , has_pending_(num_sensors, false)
+{
+  ros::NodeHandle publisher_nh = nh;
+  occupied_pub_ = { publisher_nh, config.topic_occupied, 1 };
+  free_pub_ = { publisher_nh, config.topic_free, 1 };
+}
+
+void ScanMerger::add(size_t sensor, SensorScan& scan)
+{
+  std::lock_guard<std::mutex> lock{ mutex_ };
+
+  // The sensor's previous scan is still waiting for the others, which are slower or have stopped
+  if (has_pending_[sensor])
+  {
+    publishCycle();
+  }
+
+  pending_[sensor].swap(scan);
+  has_pending_[sensor] = true;
+
+  if (std::all_of(has_pending_.begin(), has_pending_.end(), [](bool pending) { return pending; }))
+  {
+    publishCycle();
+  }
+}
+
+void ScanMerger::publishCycle()
+{
+  ros::Time stamp;
+  for (size_t sensor = 0; sensor < pending_.size(); sensor++)
+  {
+    if (has_pending_[sensor])
+    {
+      stamp = std::max(stamp, pending_[sensor].stamp);
+    }
+  }
+
+  // Scans of the cycle that are recent enough, with the motion of the robot since each of them
+  std::vector<std::pair<const SensorScan*, Eigen::Isometry3f>> scans;
+  for (size_t sensor = 0; sensor < pending_.size(); sensor++)
+  {
+    if (!has_pending_[sensor])
+    {
+      continue;
+    }
+    has_pending_[sensor] = false;
+
+    const SensorScan& scan = pending_[sensor];
+    if ((stamp - scan.stamp).toSec() > config_.max_offset)
+    {
+      stale_scans_++;
+      continue;
+    }
+    scans.emplace_back(&scan, motionBetween(scan.stamp, stamp));
+  }
+  cycles_++;
+  merged_scans_ += scans.size();
+
+  // Subscribers in the same nodelet manager keep a reference to the published messages, so each cycle gets new ones
+  occupied_pub_.publish([&] {
+    PointCloud::Ptr occupied{ new PointCloud };
+    occupied->header.frame_id = base_frame_;
+    occupied->header.stamp = pcl_conversions::toPCL(stamp);
+    for (const auto& [scan, motion] : scans)
+    {
+      for (const velodyne_pcl::PointXYZIRT& point : scan->occupied)
+      {
+        velodyne_pcl::PointXYZIRT& moved = occupied->points.emplace_back(point);
+        moved.getVector3fMap() = motion * point.getVector3fMap();
+      }
+    }
+    occupied->width = occupied->points.size();
+    occupied->height = 1;
+    return occupied;
+  });
+
+  free_pub_.publish([&] {
+    igvc_msgs::polar_scanPtr free_scan{ new igvc_msgs::polar_scan };
+    free_scan->header.frame_id = base_frame_;
+    free_scan->header.stamp = stamp;
+    free_scan->sensor_pose.orientation.w = 1.0;
+    free_scan->start_angle = static_cast<float>(-M_PI);
+    free_scan->angular_resolution = static_cast<float>(config_.angular_resolution);
+    free_scan->free_ranges.assign(numBins(), std::numeric_limits<float>::quiet_NaN());
+
+    for (const auto& [scan, motion] : scans)
+    {
+      addFreeSpace(*scan, motion, *free_scan);
+      free_scan->min_range = std::max(free_scan->min_range, scan->min_range);
+    }
+
+    // As in RaycastFilter, a bin with an occupied point isn't free
+    for (const auto& [scan, motion] : scans)
+    {
+      for (const velodyne_pcl::PointXYZIRT& point : scan->occupied)
+      {
+        const Eigen::Vector3f moved = motion * point.getVector3fMap();
+        free_scan->free_ranges[discretize(std::atan2(moved.y(), moved.x()))] = std::numeric_limits<float>::quiet_NaN();
+      }
+    }
+    return free_scan;
+  });
+}
+
+Eigen::Isometry3f ScanMerger::motionBetween(const ros::Time& from, const ros::Time& to) const
+{
+  if (from == to)
+  {
+    return Eigen::Isometry3f::Identity();
+  }
+
+  const std::optional<Eigen::Isometry3d> pose_from = transform_cache_->interpolatePose(from);
+  const std::optional<Eigen::Isometry3d> pose_to = transform_cache_->interpolatePose(to);
+  if (!pose_from || !pose_to)
+  {
+    return Eigen::Isometry3f::Identity();
+  }
+  return (pose_to->inverse() * *pose_from).cast<float>();
+}
+
+void ScanMerger::addFreeSpace(const SensorScan& scan, const Eigen::Isometry3f& motion,
+                              igvc_msgs::polar_scan& merged) const
+{
+  const Eigen::Matrix2f rotation = motion.linear().topLeftCorner<2, 2>();
+  const Eigen::Vector2f translation = motion.translation().head<2>();
+  const int num_bins = static_cast<int>(merged.free_ranges.size());
+
+  for (const FreeRay& ray : scan.free_rays)
+  {
+    const Eigen::Vector2f first_end = rotation * ray.first_end + translation;
+    const Eigen::Vector2f second_end = rotation * ray.second_end + translation;
+    const float range = std::min(first_end.norm(), second_end.norm());
+
+    int first_bin = discretize(std::atan2(first_end.y(), first_end.x()));
+    int last_bin = discretize(std::atan2(second_end.y(), second_end.x()));
+    if (first_bin > last_bin)
+    {
+      std::swap(first_bin, last_bin);
+    }
+    // A ray is narrower than half a turn, so a wider span means that it crosses the start of the scan
+    if (last_bin - first_bin > num_bins / 2)
+    {
+      std::swap(first_bin, last_bin);
+      last_bin += num_bins;
+    }
+
+    for (int bin = first_bin; bin <= last_bin; bin++)
+    {
+      float& free_range = merged.free_ranges[bin % num_bins];
+      free_range = std::isnan(free_range) ? range : std::min(free_range, range);
+    }
+  }
+}
+
+int ScanMerger::numBins() const
+{
+  return static_cast<int>(std::ceil(2 * M_PI / config_.angular_resolution));
+}
+
+int ScanMerger::discretize(float angle) const
+{
+  const int bin = static_cast<int>((angle + M_PI) / config_.angular_resolution);
+  return std::clamp(bin, 0, numBins() - 1);
+}
+
+void ScanMerger::diagnostic(diagnostic_updater::DiagnosticStatusWrapper& stat)
+{
+  std::lock_guard<std::mutex> lock{ mutex_ };
+  const double mean_scans = cycles_ == 0 ? 0.0 : static_cast<double>(merged_scans_) / cycles_;
+  stat.add("Lidars", pending_.size());
+  stat.add("Cycles", cycles_);
+  stat.addf("Mean scans per cycle", "%.2f", mean_scans);
+  stat.add("Stale scans dropped", stale_scans_);
+
+  if (stale_scans_ > 0)
+  {
+    stat.summaryf(diagnostic_msgs::DiagnosticStatus::WARN, "Dropped %zu stale scans", stale_scans_);
+  }
+  else
+  {
+    stat.summaryf(diagnostic_msgs::DiagnosticStatus::OK, "Merging %zu lidars", pending_.size());
+  }
+
+  cycles_ = 0;
+  merged_scans_ = 0;
+  stale_scans_ = 0;
+}
+}  // namespace pointcloud_filter
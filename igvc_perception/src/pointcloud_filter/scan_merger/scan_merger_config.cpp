@@ -0,0 +1,13 @@
+#include <parameter_assertions/assertions.h>
+#include <pointcloud_filter/scan_merger/scan_merger_config.h>
+
+namespace pointcloud_filter
+{
+ScanMergerConfig::ScanMergerConfig(const ros::NodeHandle &nh)
+{
+  ros::NodeHandle child_nh{ nh, "merge" };
+
+  max_offset = assertions::param(child_nh, "max_offset", 0.1);
+  angular_resolution = assertions::param(child_nh, "angular_resolution", 0.01);
+}
+}  // namespace pointcloud_filter
@@ -0,0 +1,311 @@
+#include <pcl_conversions/pcl_conversions.h>
+#include <pointcloud_filter/sensor_pipeline/sensor_pipeline.h>
+#include <tf2_eigen/tf2_eigen.h>
+
+namespace pointcloud_filter
+{
+SensorPipeline::SensorPipeline(const ros::NodeHandle& nh, const ros::NodeHandle& sensor_nh,
+                               const PointcloudFilterConfig& config, igvc::TransformCache* transform_cache,
+                               ScanMerger* merger, size_t sensor_index)
+  : nh_{ nh }
+  , sensor_nh_{ sensor_nh }
+  , config_{ sensor_nh_ }
+  , shared_config_{ config }
+  , predicate_filter_{ RadiusFilter{ sensor_nh_ }, BackFilter{ sensor_nh_ } }
+  , voxel_filter_{ sensor_nh_ }
+  , tf_transform_filter_{ transform_cache }
+  , ground_filter_{ sensor_nh_ }
+  , raycast_filter_{ sensor_nh_ }
+  , fast_segment_filter_{ sensor_nh_ }
+  , range_ground_filter_{ sensor_nh_ }
+  , load_shedder_{ sensor_nh_ }
+  , merger_{ merger }
+  , sensor_index_{ sensor_index }
+  , bundle_pool_{ config_.range_image_columns }
+{
+  setupPipeline();
+  setupPubSub();
+}
+
+SensorPipeline::~SensorPipeline()
+{
+  if (spinner_)
+  {
+    spinner_->stop();
+  }
+  raw_pointcloud_sub_.shutdown();
+
+  if (segment_queue_)
+  {
+    // The segment thread closes publish_queue_ once it runs out of bundles, so both threads drain and exit in order
+    segment_queue_->close();
+    segment_thread_.join();
+    publish_thread_.join();
+  }
+}
+
+void SensorPipeline::setupPubSub()
+{
+  ros::NodeHandle subscriber_nh = nh_;
+  if (merger_)
+  {
+    subscriber_nh.setCallbackQueue(&callback_queue_);
+    spinner_ = std::make_unique<ros::AsyncSpinner>(1, &callback_queue_);
+    spinner_->start();
+  }
+  raw_pointcloud_sub_ = subscriber_nh.subscribe(config_.topic_input, 1, &SensorPipeline::pointcloudCallback, this);
+
+  transformed_pointcloud_pub_ = { nh_, config_.topic_transformed, 1 };
+  if (!merger_)
+  {
+    occupied_pointcloud_pub_ = { nh_, shared_config_.topic_occupied, 1 };
+    free_scan_pub_ = { nh_, shared_config_.topic_free, 1 };
+  }
+
+  filtered_pointcloud_pub_ = { nh_, config_.topic_filtered, 1 };
+}
+
+void SensorPipeline::setupPipeline()
+{
+  if (!config_.pipeline_enabled)
+  {
+    return;
+  }
+
+  const size_t queue_size = static_cast<size_t>(std::max(config_.pipeline_queue_size, 1));
+  segment_queue_ = std::make_unique<BundleQueue>(queue_size);
+  publish_queue_ = std::make_unique<BundleQueue>(queue_size);
+  segment_thread_ = std::thread{ &SensorPipeline::segmentLoop, this };
+  publish_thread_ = std::thread{ &SensorPipeline::publishLoop, this };
+}
+
+void SensorPipeline::pointcloudCallback(const PointCloud::ConstPtr& raw_pointcloud)
+{
+  BundlePool::Lease bundle = filterStage(raw_pointcloud);
+
+  if (segment_queue_)
+  {
+    if (!segment_queue_->tryPush(std::move(bundle)))
+    {
+      recordDroppedFrame();
+    }
+    return;
+  }
+
+  segmentStage(*bundle);
+  publishStage(*bundle);
+}
+
+BundlePool::Lease SensorPipeline::filterStage(const PointCloud::ConstPtr& raw_pointcloud)
+{
+  const auto start = std::chrono::steady_clock::now();
+  BundlePool::Lease bundle = bundle_pool_.lease(raw_pointcloud);
+  // The level is picked once per scan, so that every stage processes the scan the same way
+  bundle->degradation_level = load_shedder_.level();
+
+  predicate_filter_.filter(*bundle);
+  if (bundle->degradation_level >= LoadShedder::subsampled_columns)
+  {
+    load_shedder_.subsample(*bundle);
+  }
+  voxel_filter_.filter(*bundle);
+
+  if (bundle->degradation_level < LoadShedder::no_debug_output)
+  {
+    filtered_pointcloud_pub_.publish([&] { return bundle->materialize(bundle->indices); });
+  }
+
+  recordLatency(filter_stage, start, *bundle);
+  return bundle;
+}
+
+void SensorPipeline::segmentStage(Bundle& bundle)
+{
+  const auto start = std::chrono::steady_clock::now();
+
+  if (config_.ground_segmentation && config_.ground_method == SensorPipelineConfig::GroundMethod::range_image)
+  {
+    // Cheap enough that it isn't degraded under load, apart from the debug output
+    range_ground_filter_.setDebugOutput(bundle.degradation_level < LoadShedder::no_debug_output);
+    range_ground_filter_.filter(bundle);
+  }
+  else if (config_.ground_segmentation)
+  {
+    const bool coarse = bundle.degradation_level >= LoadShedder::coarse_segments;
+    fast_segment_filter_.setSegmentDivisor(coarse ? load_shedder_.config().segment_divisor : 1);
+    fast_segment_filter_.setDebugOutput(bundle.degradation_level < LoadShedder::no_debug_output);
+    fast_segment_filter_.filter(bundle);
+  }
+  else
+  {
+    // A planar lidar doesn't see the ground, so everything it sees is an obstacle
+    bundle.occupied_indices = bundle.indices;
+  }
+
+  recordLatency(segment_stage, start, bundle);
+}
+
+void SensorPipeline::publishStage(Bundle& bundle)
+{
+  const auto start = std::chrono::steady_clock::now();
+
+  const std::string& base_frame = shared_config_.base_frame;
+  ros::Duration timeout{ shared_config_.timeout_duration };
+
+  // Every cloud is a selection of the raw scan, so they all share the one lidar -> base_frame lookup
+  const std::optional<Eigen::Isometry3d> base_from_lidar = tf_transform_filter_.lookup(bundle, base_frame, timeout);
+  if (!base_from_lidar)
+  {
+    recordFrame(bundle);
+    return;
+  }
+
+  transformed_pointcloud_pub_.publish([&] {
+    PointCloud::Ptr transformed_pointcloud{ new PointCloud };
+    tf_transform_filter_.transform(bundle, bundle.indices, *transformed_pointcloud, base_frame, timeout);
+    return transformed_pointcloud;
+  });
+
+  if (merger_)
+  {
+    addToMerger(bundle, *base_from_lidar);
+  }
+  else
+  {
+    occupied_pointcloud_pub_.publish([&] { return bundle.materialize(bundle.occupied_indices); });
+    free_scan_pub_.publish([&] {
+      raycast_filter_.filter(bundle);
+      // Express the free space relative to the robot, so that consumers only need to look up the robot's pose
+      bundle.free_scan->header.frame_id = base_frame;
+      bundle.free_scan->sensor_pose = tf2::toMsg(*base_from_lidar);
+      return bundle.free_scan;
+    });
+  }
+
+  recordLatency(publish_stage, start, bundle);
+  recordFrame(bundle);
+}
+
+void SensorPipeline::addToMerger(Bundle& bundle, const Eigen::Isometry3d& base_from_lidar)
+{
+  ros::Duration timeout{ shared_config_.timeout_duration };
+
+  merger_scan_.stamp = pcl_conversions::fromPCL(bundle.raw_pointcloud->header.stamp);
+  tf_transform_filter_.transform(bundle, bundle.occupied_indices, merger_scan_.occupied, shared_config_.base_frame,
+                                 timeout);
+  raycast_filter_.filter(bundle);
+  merger_scan_.setFreeSpace(*bundle.free_scan, base_from_lidar);
+
+  merger_->add(sensor_index_, merger_scan_);
+}
+
+void SensorPipeline::segmentLoop()
+{
+  BundlePool::Lease bundle;
+  while (segment_queue_->pop(bundle))
+  {
+    segmentStage(*bundle);
+    if (!publish_queue_->tryPush(std::move(bundle)))
+    {
+      recordDroppedFrame();
+    }
+  }
+  publish_queue_->close();
+}
+
+void SensorPipeline::publishLoop()
+{
+  BundlePool::Lease bundle;
+  while (publish_queue_->pop(bundle))
+  {
+    publishStage(*bundle);
+  }
+}
+
+void SensorPipeline::recordLatency(Stage stage, std::chrono::steady_clock::time_point start, Bundle& bundle)
+{
+  const double elapsed_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  bundle.total_stage_ms += elapsed_ms;
+  bundle.max_stage_ms = std::max(bundle.max_stage_ms, elapsed_ms);
+
+  std::lock_guard<std::mutex> lock{ stats_mutex_ };
+  StageLatency& latency = stage_latency_[stage];
+  latency.frames++;
+  latency.total_ms += elapsed_ms;
+  latency.max_ms = std::max(latency.max_ms, elapsed_ms);
+}
+
+void SensorPipeline::recordFrame(const Bundle& bundle)
+{
+  // When pipelined the stages overlap, so the pipeline keeps up as long as its slowest stage does
+  load_shedder_.recordFrame(config_.pipeline_enabled ? bundle.max_stage_ms : bundle.total_stage_ms);
+
+  std::lock_guard<std::mutex> lock{ stats_mutex_ };
+  level_frames_[bundle.degradation_level]++;
+}
+
+void SensorPipeline::recordDroppedFrame()
+{
+  std::lock_guard<std::mutex> lock{ stats_mutex_ };
+  dropped_frames_++;
+}
+
+void SensorPipeline::diagnostic(diagnostic_updater::DiagnosticStatusWrapper& stat)
+{
+  static constexpr std::array<const char*, num_stages> stage_names{ "Filter", "Segment", "Publish" };
+
+  std::lock_guard<std::mutex> lock{ stats_mutex_ };
+  for (int stage = 0; stage < num_stages; stage++)
+  {
+    const StageLatency& latency = stage_latency_[stage];
+    const double mean_ms = latency.frames == 0 ? 0.0 : latency.total_ms / latency.frames;
+    stat.addf(std::string(stage_names[stage]) + " frames", "%zu", latency.frames);
+    stat.addf(std::string(stage_names[stage]) + " mean latency (ms)", "%.2f", mean_ms);
+    stat.addf(std::string(stage_names[stage]) + " max latency (ms)", "%.2f", latency.max_ms);
+  }
+  if (config_.ground_segmentation && config_.ground_method == SensorPipelineConfig::GroundMethod::fast_segment)
+  {
+    // So that runs with different fast_segment_filter/num_threads can be told apart when comparing latencies
+    stat.add("Segment threads", fast_segment_filter_.numThreads());
+  }
+
+  if (segment_queue_)
+  {
+    stat.add("Segment queue depth", segment_queue_->size());
+    stat.add("Publish queue depth", publish_queue_->size());
+  }
+  stat.add("Dropped frames", dropped_frames_);
+
+  const BundlePool::Counters pool_counters = bundle_pool_.counters();
+  stat.add("Bundles leased", pool_counters.leases);
+  stat.add("Bundles allocated", pool_counters.bundle_allocations);
+  stat.add("Bundle buffer growths", pool_counters.buffer_growths);
+
+  const LoadShedder::Level level = load_shedder_.level();
+  stat.add("Degradation level", LoadShedder::levelName(level));
+  stat.addf("Average frame time (ms)", "%.2f", load_shedder_.averageMs());
+  stat.addf("Frame budget (ms)", "%.2f", load_shedder_.config().budget_ms);
+  for (int frame_level = 0; frame_level < LoadShedder::num_levels; frame_level++)
+  {
+    stat.add(std::string("Frames at ") + LoadShedder::levelName(static_cast<LoadShedder::Level>(frame_level)),
+             level_frames_[frame_level]);
+  }
+
+  if (dropped_frames_ > 0)
+  {
+    stat.summaryf(diagnostic_msgs::DiagnosticStatus::WARN, "Dropped %zu frames", dropped_frames_);
+  }
+  else if (level != LoadShedder::full_quality)
+  {
+    stat.summaryf(diagnostic_msgs::DiagnosticStatus::WARN, "Shedding load: %s", LoadShedder::levelName(level));
+  }
+  else
+  {
+    stat.summary(diagnostic_msgs::DiagnosticStatus::OK, config_.pipeline_enabled ? "Pipelined" : "Sequential");
+  }
+
+  stage_latency_ = {};
+  level_frames_ = {};
+  dropped_frames_ = 0;
+}
+}  // namespace pointcloud_filter
@@ -0,0 +1,22 @@
+#include <parameter_assertions/assertions.h>
+#include <pointcloud_filter/sensor_pipeline/sensor_pipeline_config.h>
+
+namespace pointcloud_filter
+{
+SensorPipelineConfig::SensorPipelineConfig(const ros::NodeHandle &nh)
+{
+  assertions::getParam(nh, "topic/input", topic_input);
+  assertions::getParam(nh, "topic/transformed", topic_transformed);
+  assertions::getParam(nh, "topic/filtered", topic_filtered);
+
+  range_image_columns = assertions::param(nh, "range_image/columns", 1800);
+
+  pipeline_enabled = assertions::param(nh, "pipeline/enabled", false);
+  pipeline_queue_size = assertions::param(nh, "pipeline/queue_size", 2);
+
+  ground_segmentation = assertions::param(nh, "ground_segmentation", true);
+  ground_method = assertions::param(nh, "ground_method", std::string{ "fast_segment" }) == "range_image" ?
+                      GroundMethod::range_image :
+                      GroundMethod::fast_segment;
+}
+}  // namespace pointcloud_filter
@@ -1,59 +1,62 @@
 #include <pcl_conversions/pcl_conversions.h>
+#include <pointcloud_filter/point_kernels.h>
 #include <pointcloud_filter/tf_transform_filter/tf_transform_filter.h>
 #include <tf2_eigen/tf2_eigen.h>
 
 namespace pointcloud_filter
 {
-TFTransformFilter::TFTransformFilter(tf2_ros::Buffer* buffer) : buffer_{ buffer }
+TFTransformFilter::TFTransformFilter(igvc::TransformCache* transform_cache) : transform_cache_{ transform_cache }
 {
 }
 
-void TFTransformFilter::transform(const PointCloud& from, PointCloud& to, const std::string& target_frame,
-                                  const ros::Duration& timeout)
+std::optional<Eigen::Isometry3d> TFTransformFilter::lookup(Bundle& bundle, const std::string& target_frame,
+                                                           const ros::Duration& timeout)
 {
-  if (&from != &to)
+  const auto& header = bundle.raw_pointcloud->header;
+  if (target_frame == header.frame_id)
   {
-    to.clear();
-    to.reserve(from.size());
+    return Eigen::Isometry3d::Identity();
   }
 
-  const auto& source_frame = from.header.frame_id;
-  ros::Time message_time = pcl_conversions::fromPCL(from.header.stamp);
-
-  geometry_msgs::TransformStamped transform_msg;
-  if (buffer_->canTransform(target_frame, source_frame, message_time, timeout))
+  for (const auto& [frame, transform] : bundle.transforms)
   {
-    transform_msg = buffer_->lookupTransform(target_frame, source_frame, message_time, timeout);
+    if (frame == target_frame)
+    {
+      return transform;
+    }
   }
-  else
+
+  ros::Time message_time = pcl_conversions::fromPCL(header.stamp);
+  std::optional<geometry_msgs::TransformStamped> transform_msg =
+      transform_cache_->lookupTransform(target_frame, header.frame_id, message_time, timeout);
+  if (!transform_msg)
   {
-    transform_msg = buffer_->lookupTransform(target_frame, source_frame, ros::Time(0), timeout);
+    return std::nullopt;
   }
-  Eigen::Isometry3f transform = tf2::transformToEigen(transform_msg).cast<float>();
+  Eigen::Isometry3d transform = tf2::transformToEigen(*transform_msg);
+  bundle.transforms.emplace_back(target_frame, transform);
+  return transform;
+}
 
-  for (size_t i = 0; i < from.size(); i++)
+bool TFTransformFilter::transform(Bundle& bundle, const std::vector<int>& indices, PointCloud& to,
+                                  const std::string& target_frame, const ros::Duration& timeout)
+{
+  std::optional<Eigen::Isometry3d> transform = lookup(bundle, target_frame, timeout);
+  if (!transform)
   {
-    auto& point = from.points[i];
-    Eigen::Vector3f eigen_point{ point.x, point.y, point.z };
-    eigen_point = transform * eigen_point;
+    return false;
+  }
 
-    if (&from == &to)
-    {
-      auto& to_point = to.points[i];
-      to_point.x = eigen_point(0);
-      to_point.y = eigen_point(1);
-      to_point.z = eigen_point(2);
-    }
-    else
-    {
-      velodyne_pcl::PointXYZIRT new_point{ point };
-      new_point.x = eigen_point(0);
-      new_point.y = eigen_point(1);
-      new_point.z = eigen_point(2);
-      to.points.emplace_back(new_point);
-    }
+  bundle.points.select(indices, selected_);
+  if (!transform->matrix().isIdentity())
+  {
+    kernels::transform(transform->cast<float>(), selected_);
   }
+  selected_.toPointCloud(to);
 
+  to.header = bundle.raw_pointcloud->header;
   to.header.frame_id = target_frame;
+  to.is_dense = bundle.raw_pointcloud->is_dense;
+  return true;
 }
 }  // namespace pointcloud_filter
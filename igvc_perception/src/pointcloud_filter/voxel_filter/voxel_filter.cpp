@@ -0,0 +1,127 @@
+#include <pointcloud_filter/voxel_filter/voxel_filter.h>
+
+#include <cmath>
+
+namespace pointcloud_filter
+{
+VoxelFilter::VoxelFilter(const ros::NodeHandle& nh) : config_{ nh }
+{
+  for (double voxel_size : config_.voxel_sizes)
+  {
+    inverse_voxel_sizes_.emplace_back(voxel_size > 0.0 ? static_cast<float>(1.0 / voxel_size) : 0.0f);
+  }
+}
+
+void VoxelFilter::filter(Bundle& bundle)
+{
+  if (!config_.enabled)
+  {
+    return;
+  }
+
+  const RangeImage& range_image = bundle.rangeImage();
+  const PointBuffer& points = bundle.points;
+  std::vector<int>& indices = bundle.indices;
+  prepareTable(indices.size());
+  keep_.assign(indices.size(), 0);
+
+  // Each voxel's point is marked first, and the indices are compacted afterwards so that they stay in order
+  for (size_t position = 0; position < indices.size(); position++)
+  {
+    const int index = indices[position];
+    const float range = range_image.range(index);
+    const size_t point_band = band(range);
+    const float inverse_size = inverse_voxel_sizes_[point_band];
+    if (inverse_size == 0.0f)
+    {
+      keep_[position] = 1;
+      continue;
+    }
+
+    const uint16_t ring = config_.per_ring ? points.ring[index] : 0;
+    const uint64_t key = voxelKey(point_band, ring, points.x[index] * inverse_size, points.y[index] * inverse_size,
+                                  points.z[index] * inverse_size);
+    const float score = config_.keep == VoxelFilterConfig::Keep::lowest ? points.z[index] : range;
+
+    const size_t mask = slots_.size() - 1;
+    for (size_t slot_index = (key * 0x9E3779B97F4A7C15ull) >> shift_;; slot_index = (slot_index + 1) & mask)
+    {
+      Slot& slot = slots_[slot_index];
+      if (slot.generation != generation_)
+      {
+        slot = { key, generation_, static_cast<uint32_t>(position), score };
+        keep_[position] = 1;
+        break;
+      }
+      if (slot.key == key)
+      {
+        if (score < slot.score)
+        {
+          keep_[slot.kept] = 0;
+          keep_[position] = 1;
+          slot.kept = static_cast<uint32_t>(position);
+          slot.score = score;
+        }
+        break;
+      }
+    }
+  }
+
+  size_t num_kept = 0;
+  for (size_t position = 0; position < indices.size(); position++)
+  {
+    if (keep_[position])
+    {
+      indices[num_kept++] = indices[position];
+    }
+  }
+  indices.resize(num_kept);
+}
+
+void VoxelFilter::prepareTable(size_t num_points)
+{
+  // At most half full, so that probe sequences stay short
+  size_t capacity = 16;
+  int bits = 4;
+  while (capacity < 2 * num_points)
+  {
+    capacity *= 2;
+    bits++;
+  }
+
+  if (capacity > slots_.size())
+  {
+    slots_.assign(capacity, Slot{});
+    shift_ = 64 - bits;
+    generation_ = 0;
+  }
+
+  generation_++;
+  if (generation_ == 0)
+  {
+    // Wrapped around, so stale slots could look current
+    slots_.assign(slots_.size(), Slot{});
+    generation_ = 1;
+  }
+}
+
+size_t VoxelFilter::band(float range) const
+{
+  size_t band = 0;
+  while (band < config_.band_ranges.size() && range >= config_.band_ranges[band])
+  {
+    band++;
+  }
+  return band;
+}
+
+uint64_t VoxelFilter::voxelKey(size_t band, uint16_t ring, float x, float y, float z)
+{
+  // 16 bits per coordinate wrap around every 65536 voxels, which is far beyond the range of the lidar
+  const auto cell = [](float coordinate) {
+    return static_cast<uint64_t>(static_cast<int64_t>(std::floor(coordinate))) & 0xffff;
+  };
+  return (static_cast<uint64_t>(band & 0xff) << 56) | (static_cast<uint64_t>(ring & 0xff) << 48) |
+         (cell(x) << 32) | (cell(y) << 16) | cell(z);
+}
+}  // namespace pointcloud_filter
@@ -0,0 +1,23 @@
+#include <parameter_assertions/assertions.h>
+#include <pointcloud_filter/voxel_filter/voxel_filter_config.h>
+
+namespace pointcloud_filter
+{
+VoxelFilterConfig::VoxelFilterConfig(const ros::NodeHandle &nh)
+{
+  ros::NodeHandle child_nh{ nh, "voxel_filter" };
+
+  enabled = assertions::param(child_nh, "enabled", false);
+  band_ranges = assertions::param(child_nh, "band_ranges", std::vector<double>{});
+  voxel_sizes = assertions::param(child_nh, "voxel_sizes", std::vector<double>{ 0.0 });
+  keep = assertions::param(child_nh, "keep", std::string{ "lowest" }) == "nearest" ? Keep::nearest : Keep::lowest;
+  per_ring = assertions::param(child_nh, "per_ring", true);
+
+  if (enabled && voxel_sizes.size() != band_ranges.size() + 1)
+  {
+    ROS_ERROR_STREAM("voxel_filter/voxel_sizes needs one more entry than voxel_filter/band_ranges, got "
+                     << voxel_sizes.size() << " and " << band_ranges.size() << ". Disabling the voxel filter.");
+    enabled = false;
+  }
+}
+}  // namespace pointcloud_filter
@@ -5,114 +5,137 @@
 #include <pcl/point_cloud.h>
 #include <pcl/point_types.h>
 #include <pcl_ros/point_cloud.h>
+#include <pcl_conversions/pcl_conversions.h>
 
-ClusteringNode::ClusteringNode()
+namespace pointcloud_segmentation
 {
-  private_nh_ = ros::NodeHandle("~");
+ClusteringNode::ClusteringNode(const ros::NodeHandle& private_nh)
+  : private_nh_{ private_nh }
+  , reconfigure_server_{ private_nh_ }
+  , listener_{ buffer_ }
+  , transform_cache_{ &buffer_, private_nh_ }
+  , tracker_{ private_nh_, &transform_cache_ }
+{
+  // Called once right away with the initial values from the parameter server
+  reconfigure_server_.setCallback(boost::bind(&ClusteringNode::reconfigureCallback, this, _1, _2));
+
   ground_filter_sub_ =
       private_nh_.subscribe("/ground_filter_node/ground_segmentation", 1, &ClusteringNode::clusteringCallback, this);
-  clustering_pub_ = private_nh_.advertise<sensor_msgs::PointCloud2>("clustering_segmentation", 1);
-  marker_pub_ = private_nh_.advertise<visualization_msgs::MarkerArray>("/markers", 1);
+  clustering_pub_ = { private_nh_, "clustering_segmentation", 1 };
+  marker_pub_ = { private_nh_, "/markers", 1 };
 };
 
-void ClusteringNode::clusteringCallback(const sensor_msgs::PointCloud2ConstPtr& cloud_msg)
+void ClusteringNode::reconfigureCallback(igvc_perception::ClusteringConfig& config, uint32_t /*level*/)
 {
-  PC::Ptr cloud(new PC);
-  PCRGB::Ptr cloud_filtered(new PCRGB);
-  PCRGB::Ptr curr_cloud(new PCRGB);
-  std::string option, frame_id;
-  int cluster_min, cluster_max, kSearch, numberOfNeighbours, meanK;
-  float tolerance, smoothnessThreshold, curvatureThreshold, stdDevMulThresh;
+  std::lock_guard<std::mutex> lock{ config_mutex_ };
+  config_ = config;
+}
 
-  private_nh_.getParam("/clustering_node/option", option);
-  private_nh_.getParam("/clustering_node/frame_id", frame_id);
-  private_nh_.getParam("/clustering_node/outlier_filter/meanK", meanK);
-  private_nh_.getParam("/clustering_node/soutlier_filter/stdDevMulThresh", stdDevMulThresh);
-
-  if (option == "euclidean")
+void ClusteringNode::clusteringCallback(const PC::ConstPtr& cloud_msg)
+{
+  const bool publish_clusters = clustering_pub_.hasSubscribers();
+  if (!publish_clusters && !marker_pub_.hasSubscribers())
   {
-    private_nh_.getParam("/clustering_node/euclidean/tolerance", tolerance);
-    private_nh_.getParam("/clustering_node/euclidean/min", cluster_min);
-    private_nh_.getParam("/clustering_node/euclidean/max", cluster_max);
+    return;
   }
 
-  else if (option == "region_growing")
+  igvc_perception::ClusteringConfig config;
   {
-    private_nh_.getParam("/clustering_node/region_growing/kSearch", kSearch);
-    private_nh_.getParam("/clustering_node/region_growing/min", cluster_min);
-    private_nh_.getParam("/clustering_node/region_growing/max", cluster_max);
-    private_nh_.getParam("/clustering_node/region_growing/numberOfNeighbours", numberOfNeighbours);
-    private_nh_.getParam("/clustering_node/region_growing/smoothnessThreshold", smoothnessThreshold);
-    private_nh_.getParam("/clustering_node/region_growing/curvatureThreshold", curvatureThreshold);
+    std::lock_guard<std::mutex> lock{ config_mutex_ };
+    config = config_;
   }
+  const std::string& frame_id = config.frame_id;
 
-  pcl::fromROSMsg(*cloud_msg, *cloud);
+  PCRGB::Ptr cloud_filtered(new PCRGB);
 
-  if (cloud->size() == 0)
+  if (cloud_msg->size() == 0)
   {
-    sensor_msgs::PointCloud2 output_msg = utils::format_output_msg(cloud_filtered, frame_id);
-    visualization_msgs::MarkerArray clusters_vis;
-    clustering_pub_.publish(output_msg);
-    marker_pub_.publish(clusters_vis);
+    clustering_pub_.publish([&] { return utils::format_output_msg(cloud_filtered, frame_id); });
+    marker_pub_.publish([] { return visualization_msgs::MarkerArray{}; });
   }
 
   else
   {
     visualization_msgs::MarkerArray clusters_vis;
-    int counter = 0;
-    utils::remove_outlier(cloud, meanK, stdDevMulThresh);
     std::vector<pcl::PointIndices> cluster_indices;
 
-    if (option == "euclidean")
+    // The grid leaves out small clusters instead of outliers, so it can cluster the received cloud without a copy
+    PC::ConstPtr cloud = cloud_msg;
+    if (config.option == "grid")
     {
-      cluster_indices = utils::euclidean_clustering(cloud, tolerance, cluster_max, cluster_min);
+      GridClustering::Params params;
+      params.cell_size = config.grid_cell_size;
+      params.tolerance_cells = config.grid_tolerance_cells;
+      params.height_cell_size = config.grid_height_cell_size;
+      params.min_size = config.grid_min;
+      params.max_size = config.grid_max;
+      cluster_indices = grid_clustering_.extract(*cloud, params);
     }
-    else if (option == "region_growing")
+    else
     {
-      cluster_indices = utils::region_growing_clustering(cloud, kSearch, cluster_min, cluster_max, numberOfNeighbours,
-                                                         smoothnessThreshold, curvatureThreshold);
-    }
+      // remove_outlier filters in place, and the received cloud is shared with the other subscribers
+      PC::Ptr filtered_cloud(new PC(*cloud_msg));
+      utils::remove_outlier(filtered_cloud, config.outlier_mean_k, config.outlier_std_dev_mul_thresh);
+      cloud = filtered_cloud;
 
-    for (std::vector<pcl::PointIndices>::const_iterator it = cluster_indices.begin(); it != cluster_indices.end(); ++it)
-    {
-      // create a pcl object to hold the extracted cluster
-      unsigned int r = (unsigned int)(rand() % 255);
-      unsigned int g = (unsigned int)(rand() % 255);
-      unsigned int b = (unsigned int)(rand() % 255);
-      for (std::vector<int>::const_iterator pit = it->indices.begin(); pit != it->indices.end(); ++pit)
+      if (config.option == "euclidean")
+      {
+        cluster_indices = utils::euclidean_clustering(filtered_cloud, config.euclidean_tolerance, config.euclidean_max,
+                                                      config.euclidean_min);
+      }
+      else if (config.option == "region_growing")
       {
-        pcl::PointXYZRGB p;
-        p.x = cloud->points[*pit].x;
-        p.y = cloud->points[*pit].y;
-        p.z = cloud->points[*pit].z;
-        p.r = r;
-        p.g = g;
-        p.b = b;
-        curr_cloud->points.push_back(p);
+        cluster_indices = utils::region_growing_clustering(
+            filtered_cloud, config.region_growing_k_search, config.region_growing_min, config.region_growing_max,
+            config.region_growing_number_of_neighbours, config.region_growing_smoothness_threshold,
+            config.region_growing_curvature_threshold);
       }
+    }
+
+    std::vector<cloud_info> clusters_info;
+    std::vector<pointcloud_filter::ClusterTracker::Observation> observations;
+    for (const pcl::PointIndices& cluster : cluster_indices)
+    {
       // obtain min, max, and centroid
-      cloud_info curr_cloud_info = utils::get_cloud_info(curr_cloud);
+      const cloud_info& curr_cloud_info = clusters_info.emplace_back(utils::get_cloud_info(*cloud, cluster));
+      observations.push_back({ curr_cloud_info.centroid.head<3>(), cluster.indices.size() });
+    }
+    const std::vector<size_t>& tracks =
+        tracker_.update(cloud->header.frame_id, pcl_conversions::fromPCL(cloud->header.stamp), observations);
 
-      if (utils::check_threshold(curr_cloud_info, curr_cloud->size()))
+    for (size_t cluster = 0; cluster < cluster_indices.size(); cluster++)
+    {
+      const cloud_info& curr_cloud_info = clusters_info[cluster];
+      const std::vector<int>& indices = cluster_indices[cluster].indices;
+      if (!utils::check_threshold(curr_cloud_info, indices.size()))
       {
-        visualization_msgs::Marker marker = utils::mark_cluster(curr_cloud_info, counter, frame_id);
-        clusters_vis.markers.push_back(marker);
-        *cloud_filtered += *curr_cloud;
+        continue;
       }
 
-      counter++;
-      curr_cloud->clear();
+      // The marker id and color come from the track, so that they stay the same while the cluster is seen
+      const int track_id = tracker_.tracks()[tracks[cluster]].id;
+      clusters_vis.markers.push_back(utils::mark_cluster(curr_cloud_info, track_id, frame_id));
+      if (publish_clusters)
+      {
+        const std_msgs::ColorRGBA color = pointcloud_filter::ClusterTracker::color(track_id);
+        for (int index : indices)
+        {
+          pcl::PointXYZRGB p;
+          p.x = cloud->points[index].x;
+          p.y = cloud->points[index].y;
+          p.z = cloud->points[index].z;
+          p.r = static_cast<uint8_t>(color.r * 255);
+          p.g = static_cast<uint8_t>(color.g * 255);
+          p.b = static_cast<uint8_t>(color.b * 255);
+          cloud_filtered->points.push_back(p);
+        }
+      }
     }
+    cloud_filtered->width = cloud_filtered->points.size();
+    cloud_filtered->height = 1;
 
-    sensor_msgs::PointCloud2 output_msg = utils::format_output_msg(cloud_filtered, frame_id);
-    clustering_pub_.publish(output_msg);
-    marker_pub_.publish(clusters_vis);
+    clustering_pub_.publish([&] { return utils::format_output_msg(cloud_filtered, frame_id); });
+    marker_pub_.publish([&] { return clusters_vis; });
   }
 };
-
-int main(int argc, char** argv)
-{
-  ros::init(argc, argv, "clustering");
-  ClusteringNode clustering = ClusteringNode();
-  ros::spin();
-}
\ No newline at end of file
+}  // namespace pointcloud_segmentation
@@ -1,21 +1,54 @@
 #ifndef Clustering_H
 #define Clustering_H
 
+#include <mutex>
+
+#include <dynamic_reconfigure/server.h>
+#include <igvc_perception/ClusteringConfig.h>
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+#include <pcl_ros/point_cloud.h>
 #include <ros/ros.h>
 #include <sensor_msgs/PointCloud2.h>
+#include <tf2_ros/transform_listener.h>
+#include <visualization_msgs/MarkerArray.h>
+
+#include <igvc_utils/lazy_publisher.h>
+#include <igvc_utils/transform_cache.h>
+#include <pointcloud_filter/cluster_tracker/cluster_tracker.h>
 
+#include "grid_clustering.h"
+
+namespace pointcloud_segmentation
+{
 class ClusteringNode
 {
 public:
-  ClusteringNode();
+  ClusteringNode(const ros::NodeHandle& private_nh = { "~" });
 
 private:
   ros::NodeHandle private_nh_;
   ros::Subscriber ground_filter_sub_;
-  ros::Publisher clustering_pub_;
-  ros::Publisher marker_pub_;
+  // Both outputs are for visualization, so nothing is clustered while neither has a subscriber
+  igvc::LazyPublisher<sensor_msgs::PointCloud2> clustering_pub_;
+  igvc::LazyPublisher<visualization_msgs::MarkerArray> marker_pub_;
+
+  // The parameters are cached here whenever they change, instead of being read from the parameter server every cloud
+  dynamic_reconfigure::Server<igvc_perception::ClusteringConfig> reconfigure_server_;
+  std::mutex config_mutex_;
+  igvc_perception::ClusteringConfig config_;
+
+  GridClustering grid_clustering_;
+
+  // Tracks the clusters between clouds, so that their markers and colors don't change from one cloud to the next
+  tf2_ros::Buffer buffer_;
+  tf2_ros::TransformListener listener_;
+  igvc::TransformCache transform_cache_;
+  pointcloud_filter::ClusterTracker tracker_;
 
-  void clusteringCallback(const sensor_msgs::PointCloud2ConstPtr& input_cloud);
+  void reconfigureCallback(igvc_perception::ClusteringConfig& config, uint32_t level);
+  void clusteringCallback(const pcl::PointCloud<pcl::PointXYZ>::ConstPtr& input_cloud);
 };
+}  // namespace pointcloud_segmentation
 
-#endif  // Clustering_H
\ No newline at end of file
+#endif  // Clustering_H
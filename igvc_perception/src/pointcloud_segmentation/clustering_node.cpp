@@ -0,0 +1,9 @@
+#include "clustering.h"
+#include <ros/ros.h>
+
+int main(int argc, char** argv)
+{
+  ros::init(argc, argv, "clustering");
+  pointcloud_segmentation::ClusteringNode clustering{};
+  ros::spin();
+}
@@ -0,0 +1,174 @@
+#include "grid_clustering.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace pointcloud_segmentation
+{
+std::vector<pcl::PointIndices> GridClustering::extract(const pcl::PointCloud<pcl::PointXYZ>& cloud,
+                                                       const Params& params)
+{
+  prepareTable(cloud.size());
+  cells_.clear();
+  parents_.clear();
+  point_cells_.clear();
+
+  const double inverse_cell_size = 1.0 / params.cell_size;
+  const bool use_height = params.height_cell_size > 0.0;
+  const double inverse_height = use_height ? 1.0 / params.height_cell_size : 0.0;
+  for (const pcl::PointXYZ& point : cloud)
+  {
+    const Cell cell{ static_cast<int>(std::floor(point.x * inverse_cell_size)),
+                     static_cast<int>(std::floor(point.y * inverse_cell_size)),
+                     use_height ? static_cast<int>(std::floor(point.z * inverse_height)) : 0 };
+    point_cells_.emplace_back(insert(cell));
+  }
+
+  // Every pair of neighbouring cells is joined once, from the cell that comes first in (x, y, z) order
+  const int tolerance = std::max(params.tolerance_cells, 1);
+  const int height_tolerance = use_height ? tolerance : 0;
+  for (uint32_t cell = 0; cell < cells_.size(); cell++)
+  {
+    const Cell& center = cells_[cell];
+    for (int dx = 0; dx <= tolerance; dx++)
+    {
+      for (int dy = dx == 0 ? 0 : -tolerance; dy <= tolerance; dy++)
+      {
+        for (int dz = dx == 0 && dy == 0 ? 1 : -height_tolerance; dz <= height_tolerance; dz++)
+        {
+          uint32_t neighbour;
+          if (find({ center.x + dx, center.y + dy, center.z + dz }, neighbour))
+          {
+            join(cell, neighbour);
+          }
+        }
+      }
+    }
+  }
+
+  cluster_sizes_.assign(cells_.size(), 0);
+  for (uint32_t cell : point_cells_)
+  {
+    cluster_sizes_[root(cell)]++;
+  }
+
+  std::vector<pcl::PointIndices> clusters;
+  cluster_ids_.assign(cells_.size(), -1);
+  for (uint32_t cell = 0; cell < cells_.size(); cell++)
+  {
+    const int size = cluster_sizes_[cell];
+    if (parents_[cell] == cell && size >= params.min_size && size <= params.max_size)
+    {
+      cluster_ids_[cell] = static_cast<int>(clusters.size());
+      pcl::PointIndices& cluster = clusters.emplace_back();
+      cluster.header = cloud.header;
+      cluster.indices.reserve(size);
+    }
+  }
+
+  for (size_t point = 0; point < point_cells_.size(); point++)
+  {
+    const int cluster_id = cluster_ids_[root(point_cells_[point])];
+    if (cluster_id >= 0)
+    {
+      clusters[cluster_id].indices.emplace_back(static_cast<int>(point));
+    }
+  }
+  return clusters;
+}
+
+void GridClustering::prepareTable(size_t num_points)
+{
+  // At most half full, so that probe sequences stay short
+  size_t capacity = 16;
+  int bits = 4;
+  while (capacity < 2 * num_points)
+  {
+    capacity *= 2;
+    bits++;
+  }
+
+  if (capacity > slots_.size())
+  {
+    slots_.assign(capacity, Slot{});
+    shift_ = 64 - bits;
+    generation_ = 0;
+  }
+
+  generation_++;
+  if (generation_ == 0)
+  {
+    // Wrapped around, so stale slots could look current
+    slots_.assign(slots_.size(), Slot{});
+    generation_ = 1;
+  }
+}
+
+uint32_t GridClustering::insert(const Cell& cell)
+{
+  const uint64_t cell_key = key(cell);
+  const size_t mask = slots_.size() - 1;
+  for (size_t slot_index = (cell_key * 0x9E3779B97F4A7C15ull) >> shift_;; slot_index = (slot_index + 1) & mask)
+  {
+    Slot& slot = slots_[slot_index];
+    if (slot.generation != generation_)
+    {
+      slot = { cell_key, generation_, static_cast<uint32_t>(cells_.size()) };
+      parents_.emplace_back(static_cast<uint32_t>(cells_.size()));
+      cells_.emplace_back(cell);
+      return slot.cell;
+    }
+    if (slot.key == cell_key)
+    {
+      return slot.cell;
+    }
+  }
+}
+
+bool GridClustering::find(const Cell& cell, uint32_t& found) const
+{
+  const uint64_t cell_key = key(cell);
+  const size_t mask = slots_.size() - 1;
+  for (size_t slot_index = (cell_key * 0x9E3779B97F4A7C15ull) >> shift_;; slot_index = (slot_index + 1) & mask)
+  {
+    const Slot& slot = slots_[slot_index];
+    if (slot.generation != generation_)
+    {
+      return false;
+    }
+    if (slot.key == cell_key)
+    {
+      found = slot.cell;
+      return true;
+    }
+  }
+}
+
+uint32_t GridClustering::root(uint32_t cell)
+{
+  // Path halving keeps the trees flat without recursion
+  while (parents_[cell] != cell)
+  {
+    parents_[cell] = parents_[parents_[cell]];
+    cell = parents_[cell];
+  }
+  return cell;
+}
+
+void GridClustering::join(uint32_t first, uint32_t second)
+{
+  const uint32_t first_root = root(first);
+  const uint32_t second_root = root(second);
+  if (first_root != second_root)
+  {
+    parents_[std::max(first_root, second_root)] = std::min(first_root, second_root);
+  }
+}
+
+uint64_t GridClustering::key(const Cell& cell)
+{
+  // 21 bits per coordinate wrap around every 2097152 cells, which is far beyond the range of the lidar
+  const auto bits = [](int coordinate) { return static_cast<uint64_t>(static_cast<int64_t>(coordinate)) & 0x1fffff; };
+  return (bits(cell.x) << 42) | (bits(cell.y) << 21) | bits(cell.z);
+}
+}  // namespace pointcloud_segmentation
@@ -0,0 +1,72 @@
+#ifndef GridClustering_H
+#define GridClustering_H
+
+#include <cstdint>
+#include <vector>
+
+#include <pcl/PointIndices.h>
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+
+namespace pointcloud_segmentation
+{
+/**
+ * Clusters points by the connected components of the grid cells they occupy, in linear time and without a KD-tree.
+ *
+ * Points are binned into cells of cell_size, and also of height_cell_size in z for a 2.5D grid. Occupied cells within
+ * tolerance_cells of each other in every direction are joined with union-find, and each component is a cluster. The
+ * cells are looked up in an open addressing hash table that is kept between clouds, so that clustering doesn't
+ * allocate once the buffers have grown to the size of a cloud.
+ */
+class GridClustering
+{
+public:
+  struct Params
+  {
+    double cell_size = 0.1;
+    int tolerance_cells = 1;
+    double height_cell_size = 0.0;  // 0 for a 2D grid
+    int min_size = 1;
+    int max_size = 0;
+  };
+
+  /**
+   * Returns the indices of the points of each cluster of cloud with between min_size and max_size points
+   */
+  std::vector<pcl::PointIndices> extract(const pcl::PointCloud<pcl::PointXYZ>& cloud, const Params& params);
+
+private:
+  struct Slot
+  {
+    uint64_t key = 0;
+    uint32_t generation = 0;  // The slot is empty unless this is the current generation
+    uint32_t cell = 0;
+  };
+
+  struct Cell
+  {
+    int x;
+    int y;
+    int z;
+  };
+
+  std::vector<Slot> slots_;
+  int shift_ = 64;
+  uint32_t generation_ = 0;
+
+  std::vector<Cell> cells_;
+  std::vector<uint32_t> parents_;     // Union-find forest over cells_
+  std::vector<uint32_t> point_cells_;  // Cell of each point
+  std::vector<int> cluster_sizes_;    // Number of points of each root cell
+  std::vector<int> cluster_ids_;      // Output cluster of each root cell, or -1
+
+  void prepareTable(size_t num_points);
+  uint32_t insert(const Cell& cell);
+  bool find(const Cell& cell, uint32_t& found) const;
+  uint32_t root(uint32_t cell);
+  void join(uint32_t first, uint32_t second);
+  static uint64_t key(const Cell& cell);
+};
+}  // namespace pointcloud_segmentation
+
+#endif  // GridClustering_H
@@ -1,24 +1,20 @@
 #include "ground_filter.h"
-#include <ros/ros.h>
-#include <sensor_msgs/PointCloud2.h>
-#include <pcl/point_cloud.h>
-#include <pcl/point_types.h>
-#include <pcl_ros/point_cloud.h>
+#include <pcl_conversions/pcl_conversions.h>
 
 typedef pcl::PointCloud<pcl::PointXYZ> PC;
 
-GroundFilterNode::GroundFilterNode()
+namespace pointcloud_segmentation
+{
+GroundFilterNode::GroundFilterNode(const ros::NodeHandle& private_nh) : private_nh_{ private_nh }
 {
-  private_nh_ = ros::NodeHandle("~");
   raw_pts_sub_ = private_nh_.subscribe("/lidar/transformed", 1, &GroundFilterNode::groundFilterCallback, this);
-  ground_filter_pub_ = private_nh_.advertise<sensor_msgs::PointCloud2>("ground_segmentation", 1);
+  ground_filter_pub_ = private_nh_.advertise<PC>("ground_segmentation", 1);
 };
 
-void GroundFilterNode::groundFilterCallback(const sensor_msgs::PointCloud2ConstPtr& cloud_msg)
+void GroundFilterNode::groundFilterCallback(const pcl::PointCloud<velodyne_pcl::PointXYZIRT>::ConstPtr& cloud)
 {
-  PC::Ptr cloud(new PC);
+  // A new cloud per message, since subscribers in the same nodelet manager keep a reference to it
   PC::Ptr cloud_filtered(new PC);
-  pcl::fromROSMsg(*cloud_msg, *cloud);
 
   float x, y, z_min, z_max;
   std::string frame_id;
@@ -28,26 +24,17 @@ void GroundFilterNode::groundFilterCallback(const sensor_msgs::PointCloud2ConstP
   private_nh_.getParam("/ground_filter_node/range/height_max", z_max);
   private_nh_.getParam("/ground_filter_node/frame_id", frame_id);
 
-  for (unsigned int i = 0; i < cloud->points.size(); i++)
+  for (const velodyne_pcl::PointXYZIRT& p : cloud->points)
   {
-    pcl::PointXYZ p = cloud->points[i];
     bool within_thresholds = -x <= p.x && p.x <= x && -y <= p.y && p.y <= y && z_min <= p.z && p.z <= z_max;
     if (within_thresholds)
     {
-      cloud_filtered->push_back(p);
+      cloud_filtered->push_back(pcl::PointXYZ{ p.x, p.y, p.z });
     }
   }
 
-  sensor_msgs::PointCloud2 output_msg;
-  pcl::toROSMsg(*cloud_filtered, output_msg);
-  output_msg.header.frame_id = frame_id;
-  output_msg.header.stamp = ros::Time::now();
-  ground_filter_pub_.publish(output_msg);
+  cloud_filtered->header.frame_id = frame_id;
+  pcl_conversions::toPCL(ros::Time::now(), cloud_filtered->header.stamp);
+  ground_filter_pub_.publish(cloud_filtered);
 };
-
-int main(int argc, char** argv)
-{
-  ros::init(argc, argv, "ground_filter");
-  GroundFilterNode ground_filter = GroundFilterNode();
-  ros::spin();
-}
\ No newline at end of file
+}  // namespace pointcloud_segmentation
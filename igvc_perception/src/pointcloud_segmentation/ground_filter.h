@@ -1,20 +1,27 @@
 #ifndef GroundFilter_H
 #define GroundFilter_H
 
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+#include <pcl_ros/point_cloud.h>
 #include <ros/ros.h>
-#include <sensor_msgs/PointCloud2.h>
 
+#include <pointcloud_filter/point_types.h>
+
+namespace pointcloud_segmentation
+{
 class GroundFilterNode
 {
 public:
-  GroundFilterNode();
+  GroundFilterNode(const ros::NodeHandle& private_nh = { "~" });
 
 private:
   ros::NodeHandle private_nh_;
   ros::Subscriber raw_pts_sub_;
   ros::Publisher ground_filter_pub_;
 
-  void groundFilterCallback(const sensor_msgs::PointCloud2ConstPtr& input_cloud);
+  void groundFilterCallback(const pcl::PointCloud<velodyne_pcl::PointXYZIRT>::ConstPtr& cloud);
 };
+}  // namespace pointcloud_segmentation
 
-#endif  // GroundFilter_H
\ No newline at end of file
+#endif  // GroundFilter_H
@@ -0,0 +1,9 @@
+#include "ground_filter.h"
+#include <ros/ros.h>
+
+int main(int argc, char** argv)
+{
+  ros::init(argc, argv, "ground_filter");
+  pointcloud_segmentation::GroundFilterNode ground_filter{};
+  ros::spin();
+}
@@ -0,0 +1,32 @@
+#include "clustering.h"
+#include "ground_filter.h"
+#include <nodelet/nodelet.h>
+#include <pluginlib/class_list_macros.h>
+
+namespace pointcloud_segmentation
+{
+class GroundFilterNodelet : public nodelet::Nodelet
+{
+private:
+  std::unique_ptr<GroundFilterNode> ground_filter_;
+
+  void onInit() override
+  {
+    ground_filter_ = std::make_unique<GroundFilterNode>(getPrivateNodeHandle());
+  }
+};
+
+class ClusteringNodelet : public nodelet::Nodelet
+{
+private:
+  std::unique_ptr<ClusteringNode> clustering_;
+
+  void onInit() override
+  {
+    clustering_ = std::make_unique<ClusteringNode>(getPrivateNodeHandle());
+  }
+};
+}  // namespace pointcloud_segmentation
+
+PLUGINLIB_EXPORT_CLASS(pointcloud_segmentation::GroundFilterNodelet, nodelet::Nodelet)
+PLUGINLIB_EXPORT_CLASS(pointcloud_segmentation::ClusteringNodelet, nodelet::Nodelet)
@@ -42,6 +42,14 @@ cloud_info get_cloud_info(PCRGB::Ptr cloud)
   return output_msg;
 };
 
+cloud_info get_cloud_info(const PC& cloud, const pcl::PointIndices& indices)
+{
+  cloud_info output_msg;
+  pcl::compute3DCentroid(cloud, indices, output_msg.centroid);
+  pcl::getMinMax3D(cloud, indices.indices, output_msg.min, output_msg.max);
+  return output_msg;
+};
+
 bool check_threshold(cloud_info cloud, int cloud_size)
 {
   float diff_x = cloud.max[0] - cloud.min[0];
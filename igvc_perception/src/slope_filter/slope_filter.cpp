@@ -1,41 +1,185 @@
 #include "slope_filter.h"
+#include "slope_kernels.h"
 #include <grid_map_ros/GridMapRosConverter.hpp>
+#include <parameter_assertions/assertions.h>
 
-TraversabilityFilter::TraversabilityFilter() : filter_chain_("grid_map::GridMap")
+#include <algorithm>
+#include <limits>
+
+SlopeFilter::SlopeFilter()
 {
   private_nh_ = ros::NodeHandle("~");
-  elevation_map_sub_ = private_nh_.subscribe("/elevation_mapping/elevation_map_raw", 1,
-                                             &TraversabilityFilter::elevationMapCallback, this);
+  elevation_layer_ = assertions::param(private_nh_, "elevation_layer", std::string{ "elevation" });
+  window_size_ = std::max(assertions::param(private_nh_, "window_size", 5), 1);
+  change_threshold_ = assertions::param(private_nh_, "change_threshold", 0.001);
+  full_map_period_ = assertions::param(private_nh_, "full_map_period", 20);
+
+  elevation_map_sub_ =
+      private_nh_.subscribe("/elevation_mapping/elevation_map_raw", 1, &SlopeFilter::elevationMapCallback, this);
   traversability_map_pub_ = private_nh_.advertise<grid_map_msgs::GridMap>("/slope/gridmap", 1);
+}
 
-  // setup filter chain
-  if (!filter_chain_.configure("/slope_filter/slope_map_filters", private_nh_))
+void SlopeFilter::elevationMapCallback(const grid_map_msgs::GridMap& message)
+{
+  // Only the layers that are used are converted
+  std::vector<std::string> layers;
+  for (const std::string& layer : { elevation_layer_, std::string{ "variance" } })
+  {
+    if (std::find(message.layers.begin(), message.layers.end(), layer) != message.layers.end())
+    {
+      layers.emplace_back(layer);
+    }
+  }
+  if (layers.empty() || layers.front() != elevation_layer_)
   {
-    ROS_ERROR_STREAM("Could not configure filter chain!");
+    ROS_ERROR_STREAM_THROTTLE(1.0, "The elevation map has no " << elevation_layer_ << " layer");
     return;
   }
-}
 
-void TraversabilityFilter::elevationMapCallback(const grid_map_msgs::GridMap& message)
-{
-  grid_map::GridMap input_map;
-  grid_map::GridMapRosConverter::fromMessage(message, input_map);
+  const grid_map::Length previous_length = map_.getLength();
+  const grid_map::Position previous_position = map_.getPosition();
+  const double previous_resolution = map_.getResolution();
+
+  grid_map::GridMapRosConverter::fromMessage(message, map_, layers, false, false);
+  // The stencils work on blocks of the layers, which needs them to start at index (0, 0)
+  map_.convertToDefaultStartIndex();
+  const grid_map::Matrix& elevation = map_.get(elevation_layer_);
+
+  const bool same_geometry =
+      previous_resolution == map_.getResolution() && previous_length.isApprox(map_.getLength()) &&
+      previous_elevation_.rows() == elevation.rows() && previous_elevation_.cols() == elevation.cols() &&
+      alignPreviousElevation(previous_position);
+  const bool full_map = !same_geometry || (full_map_period_ > 0 && ++updates_since_full_map_ >= full_map_period_);
 
-  grid_map::GridMap output_map;
-  if (!filter_chain_.update(input_map, output_map))
+  grid_map::Index start{ 0, 0 };
+  grid_map::Size size = map_.getSize();
+  if (full_map)
   {
-    ROS_ERROR_STREAM("Could not update the grid map filter chain!");
-    return;
+    updates_since_full_map_ = 0;
   }
+  else
+  {
+    if (!changedRegion(elevation, start, size))
+    {
+      return;
+    }
 
+    // Cells whose smoothing window or slope stencil reaches into the changed cells changed too
+    const int margin = window_size_ / 2 + 1;
+    const grid_map::Index end = (start + size + margin).min(map_.getSize());
+    start = (start - margin).max(0);
+    size = end - start;
+  }
+  previous_elevation_ = elevation;
+
+  grid_map::GridMap submap = computeSlopeSubmap(map_, elevation_layer_, window_size_, start, size);
   grid_map_msgs::GridMap output_message;
-  grid_map::GridMapRosConverter::toMessage(output_map, output_message);
+  grid_map::GridMapRosConverter::toMessage(submap, output_message);
   traversability_map_pub_.publish(output_message);
 }
 
-int main(int argc, char** argv)
+bool SlopeFilter::alignPreviousElevation(const grid_map::Position& previous_position)
 {
-  ros::init(argc, argv, "slope_filter");
-  TraversabilityFilter tf = TraversabilityFilter();
-  ros::spin();
+  const Eigen::Array2d cells = (map_.getPosition() - previous_position).array() / map_.getResolution();
+  const Eigen::Array2d whole_cells = cells.round();
+  if (((cells - whole_cells).abs() > 1e-3).any())
+  {
+    return false;
+  }
+
+  // Indices grow towards -x and -y, so after the map moves by shift cells a cell is at its previous index + shift
+  const grid_map::Index shift = whole_cells.cast<int>();
+  if ((shift == 0).all())
+  {
+    return true;
+  }
+
+  const grid_map::Size size{ previous_elevation_.rows(), previous_elevation_.cols() };
+  grid_map::Matrix shifted = grid_map::Matrix::Constant(size(0), size(1), std::numeric_limits<float>::quiet_NaN());
+  const grid_map::Size overlap = size - shift.abs();
+  if ((overlap > 0).all())
+  {
+    const grid_map::Index from = (-shift).max(0);
+    const grid_map::Index to = shift.max(0);
+    shifted.block(to(0), to(1), overlap(0), overlap(1)) =
+        previous_elevation_.block(from(0), from(1), overlap(0), overlap(1));
+  }
+  previous_elevation_.swap(shifted);
+  return true;
+}
+
+bool SlopeFilter::changedRegion(const grid_map::Matrix& elevation, grid_map::Index& start, grid_map::Size& size) const
+{
+  const auto current = elevation.array();
+  const auto previous = previous_elevation_.array();
+  const Eigen::Array<bool, Eigen::Dynamic, Eigen::Dynamic> changed =
+      (current - previous).abs() > change_threshold_ || current.isNaN() != previous.isNaN();
+
+  const Eigen::Array<bool, Eigen::Dynamic, 1> changed_rows = changed.rowwise().any();
+  const Eigen::Array<bool, 1, Eigen::Dynamic> changed_cols = changed.colwise().any();
+  if (!changed_rows.any())
+  {
+    return false;
+  }
+
+  const auto first = [](const auto& flags) {
+    Eigen::Index index = 0;
+    while (!flags(index))
+    {
+      index++;
+    }
+    return static_cast<int>(index);
+  };
+  const auto last = [](const auto& flags) {
+    Eigen::Index index = flags.size() - 1;
+    while (!flags(index))
+    {
+      index--;
+    }
+    return static_cast<int>(index);
+  };
+
+  start = { first(changed_rows), first(changed_cols) };
+  size = grid_map::Size{ last(changed_rows), last(changed_cols) } - start + 1;
+  return true;
+}
+
+grid_map::GridMap computeSlopeSubmap(const grid_map::GridMap& map, const std::string& elevation_layer, int window_size,
+                                     const grid_map::Index& start, const grid_map::Size& size)
+{
+  // The stencils read past the edges of the region, as far as the map goes
+  const int margin = window_size / 2 + 1;
+  const grid_map::Index input_start = (start - margin).max(0);
+  const grid_map::Index input_end = (start + size + margin).min(map.getSize());
+  const grid_map::Size input_size = input_end - input_start;
+  const grid_map::Index offset = start - input_start;
+
+  const Eigen::ArrayXXf elevation =
+      map.get(elevation_layer).block(input_start(0), input_start(1), input_size(0), input_size(1)).array();
+  const Eigen::ArrayXXf smooth = slope_kernels::meanOfFinites(elevation, window_size / 2);
+  const Eigen::ArrayXXf slope = slope_kernels::slope(smooth, static_cast<float>(map.getResolution()));
+
+  // Centered between the centers of its corner cells, so that its cells line up with the cells of map
+  grid_map::Position first_corner;
+  grid_map::Position last_corner;
+  map.getPosition(start, first_corner);
+  map.getPosition(start + size - 1, last_corner);
+
+  grid_map::GridMap submap;
+  submap.setFrameId(map.getFrameId());
+  submap.setTimestamp(map.getTimestamp());
+  submap.setGeometry(size.cast<double>() * map.getResolution(), map.getResolution(), (first_corner + last_corner) / 2);
+
+  const auto region = [&](const Eigen::ArrayXXf& layer) -> grid_map::Matrix {
+    return layer.block(offset(0), offset(1), size(0), size(1)).matrix();
+  };
+  submap.add(elevation_layer, region(elevation));
+  submap.add("elevation_smooth", region(smooth));
+  submap.add("slope", region(slope));
+  submap.add("roughness", region((elevation - smooth).abs()));
+  if (map.exists("variance"))
+  {
+    submap.add("variance", map.get("variance").block(start(0), start(1), size(0), size(1)));
+  }
+  return submap;
 }
@@ -2,22 +2,62 @@
 #define SRC_SLOPE_FILTER_H
 
 #include <ros/ros.h>
-#include <filters/filter_chain.h>
 #include <grid_map_core/GridMap.hpp>
 #include <grid_map_msgs/GridMap.h>
 
-class TraversabilityFilter
+/**
+ * Computes the layers published by SlopeFilter over the cells from start of size size of map, reading as many of the
+ * cells around them as the stencils of a window_size smoothing window reach
+ */
+grid_map::GridMap computeSlopeSubmap(const grid_map::GridMap& map, const std::string& elevation_layer, int window_size,
+                                     const grid_map::Index& start, const grid_map::Size& size);
+
+/**
+ * Computes the slope and roughness of the elevation map, and publishes them for the region that changed.
+ *
+ * Each update is compared with the previous one, and only the bounding box of the cells whose elevation changed is
+ * recomputed, grown by the cells whose stencils reach into it. That region is published as a submap, with the layers
+ * elevation, elevation_smooth (mean of the finite elevations in a window_size window), slope (angle of the smoothed
+ * surface, rad), roughness (distance of the elevation from the smoothed surface, m) and variance if the input has it.
+ * When the map moves with the robot, the previous elevation is shifted by the cells it moved, so that only the cells
+ * that changed or entered the map are recomputed. The cells next to the edge it moved away from are not republished,
+ * as their published values were computed with the cells that left the map. The whole map is published when its
+ * resolution or size changes or its cells no longer line up, and every full_map_period updates so that late
+ * subscribers get all of it.
+ */
+class SlopeFilter
 {
 public:
-  TraversabilityFilter();
+  SlopeFilter();
 
 private:
   ros::NodeHandle private_nh_;
   ros::Subscriber elevation_map_sub_;
   ros::Publisher traversability_map_pub_;
-  filters::FilterChain<grid_map::GridMap> filter_chain_;
+
+  std::string elevation_layer_;
+  int window_size_;
+  double change_threshold_;
+  int full_map_period_;
+
+  grid_map::GridMap map_;
+  grid_map::Matrix previous_elevation_;
+  int updates_since_full_map_ = 0;
 
   void elevationMapCallback(const grid_map_msgs::GridMap& message);
+
+  /**
+   * Shifts previous_elevation_ by the cells the map moved from previous_position, so that its cells line up with those
+   * of map_. Cells that entered the map are NaN, as the kernels treat cells outside of it.
+   * @return false if the map moved by a fraction of a cell
+   */
+  bool alignPreviousElevation(const grid_map::Position& previous_position);
+
+  /**
+   * Finds the bounding box of the cells of elevation that changed since previous_elevation_
+   * @return false if none changed
+   */
+  bool changedRegion(const grid_map::Matrix& elevation, grid_map::Index& start, grid_map::Size& size) const;
 };
 
 #endif  // SRC_SLOPE_FILTER_H
@@ -0,0 +1,8 @@
+#include "slope_filter.h"
+
+int main(int argc, char** argv)
+{
+  ros::init(argc, argv, "slope_filter");
+  SlopeFilter slope_filter;
+  ros::spin();
+}
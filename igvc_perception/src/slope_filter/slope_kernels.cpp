@@ -0,0 +1,65 @@
+#include "slope_kernels.h"
+
+#include <limits>
+
+namespace slope_kernels
+{
+namespace
+{
+/**
+ * Sum of the cells within half_window cells of each cell, clipped to the block. Summed along each axis in turn, so
+ * that a window costs 2 * window_size block additions instead of window_size^2.
+ */
+Eigen::ArrayXXf boxSum(const Eigen::ArrayXXf& values, int half_window)
+{
+  const Eigen::Index rows = values.rows();
+  const Eigen::Index cols = values.cols();
+
+  Eigen::ArrayXXf row_sums = values;
+  for (Eigen::Index offset = 1; offset <= half_window && offset < rows; offset++)
+  {
+    row_sums.topRows(rows - offset) += values.bottomRows(rows - offset);
+    row_sums.bottomRows(rows - offset) += values.topRows(rows - offset);
+  }
+
+  Eigen::ArrayXXf sums = row_sums;
+  for (Eigen::Index offset = 1; offset <= half_window && offset < cols; offset++)
+  {
+    sums.leftCols(cols - offset) += row_sums.rightCols(cols - offset);
+    sums.rightCols(cols - offset) += row_sums.leftCols(cols - offset);
+  }
+  return sums;
+}
+}  // namespace
+
+Eigen::ArrayXXf meanOfFinites(const Eigen::ArrayXXf& values, int half_window)
+{
+  const auto finite = values.isFinite();
+  const Eigen::ArrayXXf sums = boxSum(finite.select(values, 0.0f), half_window);
+  const Eigen::ArrayXXf counts = boxSum(finite.cast<float>(), half_window);
+  return (counts > 0.0f).select(sums / counts, std::numeric_limits<float>::quiet_NaN());
+}
+
+Eigen::ArrayXXf slope(const Eigen::ArrayXXf& heights, float resolution)
+{
+  const Eigen::Index rows = heights.rows();
+  const Eigen::Index cols = heights.cols();
+  Eigen::ArrayXXf slopes = Eigen::ArrayXXf::Constant(rows, cols, std::numeric_limits<float>::quiet_NaN());
+  if (rows < 3 || cols < 3)
+  {
+    return slopes;
+  }
+
+  const Eigen::Index inner_rows = rows - 2;
+  const Eigen::Index inner_cols = cols - 2;
+  const float scale = 1.0f / (2.0f * resolution);
+  const Eigen::ArrayXXf gradient_rows =
+      (heights.block(2, 1, inner_rows, inner_cols) - heights.block(0, 1, inner_rows, inner_cols)) * scale;
+  const Eigen::ArrayXXf gradient_cols =
+      (heights.block(1, 2, inner_rows, inner_cols) - heights.block(1, 0, inner_rows, inner_cols)) * scale;
+
+  // The angle between the surface normal (-dx, -dy, 1) and the z axis, as the filter chain's acos(normal_z) was
+  slopes.block(1, 1, inner_rows, inner_cols) = (gradient_rows.square() + gradient_cols.square()).sqrt().atan();
+  return slopes;
+}
+}  // namespace slope_kernels
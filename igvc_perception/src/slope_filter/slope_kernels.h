@@ -0,0 +1,24 @@
+#ifndef SRC_SLOPE_KERNELS_H
+#define SRC_SLOPE_KERNELS_H
+
+#include <Eigen/Core>
+
+/**
+ * Stencils over blocks of a grid map layer. Each is written as whole block Eigen expressions, which Eigen vectorizes,
+ * instead of as a loop over cells.
+ */
+namespace slope_kernels
+{
+/**
+ * Mean of the finite cells within half_window cells of each cell, clipped to the block. NaN where there are none.
+ */
+Eigen::ArrayXXf meanOfFinites(const Eigen::ArrayXXf& values, int half_window);
+
+/**
+ * Slope angle (rad) of each cell from the central differences of its neighbours. NaN on the edges of the block, and
+ * where a neighbour is NaN.
+ */
+Eigen::ArrayXXf slope(const Eigen::ArrayXXf& heights, float resolution);
+}  // namespace slope_kernels
+
+#endif  // SRC_SLOPE_KERNELS_H
@@ -0,0 +1,162 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+#include <pointcloud_filter/circle_fit.h>
+
+using pointcloud_filter::Circle;
+using pointcloud_filter::CircleFitParams;
+using pointcloud_filter::fitCircle;
+
+class TestCircleFit : public testing::Test
+{
+protected:
+  pcl::PointCloud<pcl::PointXYZ> cloud;
+  std::vector<int> indices;
+  CircleFitParams params;
+  Circle circle;
+  std::vector<int> inliers;
+
+  void SetUp() override
+  {
+    params.min_radius = 0.2;
+    params.max_radius = 0.4;
+    params.distance_threshold = 0.03;
+    params.min_inlier_ratio = 0.6;
+    params.max_iterations = 200;
+  }
+
+  void addPoint(double x, double y)
+  {
+    indices.emplace_back(static_cast<int>(cloud.size()));
+    cloud.push_back(pcl::PointXYZ{ static_cast<float>(x), static_cast<float>(y), 0.0f });
+  }
+
+  /**
+   * Adds points every step radians of the arc of a circle from start to end, with gaussian noise along the radius
+   */
+  void addArc(const Eigen::Vector2d& center, double radius, double start, double end, double step, double noise,
+              std::mt19937& random)
+  {
+    std::normal_distribution<double> radial_noise{ 0.0, noise };
+    for (double angle = start; angle <= end; angle += step)
+    {
+      const double distance = radius + (noise > 0.0 ? radial_noise(random) : 0.0);
+      addPoint(center.x() + distance * std::cos(angle), center.y() + distance * std::sin(angle));
+    }
+  }
+};
+
+TEST_F(TestCircleFit, FitsHalfVisibleBarrelWithOutliers)
+{
+  std::mt19937 random{ 42 };
+  const Eigen::Vector2d center{ 3.0, 1.0 };
+  const double radius = 0.29;
+
+  // The half of the barrel facing a lidar at the origin
+  const double facing = std::atan2(-center.y(), -center.x());
+  addArc(center, radius, facing - M_PI_2, facing + M_PI_2, M_PI / 60, 0.005, random);
+  const size_t num_arc_points = indices.size();
+
+  // Grass in front of the barrel and a post behind it
+  std::vector<int> outliers;
+  std::uniform_real_distribution<double> offset{ -0.15, 0.15 };
+  for (int i = 0; i < 8; i++)
+  {
+    outliers.emplace_back(indices.size());
+    addPoint(2.4 + offset(random), 0.8 + offset(random));
+  }
+  for (int i = 0; i < 4; i++)
+  {
+    outliers.emplace_back(indices.size());
+    addPoint(3.6, 1.2 + 0.02 * i);
+  }
+
+  ASSERT_TRUE(fitCircle(cloud, indices, params, circle, inliers));
+  EXPECT_NEAR(circle.center.x(), center.x(), 0.02);
+  EXPECT_NEAR(circle.center.y(), center.y(), 0.02);
+  EXPECT_NEAR(circle.radius, radius, 0.02);
+
+  EXPECT_EQ(inliers.size(), num_arc_points);
+  for (int outlier : outliers)
+  {
+    EXPECT_EQ(std::find(inliers.begin(), inliers.end(), outlier), inliers.end()) << "outlier " << outlier;
+  }
+}
+
+TEST_F(TestCircleFit, IsDeterministic)
+{
+  std::mt19937 random{ 7 };
+  addArc(Eigen::Vector2d{ -2.0, 4.0 }, 0.3, 0.0, M_PI, M_PI / 30, 0.01, random);
+  for (int i = 0; i < 6; i++)
+  {
+    addPoint(-2.0, 3.0 + 0.05 * i);
+  }
+
+  ASSERT_TRUE(fitCircle(cloud, indices, params, circle, inliers));
+  Circle second_circle;
+  std::vector<int> second_inliers;
+  ASSERT_TRUE(fitCircle(cloud, indices, params, second_circle, second_inliers));
+  EXPECT_EQ(circle.center, second_circle.center);
+  EXPECT_EQ(circle.radius, second_circle.radius);
+  EXPECT_EQ(inliers, second_inliers);
+}
+
+TEST_F(TestCircleFit, RejectsRadiusOutsideLimits)
+{
+  std::mt19937 random{ 1 };
+  addArc(Eigen::Vector2d{ 3.0, 0.0 }, 1.0, M_PI_2, 3 * M_PI_2, M_PI / 60, 0.0, random);
+  EXPECT_FALSE(fitCircle(cloud, indices, params, circle, inliers));
+
+  cloud.clear();
+  indices.clear();
+  addArc(Eigen::Vector2d{ 3.0, 0.0 }, 0.1, M_PI_2, 3 * M_PI_2, M_PI / 60, 0.0, random);
+  EXPECT_FALSE(fitCircle(cloud, indices, params, circle, inliers));
+
+  // The same arc is a barrel once the limits allow it
+  params.min_radius = 0.05;
+  ASSERT_TRUE(fitCircle(cloud, indices, params, circle, inliers));
+  EXPECT_NEAR(circle.radius, 0.1, 1e-3);
+}
+
+TEST_F(TestCircleFit, RejectsFewerThanThreePoints)
+{
+  inliers = { 0 };
+  EXPECT_FALSE(fitCircle(cloud, indices, params, circle, inliers));
+  EXPECT_TRUE(inliers.empty());
+
+  addPoint(1.0, 0.0);
+  addPoint(1.0, 0.5);
+  EXPECT_FALSE(fitCircle(cloud, indices, params, circle, inliers));
+  EXPECT_TRUE(inliers.empty());
+}
+
+TEST_F(TestCircleFit, RejectsCollinearPoints)
+{
+  for (int i = 0; i < 20; i++)
+  {
+    addPoint(2.0 + 0.02 * i, -1.0 + 0.03 * i);
+  }
+  EXPECT_FALSE(fitCircle(cloud, indices, params, circle, inliers));
+
+  // Only the cloud points at indices are fit
+  cloud.clear();
+  indices.clear();
+  for (int i = 0; i < 20; i++)
+  {
+    addPoint(5.0, 0.05 * i);
+  }
+  std::mt19937 random{ 3 };
+  const std::vector<int> line = indices;
+  addArc(Eigen::Vector2d{ 0.0, 0.0 }, 0.3, 0.0, M_PI, M_PI / 30, 0.0, random);
+  indices = line;
+  EXPECT_FALSE(fitCircle(cloud, indices, params, circle, inliers));
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,160 @@
+#include <gtest/gtest.h>
+
+#include "../pointcloud_segmentation/grid_clustering.h"
+
+using pointcloud_segmentation::GridClustering;
+
+class TestGridClustering : public testing::Test
+{
+protected:
+  static constexpr double cell_size = 0.1;
+
+  pcl::PointCloud<pcl::PointXYZ> cloud;
+  GridClustering clustering;
+
+  /**
+   * Adds a point at the center of the grid cell (x, y, z) and returns its index
+   */
+  int addPoint(int x, int y, int z = 0)
+  {
+    cloud.push_back(pcl::PointXYZ{ static_cast<float>((x + 0.5) * cell_size),
+                                   static_cast<float>((y + 0.5) * cell_size),
+                                   static_cast<float>((z + 0.5) * cell_size) });
+    return static_cast<int>(cloud.size()) - 1;
+  }
+
+  GridClustering::Params params(int tolerance_cells, bool use_height) const
+  {
+    GridClustering::Params params;
+    params.cell_size = cell_size;
+    params.tolerance_cells = tolerance_cells;
+    params.height_cell_size = use_height ? cell_size : 0.0;
+    params.min_size = 1;
+    params.max_size = 1000;
+    return params;
+  }
+
+  static std::vector<std::vector<int>> indices(const std::vector<pcl::PointIndices>& clusters)
+  {
+    std::vector<std::vector<int>> result;
+    for (const pcl::PointIndices& cluster : clusters)
+    {
+      result.emplace_back(cluster.indices);
+    }
+    return result;
+  }
+};
+
+TEST_F(TestGridClustering, JoinsClustersJustInsideTolerance2D)
+{
+  const int a0 = addPoint(0, 0);
+  const int a1 = addPoint(1, 0);
+  // Diagonal neighbours towards -y, which are only enumerated from the cell with the lower x
+  const int b0 = addPoint(3, -2);
+  const int b1 = addPoint(2, -1);
+
+  EXPECT_EQ(indices(clustering.extract(cloud, params(1, false))),
+            (std::vector<std::vector<int>>{ { a0, a1, b0, b1 } }));
+}
+
+TEST_F(TestGridClustering, SeparatesClustersJustOutsideTolerance2D)
+{
+  const int a0 = addPoint(0, 0);
+  const int a1 = addPoint(1, 0);
+  const int b0 = addPoint(3, -2);
+  const int b1 = addPoint(4, -2);
+
+  EXPECT_EQ(indices(clustering.extract(cloud, params(1, false))),
+            (std::vector<std::vector<int>>{ { a0, a1 }, { b0, b1 } }));
+}
+
+TEST_F(TestGridClustering, UsesToleranceCells2D)
+{
+  const int a0 = addPoint(0, 0);
+  const int b0 = addPoint(2, 2);
+  const int c0 = addPoint(2, 5);
+
+  // Two cells of tolerance reach the diagonal cell two away, but not three cells along y
+  EXPECT_EQ(indices(clustering.extract(cloud, params(2, false))),
+            (std::vector<std::vector<int>>{ { a0, b0 }, { c0 } }));
+}
+
+TEST_F(TestGridClustering, IgnoresHeightIn2D)
+{
+  const int a0 = addPoint(0, 0, 0);
+  const int a1 = addPoint(0, 0, 10);
+
+  EXPECT_EQ(indices(clustering.extract(cloud, params(1, false))), (std::vector<std::vector<int>>{ { a0, a1 } }));
+}
+
+TEST_F(TestGridClustering, JoinsClustersJustInsideTolerance25D)
+{
+  const int a0 = addPoint(0, 0, 0);
+  // Straight up, which is only enumerated with a positive dz
+  const int a1 = addPoint(0, 0, 1);
+  // Down and across, which needs a negative dz from the cell with the lower x
+  const int b0 = addPoint(1, 0, -1);
+  // Same x, lower y and higher z
+  const int b1 = addPoint(1, -1, 0);
+
+  EXPECT_EQ(indices(clustering.extract(cloud, params(1, true))), (std::vector<std::vector<int>>{ { a0, a1, b0, b1 } }));
+}
+
+TEST_F(TestGridClustering, SeparatesClustersJustOutsideTolerance25D)
+{
+  const int a0 = addPoint(0, 0, 0);
+  const int a1 = addPoint(0, 0, 1);
+  // Same column, two cells above a1
+  const int b0 = addPoint(0, 0, 3);
+  // Next column, two cells below a0
+  const int c0 = addPoint(1, 0, -2);
+
+  EXPECT_EQ(indices(clustering.extract(cloud, params(1, true))),
+            (std::vector<std::vector<int>>{ { a0, a1 }, { b0 }, { c0 } }));
+}
+
+TEST_F(TestGridClustering, FiltersClustersBySize)
+{
+  std::vector<int> small;
+  std::vector<int> large;
+  for (int i = 0; i < 3; i++)
+  {
+    small.emplace_back(addPoint(i, 0));
+  }
+  for (int i = 0; i < 5; i++)
+  {
+    large.emplace_back(addPoint(i, 10));
+  }
+  // Points in the same cell count separately
+  large.emplace_back(addPoint(4, 10));
+
+  GridClustering::Params size_params = params(1, false);
+  size_params.min_size = 4;
+  EXPECT_EQ(indices(clustering.extract(cloud, size_params)), (std::vector<std::vector<int>>{ large }));
+
+  size_params.min_size = 3;
+  size_params.max_size = 5;
+  EXPECT_EQ(indices(clustering.extract(cloud, size_params)), (std::vector<std::vector<int>>{ small }));
+
+  size_params.max_size = 6;
+  EXPECT_EQ(indices(clustering.extract(cloud, size_params)), (std::vector<std::vector<int>>{ small, large }));
+}
+
+TEST_F(TestGridClustering, ReusesTableBetweenClouds)
+{
+  addPoint(0, 0);
+  addPoint(5, 5);
+  ASSERT_EQ(clustering.extract(cloud, params(1, false)).size(), 2u);
+
+  // Cells of the previous cloud must not join the clusters of the next one
+  cloud.clear();
+  const int a0 = addPoint(0, 0);
+  const int b0 = addPoint(3, 3);
+  EXPECT_EQ(indices(clustering.extract(cloud, params(1, false))), (std::vector<std::vector<int>>{ { a0 }, { b0 } }));
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
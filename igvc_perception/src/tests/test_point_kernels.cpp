@@ -0,0 +1,165 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <limits>
+#include <random>
+
+#include <pointcloud_filter/point_kernels.h>
+
+namespace kernels = pointcloud_filter::kernels;
+
+namespace
+{
+// Bound on the error of the approximation of atan2, far below the angle thresholds of the ground filters
+constexpr double max_angle_error = 3e-5;
+}  // namespace
+
+TEST(TestPointKernels, RangeAzimuthMatchesAtan2)
+{
+  std::mt19937 random{ 11 };
+  std::uniform_real_distribution<float> coordinate{ -40.0f, 40.0f };
+
+  // Odd sized, so that the AVX2 version also handles a tail
+  std::vector<float> x(1001);
+  std::vector<float> y(x.size());
+  for (size_t i = 0; i < x.size(); i++)
+  {
+    x[i] = coordinate(random);
+    y[i] = coordinate(random);
+  }
+  // The axes and the diagonals, where the approximation switches octants
+  const std::vector<std::pair<float, float>> special = { { 0.0f, 0.0f },  { 1.0f, 0.0f },   { -1.0f, 0.0f },
+                                                         { 0.0f, 2.0f },  { 0.0f, -2.0f },  { 3.0f, 3.0f },
+                                                         { -3.0f, 3.0f }, { -3.0f, -3.0f }, { 3.0f, -3.0f } };
+  for (size_t i = 0; i < special.size(); i++)
+  {
+    x[i] = special[i].first;
+    y[i] = special[i].second;
+  }
+
+  std::vector<float> range(x.size());
+  std::vector<float> azimuth(x.size());
+  kernels::rangeAzimuth(x.data(), y.data(), x.size(), range.data(), azimuth.data());
+  for (size_t i = 0; i < x.size(); i++)
+  {
+    EXPECT_NEAR(range[i], std::hypot(x[i], y[i]), 1e-5 * range[i]) << "point " << i;
+    EXPECT_NEAR(azimuth[i], std::atan2(y[i], x[i]), max_angle_error) << "point " << i;
+  }
+}
+
+TEST(TestPointKernels, InclinationMatchesAtan2)
+{
+  std::mt19937 random{ 13 };
+  std::uniform_real_distribution<float> coordinate{ -20.0f, 20.0f };
+  std::uniform_real_distribution<float> height{ -1.0f, 1.0f };
+
+  std::vector<float> x0(517);
+  std::vector<float> y0(x0.size());
+  std::vector<float> z0(x0.size());
+  std::vector<float> x1(x0.size());
+  std::vector<float> y1(x0.size());
+  std::vector<float> z1(x0.size());
+  for (size_t i = 0; i < x0.size(); i++)
+  {
+    x0[i] = coordinate(random);
+    y0[i] = coordinate(random);
+    z0[i] = height(random);
+    // Mostly the short, shallow segments between consecutive rings
+    x1[i] = x0[i] + 0.1f * coordinate(random);
+    y1[i] = y0[i] + 0.1f * coordinate(random);
+    z1[i] = z0[i] + 0.2f * height(random);
+  }
+  // Straight up and down
+  x1[0] = x0[0];
+  y1[0] = y0[0];
+  x1[1] = x0[1];
+  y1[1] = y0[1];
+  z1[1] = z0[1] - 1.0f;
+
+  std::vector<float> angle(x0.size());
+  kernels::inclination(x0.data(), y0.data(), z0.data(), x1.data(), y1.data(), z1.data(), x0.size(), angle.data());
+  for (size_t i = 0; i < x0.size(); i++)
+  {
+    const double expected = std::atan2(z1[i] - z0[i], std::hypot(x1[i] - x0[i], y1[i] - y0[i]));
+    EXPECT_NEAR(angle[i], expected, max_angle_error) << "pair " << i;
+  }
+}
+
+TEST(TestPointKernels, TransformMatchesEigen)
+{
+  std::mt19937 random{ 17 };
+  std::uniform_real_distribution<float> coordinate{ -40.0f, 40.0f };
+
+  // Odd sized, so that the AVX2 version also handles a tail
+  pointcloud_filter::PointBuffer points;
+  points.resize(1003);
+  for (size_t i = 0; i < points.size(); i++)
+  {
+    points.x[i] = coordinate(random);
+    points.y[i] = coordinate(random);
+    points.z[i] = 0.1f * coordinate(random);
+  }
+  const pointcloud_filter::PointBuffer original = points;
+
+  const Eigen::Isometry3f transform = Eigen::Translation3f{ 1.2f, -0.4f, 0.9f } *
+                                      Eigen::AngleAxisf{ 0.7f, Eigen::Vector3f{ 0.1f, -0.2f, 1.0f }.normalized() };
+  kernels::transform(transform, points);
+
+  ASSERT_EQ(points.size(), original.size());
+  for (size_t i = 0; i < points.size(); i++)
+  {
+    const Eigen::Vector3f expected = transform * Eigen::Vector3f{ original.x[i], original.y[i], original.z[i] };
+    EXPECT_NEAR(points.x[i], expected.x(), 1e-4) << "point " << i;
+    EXPECT_NEAR(points.y[i], expected.y(), 1e-4) << "point " << i;
+    EXPECT_NEAR(points.z[i], expected.z(), 1e-4) << "point " << i;
+  }
+}
+
+TEST(TestPointKernels, MaskInRangeMatchesLoop)
+{
+  std::mt19937 random{ 19 };
+  std::uniform_real_distribution<float> value{ -2.0f, 2.0f };
+  const float min = -0.5f;
+  const float max = 1.25f;
+
+  std::vector<float> values(1005);
+  std::vector<uint8_t> mask(values.size());
+  for (size_t i = 0; i < values.size(); i++)
+  {
+    values[i] = value(random);
+    // Points that are already masked out stay masked out
+    mask[i] = i % 7 != 0;
+  }
+  // The bounds are in range, just past them and NaN aren't. Some are in the tail of the AVX2 version.
+  const std::vector<float> special = { min, max, std::nextafter(min, -1.0f), std::nextafter(max, 2.0f),
+                                       std::numeric_limits<float>::quiet_NaN() };
+  for (size_t i = 0; i < special.size(); i++)
+  {
+    values[1 + i] = special[i];
+    values[values.size() - 1 - i] = special[i];
+    mask[1 + i] = 1;
+    mask[values.size() - 1 - i] = 1;
+  }
+
+  std::vector<uint8_t> expected = mask;
+  for (size_t i = 0; i < values.size(); i++)
+  {
+    expected[i] = expected[i] && min <= values[i] && values[i] <= max;
+  }
+
+  kernels::maskInRange(values.data(), values.size(), min, max, mask.data());
+  for (size_t i = 0; i < values.size(); i++)
+  {
+    EXPECT_EQ(mask[i], expected[i]) << "value " << i << " = " << values[i];
+  }
+  EXPECT_EQ(mask[1], 1);
+  EXPECT_EQ(mask[2], 1);
+  EXPECT_EQ(mask[values.size() - 1], 1);
+  EXPECT_EQ(mask[values.size() - 2], 1);
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,247 @@
+#include <gtest/gtest.h>
+#include <ros/ros.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include <pointcloud_filter/range_ground_filter/range_ground_filter.h>
+
+using pointcloud_filter::Bundle;
+using pointcloud_filter::RangeGroundFilter;
+
+/**
+ * Builds scans of a VLP-16 mounted height above flat ground, with one point per cell of the default range image
+ */
+class TestRangeGroundFilter : public testing::Test
+{
+protected:
+  static constexpr int columns = 1800;
+  static constexpr int rings = 16;
+  static constexpr float height = 0.8f;
+
+  ros::NodeHandle nh{ "~" };
+  RangeGroundFilter filter{ nh };
+  Bundle::PointCloud::Ptr cloud{ new Bundle::PointCloud };
+
+  static float elevation(int ring)
+  {
+    return static_cast<float>((2 * ring - 15) * M_PI / 180);
+  }
+
+  static float azimuth(int column)
+  {
+    return static_cast<float>(-M_PI + (column + 0.5) * 2 * M_PI / columns);
+  }
+
+  /**
+   * Range in the xy plane at which the ring hits the ground, or infinity for the rings that point up
+   */
+  static float groundRange(int ring)
+  {
+    return elevation(ring) < 0.0f ? height / std::tan(-elevation(ring)) : std::numeric_limits<float>::infinity();
+  }
+
+  /**
+   * Adds the return of the ring at the given range in the xy plane of the column, and returns its index
+   */
+  int addPoint(int ring, int column, float range)
+  {
+    velodyne_pcl::PointXYZIRT point;
+    point.x = range * std::cos(azimuth(column));
+    point.y = range * std::sin(azimuth(column));
+    point.z = range * std::tan(elevation(ring));
+    point.ring = static_cast<uint16_t>(ring);
+    cloud->push_back(point);
+    return static_cast<int>(cloud->size()) - 1;
+  }
+
+  int addNaN(int ring)
+  {
+    velodyne_pcl::PointXYZIRT point;
+    point.x = point.y = point.z = std::numeric_limits<float>::quiet_NaN();
+    point.ring = static_cast<uint16_t>(ring);
+    cloud->push_back(point);
+    return static_cast<int>(cloud->size()) - 1;
+  }
+
+  /**
+   * Adds the ground returns of the column, and returns their indices by ring
+   */
+  std::vector<int> addGround(int column)
+  {
+    std::vector<int> indices(rings, -1);
+    for (int ring = 0; ring < rings; ring++)
+    {
+      if (std::isfinite(groundRange(ring)))
+      {
+        indices[ring] = addPoint(ring, column, groundRange(ring));
+      }
+    }
+    return indices;
+  }
+
+  std::vector<int> occupied()
+  {
+    Bundle bundle{ cloud };
+    filter.filter(bundle);
+    std::vector<int> occupied = bundle.occupied_indices;
+    std::sort(occupied.begin(), occupied.end());
+    return occupied;
+  }
+
+  static bool contains(const std::vector<int>& sorted, int index)
+  {
+    return std::binary_search(sorted.begin(), sorted.end(), index);
+  }
+};
+
+TEST_F(TestRangeGroundFilter, LabelsFlatGroundAsGround)
+{
+  for (int column = 0; column < columns; column++)
+  {
+    addGround(column);
+  }
+  EXPECT_TRUE(occupied().empty());
+}
+
+TEST_F(TestRangeGroundFilter, DoesNotLabelWallAsGround)
+{
+  // A 2 m high wall across the x axis, 4 m in front of the lidar
+  const float wall_x = 4.0f;
+  const float wall_top = 2.0f - height;
+  std::vector<int> ground;
+  std::vector<int> wall;
+  std::vector<int> wall_foot;
+  for (int column = 0; column < columns; column++)
+  {
+    const float wall_range = std::abs(azimuth(column)) < 0.35f ? wall_x / std::cos(azimuth(column)) : 0.0f;
+    for (int ring = 0; ring < rings; ring++)
+    {
+      const float ground_range = groundRange(ring);
+      if (wall_range > 0.0f && wall_range < ground_range && wall_range * std::tan(elevation(ring)) < wall_top)
+      {
+        const int index = addPoint(ring, column, wall_range);
+        // Within a few centimeters of the ground, the wall can't be told apart from it
+        (cloud->points[index].z > 0.15f - height ? wall : wall_foot).emplace_back(index);
+      }
+      else if (std::isfinite(ground_range))
+      {
+        ground.emplace_back(addPoint(ring, column, ground_range));
+      }
+    }
+  }
+  ASSERT_FALSE(wall.empty());
+
+  const std::vector<int> nonground = occupied();
+  for (int index : wall)
+  {
+    EXPECT_TRUE(contains(nonground, index)) << "wall point " << index << " at z " << cloud->points[index].z;
+  }
+  for (int index : ground)
+  {
+    EXPECT_FALSE(contains(nonground, index)) << "ground point " << index;
+  }
+}
+
+/**
+ * The ground behind a low bar across columns first to last is only reachable from the ground of the columns beside
+ * it, since the bar makes the lowest cell of those columns steep. The columns before first and after last are left as
+ * set by fill_gap.
+ */
+class TestRangeGroundFilterAcrossColumns : public TestRangeGroundFilter
+{
+protected:
+  static constexpr int first = 300;
+  static constexpr int last = 400;
+
+  std::vector<int> bar;
+  std::vector<int> behind_bar;
+  std::vector<int> gap;
+
+  template <typename FillGap>
+  void buildScan(const FillGap& fill_gap)
+  {
+    for (int column = 0; column < columns; column++)
+    {
+      if (column == first - 1 || column == last + 1)
+      {
+        fill_gap(column);
+      }
+      else if (column < first || column > last)
+      {
+        addGround(column);
+      }
+      else
+      {
+        // The lowest ring hits the bar 1 m away instead of the ground, and the next one is too steep from it
+        bar.emplace_back(addPoint(0, column, 1.0f));
+        for (int ring = 1; std::isfinite(groundRange(ring)); ring++)
+        {
+          const int index = addPoint(ring, column, groundRange(ring));
+          if (ring >= 2)
+          {
+            behind_bar.emplace_back(index);
+          }
+        }
+      }
+    }
+  }
+};
+
+TEST_F(TestRangeGroundFilterAcrossColumns, SpreadsToNeighbouringColumns)
+{
+  buildScan([this](int column) { addGround(column); });
+
+  const std::vector<int> nonground = occupied();
+  for (int index : bar)
+  {
+    EXPECT_TRUE(contains(nonground, index)) << "bar point " << index;
+  }
+  for (int index : behind_bar)
+  {
+    EXPECT_FALSE(contains(nonground, index)) << "ground point " << index << " behind the bar";
+  }
+}
+
+TEST_F(TestRangeGroundFilterAcrossColumns, DoesNotCrossEmptyColumn)
+{
+  buildScan([](int) {});
+
+  const std::vector<int> nonground = occupied();
+  for (int index : behind_bar)
+  {
+    EXPECT_TRUE(contains(nonground, index)) << "ground point " << index << " behind the bar";
+  }
+}
+
+TEST_F(TestRangeGroundFilterAcrossColumns, DoesNotCrossNaNReturns)
+{
+  buildScan([this](int) {
+    for (int ring = 0; ring < rings; ring++)
+    {
+      gap.emplace_back(addNaN(ring));
+    }
+  });
+
+  const std::vector<int> nonground = occupied();
+  for (int index : behind_bar)
+  {
+    EXPECT_TRUE(contains(nonground, index)) << "ground point " << index << " behind the bar";
+  }
+  // Points without a return are neither ground nor obstacles
+  for (int index : gap)
+  {
+    EXPECT_FALSE(contains(nonground, index)) << "NaN point " << index;
+  }
+}
+
+int main(int argc, char** argv)
+{
+  ros::init(argc, argv, "test_range_ground_filter");
+  testing::InitGoogleTest(&argc, argv);
+
+  int ret = RUN_ALL_TESTS();
+  ros::shutdown();
+  return ret;
+}
@@ -0,0 +1,178 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <limits>
+#include <random>
+
+#include "../slope_filter/slope_filter.h"
+#include "../slope_filter/slope_kernels.h"
+
+namespace
+{
+constexpr float nan_value = std::numeric_limits<float>::quiet_NaN();
+
+::testing::AssertionResult sameCells(const Eigen::ArrayXXf& actual, const Eigen::ArrayXXf& expected)
+{
+  if (actual.rows() != expected.rows() || actual.cols() != expected.cols())
+  {
+    return ::testing::AssertionFailure() << "size " << actual.rows() << " x " << actual.cols() << " instead of "
+                                         << expected.rows() << " x " << expected.cols();
+  }
+  for (Eigen::Index row = 0; row < actual.rows(); row++)
+  {
+    for (Eigen::Index col = 0; col < actual.cols(); col++)
+    {
+      const float a = actual(row, col);
+      const float e = expected(row, col);
+      if (std::isnan(a) != std::isnan(e) || (!std::isnan(e) && std::abs(a - e) > 1e-5f))
+      {
+        return ::testing::AssertionFailure() << "cell (" << row << ", " << col << ") is " << a << " instead of " << e;
+      }
+    }
+  }
+  return ::testing::AssertionSuccess();
+}
+}  // namespace
+
+TEST(TestSlopeKernels, MeanOfFinitesSkipsNaNAndClipsToBlock)
+{
+  Eigen::ArrayXXf values(3, 3);
+  values << 1, 2, 3, 4, nan_value, 6, 7, 8, 9;
+
+  Eigen::ArrayXXf expected(3, 3);
+  expected << 7.0f / 3, 16.0f / 5, 11.0f / 3, 22.0f / 5, 5, 28.0f / 5, 19.0f / 3, 34.0f / 5, 23.0f / 3;
+  EXPECT_TRUE(sameCells(slope_kernels::meanOfFinites(values, 1), expected));
+
+  EXPECT_TRUE(sameCells(slope_kernels::meanOfFinites(values, 0), values));
+  EXPECT_TRUE(sameCells(slope_kernels::meanOfFinites(values, 5), Eigen::ArrayXXf::Constant(3, 3, 5)));
+}
+
+TEST(TestSlopeKernels, MeanOfFinitesIsNaNWithoutFiniteCells)
+{
+  Eigen::ArrayXXf values = Eigen::ArrayXXf::Constant(4, 5, nan_value);
+  values(3, 4) = 2;
+
+  Eigen::ArrayXXf expected = Eigen::ArrayXXf::Constant(4, 5, nan_value);
+  expected.bottomRightCorner(2, 2) = 2;
+  EXPECT_TRUE(sameCells(slope_kernels::meanOfFinites(values, 1), expected));
+}
+
+TEST(TestSlopeKernels, SlopeOfPlane)
+{
+  const float resolution = 0.5f;
+  Eigen::ArrayXXf heights(5, 4);
+  for (Eigen::Index row = 0; row < heights.rows(); row++)
+  {
+    for (Eigen::Index col = 0; col < heights.cols(); col++)
+    {
+      heights(row, col) = 0.1f * row - 0.2f * col;
+    }
+  }
+
+  // Gradients of 0.2 and -0.4 per meter, and NaN on the edges
+  Eigen::ArrayXXf expected = Eigen::ArrayXXf::Constant(5, 4, nan_value);
+  expected.block(1, 1, 3, 2) = std::atan(std::sqrt(0.2f * 0.2f + 0.4f * 0.4f));
+  EXPECT_TRUE(sameCells(slope_kernels::slope(heights, resolution), expected));
+}
+
+TEST(TestSlopeKernels, SlopeIsNaNNextToNaN)
+{
+  Eigen::ArrayXXf heights = Eigen::ArrayXXf::Zero(5, 5);
+  heights(2, 2) = nan_value;
+
+  // The stencil only reads the four neighbours of a cell
+  Eigen::ArrayXXf expected = Eigen::ArrayXXf::Constant(5, 5, nan_value);
+  expected.block(1, 1, 3, 3) = 0;
+  expected(1, 2) = nan_value;
+  expected(3, 2) = nan_value;
+  expected(2, 1) = nan_value;
+  expected(2, 3) = nan_value;
+  EXPECT_TRUE(sameCells(slope_kernels::slope(heights, 0.1f), expected));
+
+  EXPECT_TRUE(
+      sameCells(slope_kernels::slope(Eigen::ArrayXXf::Zero(2, 5), 0.1f), Eigen::ArrayXXf::Constant(2, 5, nan_value)));
+}
+
+class TestSlopeSubmap : public testing::TestWithParam<int>
+{
+protected:
+  grid_map::GridMap map;
+
+  void SetUp() override
+  {
+    std::mt19937 random{ 5 };
+    std::uniform_real_distribution<float> noise{ -0.02f, 0.02f };
+    std::uniform_real_distribution<float> unit{ 0.0f, 1.0f };
+
+    map.setGeometry(grid_map::Length{ 2.3, 1.9 }, 0.1, grid_map::Position{ 1.0, -2.0 });
+    const grid_map::Size size = map.getSize();
+    grid_map::Matrix elevation(size(0), size(1));
+    grid_map::Matrix variance(size(0), size(1));
+    for (Eigen::Index row = 0; row < size(0); row++)
+    {
+      for (Eigen::Index col = 0; col < size(1); col++)
+      {
+        const float height = 0.03f * row + 0.1f * std::sin(0.5f * col) + noise(random);
+        elevation(row, col) = unit(random) < 0.15f ? nan_value : height;
+        variance(row, col) = unit(random);
+      }
+    }
+    // Unobserved cells along an edge and in a corner
+    elevation.block(0, 3, 1, 6).setConstant(nan_value);
+    elevation.bottomRightCorner(3, 3).setConstant(nan_value);
+    map.add("elevation", elevation);
+    map.add("variance", variance);
+  }
+};
+
+TEST_P(TestSlopeSubmap, MatchesFullMap)
+{
+  const int window_size = GetParam();
+  const grid_map::GridMap full =
+      computeSlopeSubmap(map, "elevation", window_size, grid_map::Index{ 0, 0 }, map.getSize());
+  const grid_map::Size map_size = map.getSize();
+
+  const std::vector<std::pair<grid_map::Index, grid_map::Size>> regions = {
+    { { 0, 0 }, { 1, 1 } },                          // Corner
+    { map_size - 1, { 1, 1 } },                      // Opposite corner, which is NaN
+    { { 0, 2 }, { 2, 8 } },                          // Along the NaN edge
+    { { 8, 7 }, { 4, 5 } },                          // Interior
+    { { 0, 10 }, { map_size(0), 2 } },               // Across the whole map
+    { { map_size(0) - 3, 0 }, { 3, map_size(1) } },  // Along the last rows
+  };
+  for (const auto& region : regions)
+  {
+    const grid_map::Index& start = region.first;
+    const grid_map::Size& size = region.second;
+    SCOPED_TRACE(::testing::Message() << "region at (" << start(0) << ", " << start(1) << ") of " << size(0) << " x "
+                                      << size(1));
+
+    const grid_map::GridMap submap = computeSlopeSubmap(map, "elevation", window_size, start, size);
+    ASSERT_EQ(submap.getSize()(0), size(0));
+    ASSERT_EQ(submap.getSize()(1), size(1));
+    EXPECT_DOUBLE_EQ(submap.getResolution(), map.getResolution());
+
+    // Its cells line up with those of the map
+    grid_map::Position submap_corner;
+    grid_map::Position map_corner;
+    submap.getPosition(grid_map::Index{ 0, 0 }, submap_corner);
+    map.getPosition(start, map_corner);
+    EXPECT_TRUE(submap_corner.isApprox(map_corner, 1e-9)) << submap_corner.transpose() << " vs "
+                                                           << map_corner.transpose();
+
+    for (const char* layer : { "elevation", "elevation_smooth", "slope", "roughness", "variance" })
+    {
+      EXPECT_TRUE(sameCells(submap.get(layer).array(),
+                            full.get(layer).block(start(0), start(1), size(0), size(1)).array()))
+          << "layer " << layer;
+    }
+  }
+}
+
+INSTANTIATE_TEST_CASE_P(WindowSizes, TestSlopeSubmap, testing::Values(1, 3, 5, 7));
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
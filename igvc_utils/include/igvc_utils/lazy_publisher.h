@@ -0,0 +1,61 @@
+#ifndef LAZY_PUBLISHER_H
+#define LAZY_PUBLISHER_H
+
+#include <ros/ros.h>
+
+namespace igvc
+{
+/**
+ * Publisher for debug and visualization outputs that only builds its message when somebody is subscribed.
+ *
+ * The message is passed as a callable instead of a value, so that the work of building it is skipped entirely when
+ * nobody is listening:
+ *
+ *     marker_pub_.publish([&] { return buildMarkers(); });
+ */
+template <typename M>
+class LazyPublisher
+{
+public:
+  LazyPublisher() = default;
+  LazyPublisher(ros::NodeHandle& nh, const std::string& topic, uint32_t queue_size, bool latch = false)
+    : publisher_{ nh.advertise<M>(topic, queue_size, latch) }
+  {
+  }
+
+  /**
+   * True if the topic has at least one subscriber. For callers that build the message as a side effect of other
+   * work, and so can't hand it over as a callable.
+   */
+  bool hasSubscribers() const
+  {
+    return publisher_ && publisher_.getNumSubscribers() > 0;
+  }
+
+  /**
+   * Calls make_message and publishes its result if the topic has a subscriber. make_message may return either an M
+   * or a shared pointer to one. Pointers are passed to subscribers in the same process without a copy.
+   * @return true if the message was built and published
+   */
+  template <typename MessageFactory>
+  bool publish(MessageFactory&& make_message) const
+  {
+    if (!hasSubscribers())
+    {
+      return false;
+    }
+    publisher_.publish(make_message());
+    return true;
+  }
+
+  const ros::Publisher& publisher() const
+  {
+    return publisher_;
+  }
+
+private:
+  ros::Publisher publisher_;
+};
+}  // namespace igvc
+
+#endif  // LAZY_PUBLISHER_H
@@ -0,0 +1,67 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace igvc
+{
+/**
+ * Fixed set of worker threads for data parallel loops inside a callback.
+ *
+ * parallelFor hands out the items of a loop to the workers and to the calling thread, and returns once every item is
+ * done. Items are claimed one at a time, so results that need a deterministic order should be written to per item
+ * storage and combined by the caller afterwards.
+ */
+class ThreadPool
+{
+public:
+  /**
+   * @param num_threads total number of threads running a loop, including the calling thread. 0 uses one per core.
+   */
+  explicit ThreadPool(size_t num_threads = 0);
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  /**
+   * Number of threads that run a loop, including the calling thread
+   */
+  size_t size() const
+  {
+    return workers_.size() + 1;
+  }
+
+  /**
+   * Calls function(i) for every i in [0, count) across the pool, and returns once all calls have returned.
+   * function must not throw, and parallelFor must not be called from more than one thread at a time.
+   */
+  void parallelFor(size_t count, const std::function<void(size_t)>& function);
+
+private:
+  std::vector<std::thread> workers_;
+
+  std::mutex mutex_;
+  std::condition_variable work_cv_;
+  std::condition_variable done_cv_;
+
+  // The current loop, written under mutex_ before generation_ is bumped
+  const std::function<void(size_t)>* function_ = nullptr;
+  size_t count_ = 0;
+  std::atomic<size_t> next_{ 0 };
+
+  uint64_t generation_ = 0;
+  size_t busy_workers_ = 0;
+  bool stopping_ = false;
+
+  void workerLoop();
+  void runItems();
+};
+}  // namespace igvc
+
+#endif  // THREAD_POOL_H
@@ -0,0 +1,122 @@
+#ifndef TRANSFORM_CACHE_H
+#define TRANSFORM_CACHE_H
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+#include <geometry_msgs/TransformStamped.h>
+#include <nav_msgs/Odometry.h>
+#include <ros/ros.h>
+#include <tf2_ros/buffer.h>
+#include <Eigen/Geometry>
+
+namespace igvc
+{
+/**
+ * Answers transform lookups for sensor callbacks without walking the tf tree on every message.
+ *
+ * Sensor extrinsics (transforms to or from base_frame) are rigid, so they are looked up from the tf2 buffer once and
+ * cached. Only chains made of static transforms (/tf_static) are cached, so that eg. base_frame -> map keeps being
+ * looked up from the tf2 buffer. The fixed_frame -> base_frame pose is kept in a small lock-free ring filled from
+ * odometry, and lookups into fixed_frame interpolate the ring and compose it with the cached extrinsic. Lookups the
+ * cache can't answer fall back to the tf2 buffer.
+ *
+ * Parameters are read from the transform_cache namespace of the passed in NodeHandle:
+ *  - fixed_frame (default "odom")
+ *  - base_frame (default "base_footprint"). Must be the child frame of the odometry
+ *  - odometry_topic (default "/odometry/filtered"). Leave empty to only cache static transforms
+ *  - capacity (default 128) number of poses kept in the ring
+ */
+class TransformCache
+{
+public:
+  TransformCache(tf2_ros::Buffer* buffer, const ros::NodeHandle& nh);
+
+  /**
+   * Returns the transform from source_frame to target_frame at stamp
+   * @param target_frame frame to transform into
+   * @param source_frame frame to transform from
+   * @param stamp time of the transform
+   * @param timeout timeout for the tf2 buffer fallback
+   * @return the transform, or std::nullopt if it can't be found even at the latest time
+   */
+  std::optional<geometry_msgs::TransformStamped> lookupTransform(const std::string& target_frame,
+                                                                 const std::string& source_frame,
+                                                                 const ros::Time& stamp,
+                                                                 const ros::Duration& timeout);
+
+  /**
+   * Returns the cached transform from source_frame to target_frame, looking it up once if it isn't cached yet.
+   * @return the transform, or std::nullopt if it isn't available yet or isn't made of static transforms only
+   */
+  std::optional<Eigen::Isometry3d> lookupStatic(const std::string& target_frame, const std::string& source_frame);
+
+  /**
+   * Adds a fixed_frame -> base_frame pose to the ring. Must only be called from one thread at a time.
+   */
+  void addPose(const ros::Time& stamp, const Eigen::Isometry3d& pose);
+
+  /**
+   * Returns the fixed_frame -> base_frame pose at stamp, interpolated from the ring
+   * @return the pose, or std::nullopt if stamp is outside of the poses in the ring
+   */
+  std::optional<Eigen::Isometry3d> interpolatePose(const ros::Time& stamp) const;
+
+  const std::string& fixedFrame() const
+  {
+    return fixed_frame_;
+  }
+
+  const std::string& baseFrame() const
+  {
+    return base_frame_;
+  }
+
+private:
+  // std::nullopt marks a pair of frames whose transform isn't static, so that it isn't looked up again
+  using StaticMap = std::unordered_map<std::string, std::optional<Eigen::Isometry3d>>;
+
+  struct Pose
+  {
+    double stamp;
+    Eigen::Vector3d translation;
+    Eigen::Quaterniond rotation;
+  };
+
+  /**
+   * One entry of the ring, guarded by a sequence lock so that readers never block the odometry callback
+   */
+  struct Slot
+  {
+    std::atomic<uint64_t> sequence{ 0 };
+    std::array<std::atomic<double>, 8> values{};
+  };
+
+  tf2_ros::Buffer* buffer_;
+  std::string fixed_frame_;
+  std::string base_frame_;
+
+  // Readers load the map without locking. Writers copy it, add to the copy and swap it in under static_mutex_
+  std::shared_ptr<const StaticMap> static_transforms_;
+  std::mutex static_mutex_;
+
+  std::vector<Slot> ring_;
+  std::atomic<uint64_t> head_{ 0 };
+
+  ros::Subscriber odometry_sub_;
+  bool odometry_checked_ = false;
+
+  void odometryCallback(const nav_msgs::OdometryConstPtr& odometry);
+
+  bool readSlot(uint64_t index, Pose& pose) const;
+
+  static std::string staticKey(const std::string& target_frame, const std::string& source_frame);
+};
+}  // namespace igvc
+
+#endif  // TRANSFORM_CACHE_H
@@ -0,0 +1,93 @@
+#include <igvc_utils/thread_pool.h>
+
+namespace igvc
+{
+ThreadPool::ThreadPool(size_t num_threads)
+{
+  if (num_threads == 0)
+  {
+    num_threads = std::max(std::thread::hardware_concurrency(), 1u);
+  }
+
+  // The calling thread also runs items, so it counts as one of the threads
+  workers_.reserve(num_threads - 1);
+  for (size_t i = 1; i < num_threads; i++)
+  {
+    workers_.emplace_back(&ThreadPool::workerLoop, this);
+  }
+}
+
+ThreadPool::~ThreadPool()
+{
+  {
+    std::lock_guard<std::mutex> lock{ mutex_ };
+    stopping_ = true;
+  }
+  work_cv_.notify_all();
+  for (std::thread& worker : workers_)
+  {
+    worker.join();
+  }
+}
+
+void ThreadPool::parallelFor(size_t count, const std::function<void(size_t)>& function)
+{
+  if (workers_.empty() || count <= 1)
+  {
+    for (size_t i = 0; i < count; i++)
+    {
+      function(i);
+    }
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock{ mutex_ };
+    function_ = &function;
+    count_ = count;
+    next_ = 0;
+    busy_workers_ = workers_.size();
+    generation_++;
+  }
+  work_cv_.notify_all();
+
+  runItems();
+
+  std::unique_lock<std::mutex> lock{ mutex_ };
+  done_cv_.wait(lock, [this] { return busy_workers_ == 0; });
+  function_ = nullptr;
+}
+
+void ThreadPool::workerLoop()
+{
+  uint64_t seen_generation = 0;
+  while (true)
+  {
+    {
+      std::unique_lock<std::mutex> lock{ mutex_ };
+      work_cv_.wait(lock, [&] { return stopping_ || generation_ != seen_generation; });
+      if (stopping_)
+      {
+        return;
+      }
+      seen_generation = generation_;
+    }
+
+    runItems();
+
+    std::lock_guard<std::mutex> lock{ mutex_ };
+    if (--busy_workers_ == 0)
+    {
+      done_cv_.notify_one();
+    }
+  }
+}
+
+void ThreadPool::runItems()
+{
+  for (size_t i = next_++; i < count_; i = next_++)
+  {
+    (*function_)(i);
+  }
+}
+}  // namespace igvc
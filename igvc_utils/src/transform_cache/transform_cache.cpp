@@ -0,0 +1,276 @@
+#include <igvc_utils/transform_cache.h>
+
+#include <parameter_assertions/assertions.h>
+#include <tf2_eigen/tf2_eigen.h>
+
+namespace igvc
+{
+namespace
+{
+size_t roundUpToPowerOfTwo(size_t value)
+{
+  size_t power = 1;
+  while (power < value)
+  {
+    power <<= 1;
+  }
+  return power;
+}
+}  // namespace
+
+TransformCache::TransformCache(tf2_ros::Buffer* buffer, const ros::NodeHandle& nh)
+  : buffer_{ buffer }, static_transforms_{ std::make_shared<const StaticMap>() }
+{
+  ros::NodeHandle cache_nh{ nh, "transform_cache" };
+
+  fixed_frame_ = assertions::param(cache_nh, "fixed_frame", std::string("odom"));
+  base_frame_ = assertions::param(cache_nh, "base_frame", std::string("base_footprint"));
+  std::string odometry_topic = assertions::param(cache_nh, "odometry_topic", std::string("/odometry/filtered"));
+  int capacity = assertions::param(cache_nh, "capacity", 128);
+
+  // Power of two so that ring indices can be masked
+  ring_ = std::vector<Slot>(roundUpToPowerOfTwo(static_cast<size_t>(std::max(capacity, 2))));
+
+  if (!odometry_topic.empty())
+  {
+    ros::NodeHandle public_nh{ nh };
+    odometry_sub_ = public_nh.subscribe(odometry_topic, 10, &TransformCache::odometryCallback, this);
+  }
+}
+
+std::optional<geometry_msgs::TransformStamped> TransformCache::lookupTransform(const std::string& target_frame,
+                                                                               const std::string& source_frame,
+                                                                               const ros::Time& stamp,
+                                                                               const ros::Duration& timeout)
+{
+  std::optional<Eigen::Isometry3d> transform;
+  if (target_frame == fixed_frame_)
+  {
+    std::optional<Eigen::Isometry3d> pose = interpolatePose(stamp);
+    if (pose)
+    {
+      std::optional<Eigen::Isometry3d> extrinsic =
+          source_frame == base_frame_ ? std::optional<Eigen::Isometry3d>{ Eigen::Isometry3d::Identity() } :
+                                        lookupStatic(base_frame_, source_frame);
+      if (extrinsic)
+      {
+        transform = (*pose) * (*extrinsic);
+      }
+    }
+  }
+  else if ((target_frame == base_frame_ || source_frame == base_frame_) && source_frame != fixed_frame_)
+  {
+    // Sensor extrinsic. lookupStatic rejects the frames that aren't rigidly attached to base_frame, eg. map
+    transform = lookupStatic(target_frame, source_frame);
+  }
+
+  if (transform)
+  {
+    geometry_msgs::TransformStamped transform_msg = tf2::eigenToTransform(*transform);
+    transform_msg.header.stamp = stamp;
+    transform_msg.header.frame_id = target_frame;
+    transform_msg.child_frame_id = source_frame;
+    return transform_msg;
+  }
+
+  try
+  {
+    if (buffer_->canTransform(target_frame, source_frame, stamp, timeout))
+    {
+      return buffer_->lookupTransform(target_frame, source_frame, stamp);
+    }
+    ROS_WARN_STREAM_THROTTLE(1.0, "Failed to find transform from frame '" << source_frame << "' to frame '"
+                                                                         << target_frame
+                                                                         << "' within timeout. Using latest "
+                                                                            "transform...");
+    return buffer_->lookupTransform(target_frame, source_frame, ros::Time{ 0 });
+  }
+  catch (const tf2::TransformException& ex)
+  {
+    ROS_WARN_STREAM_THROTTLE(1.0, "Failed to find transform from frame '" << source_frame << "' to frame '"
+                                                                         << target_frame << "': " << ex.what());
+    return std::nullopt;
+  }
+}
+
+std::optional<Eigen::Isometry3d> TransformCache::lookupStatic(const std::string& target_frame,
+                                                              const std::string& source_frame)
+{
+  const std::string key = staticKey(target_frame, source_frame);
+  {
+    std::shared_ptr<const StaticMap> transforms = std::atomic_load(&static_transforms_);
+    auto it = transforms->find(key);
+    if (it != transforms->end())
+    {
+      return it->second;
+    }
+  }
+
+  std::optional<Eigen::Isometry3d> transform;
+  try
+  {
+    const geometry_msgs::TransformStamped transform_msg =
+        buffer_->lookupTransform(target_frame, source_frame, ros::Time{ 0 });
+    // tf2 stamps a chain of static transforms with time 0, and any other chain with the time of its latest data
+    if (transform_msg.header.stamp.isZero())
+    {
+      transform = tf2::transformToEigen(transform_msg);
+    }
+    else
+    {
+      ROS_DEBUG_STREAM("Transform from frame '" << source_frame << "' to frame '" << target_frame
+                                                << "' isn't static. Looking it up from the tf buffer instead.");
+    }
+  }
+  catch (const tf2::TransformException& ex)
+  {
+    ROS_WARN_STREAM_THROTTLE(1.0, "Static transform from frame '" << source_frame << "' to frame '" << target_frame
+                                                                  << "' is not available yet: " << ex.what());
+    return std::nullopt;
+  }
+
+  std::lock_guard<std::mutex> lock(static_mutex_);
+  auto transforms = std::make_shared<StaticMap>(*std::atomic_load(&static_transforms_));
+  transforms->emplace(key, transform);
+  std::atomic_store(&static_transforms_, std::shared_ptr<const StaticMap>{ std::move(transforms) });
+  return transform;
+}
+
+void TransformCache::addPose(const ros::Time& stamp, const Eigen::Isometry3d& pose)
+{
+  const uint64_t head = head_.load(std::memory_order_relaxed);
+  Slot& slot = ring_[head & (ring_.size() - 1)];
+
+  const Eigen::Vector3d translation = pose.translation();
+  const Eigen::Quaterniond rotation{ pose.rotation() };
+  const std::array<double, 8> values{ stamp.toSec(),  translation.x(), translation.y(), translation.z(),
+                                      rotation.x(), rotation.y(),    rotation.z(),    rotation.w() };
+
+  // Odd sequence numbers mark the slot as being written
+  const uint64_t sequence = slot.sequence.load(std::memory_order_relaxed);
+  slot.sequence.store(sequence + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  for (size_t i = 0; i < values.size(); i++)
+  {
+    slot.values[i].store(values[i], std::memory_order_relaxed);
+  }
+  slot.sequence.store(sequence + 2, std::memory_order_release);
+
+  head_.store(head + 1, std::memory_order_release);
+}
+
+bool TransformCache::readSlot(uint64_t index, Pose& pose) const
+{
+  const Slot& slot = ring_[index & (ring_.size() - 1)];
+
+  constexpr int max_attempts = 4;
+  for (int attempt = 0; attempt < max_attempts; attempt++)
+  {
+    const uint64_t before = slot.sequence.load(std::memory_order_acquire);
+    if (before % 2 == 1)
+    {
+      continue;
+    }
+
+    std::array<double, 8> values{};
+    for (size_t i = 0; i < values.size(); i++)
+    {
+      values[i] = slot.values[i].load(std::memory_order_relaxed);
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+
+    if (slot.sequence.load(std::memory_order_relaxed) == before)
+    {
+      pose.stamp = values[0];
+      pose.translation = { values[1], values[2], values[3] };
+      pose.rotation = Eigen::Quaterniond{ values[7], values[4], values[5], values[6] };
+      return true;
+    }
+  }
+  return false;
+}
+
+std::optional<Eigen::Isometry3d> TransformCache::interpolatePose(const ros::Time& stamp) const
+{
+  const uint64_t head = head_.load(std::memory_order_acquire);
+  if (head == 0)
+  {
+    return std::nullopt;
+  }
+
+  // Leave one slot of slack, since the writer may be overwriting the oldest entry
+  const uint64_t count = std::min<uint64_t>(head, ring_.size() - 1);
+  const double time = stamp.toSec();
+
+  Pose newer;
+  if (!readSlot(head - 1, newer) || time > newer.stamp)
+  {
+    return std::nullopt;
+  }
+
+  for (uint64_t i = 2; i <= count; i++)
+  {
+    Pose older;
+    // A newer stamp means the slot was overwritten while searching
+    if (!readSlot(head - i, older) || older.stamp > newer.stamp)
+    {
+      return std::nullopt;
+    }
+
+    if (older.stamp <= time)
+    {
+      const double span = newer.stamp - older.stamp;
+      const double ratio = span > 0.0 ? (time - older.stamp) / span : 0.0;
+
+      Eigen::Isometry3d pose = Eigen::Isometry3d::Identity();
+      pose.translate(older.translation + ratio * (newer.translation - older.translation));
+      pose.rotate(older.rotation.slerp(ratio, newer.rotation));
+      return pose;
+    }
+    newer = older;
+  }
+
+  if (newer.stamp == time)
+  {
+    Eigen::Isometry3d pose = Eigen::Isometry3d::Identity();
+    pose.translate(newer.translation);
+    pose.rotate(newer.rotation);
+    return pose;
+  }
+  return std::nullopt;
+}
+
+void TransformCache::odometryCallback(const nav_msgs::OdometryConstPtr& odometry)
+{
+  const bool frames_match = odometry->header.frame_id == fixed_frame_ && odometry->child_frame_id == base_frame_;
+  if (!odometry_checked_)
+  {
+    odometry_checked_ = true;
+    if (!frames_match)
+    {
+      ROS_ERROR_STREAM("TransformCache expects odometry from '"
+                       << fixed_frame_ << "' to '" << base_frame_ << "', but it is from '" << odometry->header.frame_id
+                       << "' to '" << odometry->child_frame_id
+                       << "'. Set transform_cache/fixed_frame and transform_cache/base_frame to match, otherwise "
+                          "every lookup falls back to the tf buffer.");
+    }
+  }
+  if (!frames_match)
+  {
+    ROS_WARN_STREAM_THROTTLE(5.0, "Odometry is from frame '" << odometry->header.frame_id << "' to frame '"
+                                                             << odometry->child_frame_id << "', but expected '"
+                                                             << fixed_frame_ << "' to '" << base_frame_
+                                                             << "'. Ignoring.");
+    return;
+  }
+
+  Eigen::Isometry3d pose;
+  tf2::fromMsg(odometry->pose.pose, pose);
+  addPose(odometry->header.stamp, pose);
+}
+
+std::string TransformCache::staticKey(const std::string& target_frame, const std::string& source_frame)
+{
+  return target_frame + '|' + source_frame;
+}
+}  // namespace igvc